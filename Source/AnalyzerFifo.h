@@ -0,0 +1,75 @@
+#pragma once
+#include <JuceHeader.h>
+#include <algorithm>
+#include <vector>
+
+// ===== Analyzer FIFO =====
+// Mono samples from the audio thread to the analyzer: single producer, single consumer
+// over juce::AbstractFifo, so both ends are wait-free and lock-free, and the storage is
+// allocated up front. A block that doesn't fit is dropped whole rather than waited for,
+// leaving a gap instead of a glitch when the reader falls behind.
+class AnalyzerFifo
+{
+public:
+    static constexpr int capacity = 1 << 15; // about 0.7 s at 48 kHz
+
+    AnalyzerFifo() : fifo (capacity), samples ((size_t) capacity, 0.0f) {}
+
+    // Audio thread. Writes the average of the first numChannels channels.
+    template <typename SampleType>
+    void push (const juce::AudioBuffer<SampleType>& buffer, int numChannels, int numSamples) noexcept
+    {
+        if (numSamples <= 0 || fifo.getFreeSpace() < numSamples)
+            return;
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (numSamples, start1, size1, start2, size2);
+
+        const float gain = 1.0f / (float) numChannels;
+        mixDown (buffer, numChannels, 0, samples.data() + start1, size1, gain);
+        mixDown (buffer, numChannels, size1, samples.data() + start2, size2, gain);
+
+        fifo.finishedWrite (size1 + size2);
+    }
+
+    // Reader. Copies up to maxSamples of the oldest samples into dest; returns how many.
+    int pull (float* dest, int maxSamples) noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (maxSamples, start1, size1, start2, size2);
+
+        std::copy_n (samples.data() + start1, size1, dest);
+        std::copy_n (samples.data() + start2, size2, dest + size1);
+
+        fifo.finishedRead (size1 + size2);
+        return size1 + size2;
+    }
+
+    int getNumReady() const noexcept { return fifo.getNumReady(); }
+
+private:
+    juce::AbstractFifo fifo;
+    std::vector<float> samples;
+
+    template <typename SampleType>
+    static void mixDown (const juce::AudioBuffer<SampleType>& buffer, int numChannels, int offset,
+                         float* dest, int numSamples, float gain) noexcept
+    {
+        if (numSamples <= 0)
+            return;
+
+        const auto* first = buffer.getReadPointer (0, offset);
+        for (int i = 0; i < numSamples; ++i)
+            dest[i] = (float) first[i];
+
+        for (int ch = 1; ch < numChannels; ++ch)
+        {
+            const auto* x = buffer.getReadPointer (ch, offset);
+            for (int i = 0; i < numSamples; ++i)
+                dest[i] += (float) x[i];
+        }
+
+        if (numChannels > 1)
+            juce::FloatVectorOperations::multiply (dest, gain, numSamples);
+    }
+};
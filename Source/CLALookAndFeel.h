@@ -1,5 +1,34 @@
 #pragma once
 #include <JuceHeader.h>
+#include <map>
+#include <tuple>
+#include <vector>
+
+// ===== Knob filmstrips =====
+// One strip per knob size in physical pixels (and angle range), with a frame per pixel of
+// travel along the value arc, so stepping between frames is invisible. Frames are drawn
+// the first time they are shown and kept; every editor in the process shares the cache
+// through a SharedResourcePointer. Message thread only.
+class KnobCache
+{
+public:
+    const juce::Image& getFrame (float width, float height, float scale,
+                                 float startAngle, float endAngle, float proportion);
+
+private:
+    struct Key
+    {
+        int width, height;
+        float startAngle, endAngle;
+
+        bool operator< (const Key& o) const noexcept
+        {
+            return std::tie (width, height, startAngle, endAngle) < std::tie (o.width, o.height, o.startAngle, o.endAngle);
+        }
+    };
+
+    std::map<Key, std::vector<juce::Image>> strips;
+};
 
 class CLALookAndFeel : public juce::LookAndFeel_V4
 {
@@ -15,14 +44,32 @@ public:
         setColour (juce::ComboBox::textColourId, juce::Colours::white.withAlpha (0.9f));
     }
 
+    // Knob faces come from filmstrips shared by every editor (see KnobCache); the plain
+    // path is kept for comparison in the paint benchmark.
+    void setKnobCaching (bool shouldCache) noexcept { cacheKnobs = shouldCache; }
+
     void drawRotarySlider (juce::Graphics& g, int x, int y, int w, int h,
                            float sliderPosProportional, float rotaryStartAngle, float rotaryEndAngle,
                            juce::Slider&) override
     {
         auto bounds = juce::Rectangle<float>((float)x, (float)y, (float)w, (float)h).reduced (6.0f);
+
+        if (! cacheKnobs || bounds.isEmpty())
+        {
+            drawKnob (g, bounds, rotaryStartAngle + sliderPosProportional * (rotaryEndAngle - rotaryStartAngle), rotaryStartAngle);
+            return;
+        }
+
+        const auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+        g.drawImage (knobCache->getFrame (bounds.getWidth(), bounds.getHeight(), scale,
+                                          rotaryStartAngle, rotaryEndAngle, sliderPosProportional),
+                     bounds);
+    }
+
+    static void drawKnob (juce::Graphics& g, juce::Rectangle<float> bounds, float angle, float rotaryStartAngle)
+    {
         auto r = juce::jmin (bounds.getWidth(), bounds.getHeight()) * 0.5f;
         auto centre = bounds.getCentre();
-        auto angle = rotaryStartAngle + sliderPosProportional * (rotaryEndAngle - rotaryStartAngle);
 
         // Base
         g.setColour (juce::Colour (0xFF1B1B1B));
@@ -71,4 +118,37 @@ public:
         g.setFont (juce::Font (14.0f, juce::Font::bold));
         g.drawText (b.getButtonText(), r.toNearestInt(), juce::Justification::centredLeft);
     }
-};
\ No newline at end of file
+
+private:
+    juce::SharedResourcePointer<KnobCache> knobCache;
+    bool cacheKnobs = true;
+};
+
+inline const juce::Image& KnobCache::getFrame (float width, float height, float scale,
+                                               float startAngle, float endAngle, float proportion)
+{
+    const Key key { juce::jmax (1, juce::roundToInt (width * scale)), juce::jmax (1, juce::roundToInt (height * scale)), startAngle, endAngle };
+    auto& strip = strips[key];
+
+    if (strip.empty())
+    {
+        // Arc radius in physical pixels times the sweep: one frame per pixel of travel
+        const auto radius = juce::jmin (key.width, key.height) * 0.5f;
+        strip.resize ((size_t) juce::jlimit (32, 256, juce::roundToInt (radius * std::abs (endAngle - startAngle))));
+    }
+
+    const auto index = (size_t) juce::roundToInt (juce::jlimit (0.0f, 1.0f, proportion) * (float) (strip.size() - 1));
+    auto& frame = strip[index];
+
+    if (frame.isNull())
+    {
+        frame = juce::Image (juce::Image::ARGB, key.width, key.height, true);
+        juce::Graphics g (frame);
+        g.addTransform (juce::AffineTransform::scale ((float) key.width / width, (float) key.height / height));
+
+        const auto angle = startAngle + (float) index / (float) (strip.size() - 1) * (endAngle - startAngle);
+        CLALookAndFeel::drawKnob (g, { width, height }, angle, startAngle);
+    }
+
+    return frame;
+}
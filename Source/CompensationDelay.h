@@ -0,0 +1,94 @@
+#pragma once
+#include <JuceHeader.h>
+#include <algorithm>
+#include <vector>
+
+// ===== Latency compensation =====
+// Whole-sample delay applied in place, used to keep dry paths aligned with stages that
+// add latency. One power-of-two ring per channel; nothing is allocated after prepare().
+template <typename SampleType>
+class CompensationDelay
+{
+public:
+    void prepare (int numChannels, int maxDelaySamples)
+    {
+        const auto size = (size_t) juce::nextPowerOfTwo (juce::jmax (1, maxDelaySamples) + 1);
+
+        mask = size - 1;
+        rings.assign ((size_t) juce::jmax (1, numChannels), std::vector<SampleType> (size, (SampleType) 0));
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        for (auto& r : rings)
+            std::fill (r.begin(), r.end(), (SampleType) 0);
+
+        writePos = 0;
+    }
+
+    void setDelay (int samples) noexcept
+    {
+        jassert (samples >= 0 && (size_t) samples <= mask);
+        delay = (size_t) juce::jlimit (0, (int) mask, samples);
+    }
+
+    int getDelay() const noexcept { return (int) delay; }
+
+    // Copies one channel's history over another's (same size, so nothing is allocated).
+    void copyChannel (int source, int dest) noexcept
+    {
+        if (juce::jmax (source, dest) < (int) rings.size())
+            std::copy (rings[(size_t) source].begin(), rings[(size_t) source].end(), rings[(size_t) dest].begin());
+    }
+
+    template <typename Block>
+    void process (Block& block) noexcept
+    {
+        const auto numSamples = block.getNumSamples();
+
+        if (delay == 0)
+            return;
+
+        for (size_t ch = 0; ch < juce::jmin (block.getNumChannels(), rings.size()); ++ch)
+        {
+            auto* x = block.getChannelPointer (ch);
+            auto* ring = rings[ch].data();
+            auto w = writePos;
+
+            for (size_t i = 0; i < numSamples; ++i, ++w)
+            {
+                ring[w & mask] = x[i];
+                x[i] = ring[(w - delay) & mask];
+            }
+        }
+
+        writePos = (writePos + numSamples) & mask;
+    }
+
+    // Keeps the history current while the delayed signal itself isn't needed, so that it
+    // comes back without a stale first `delay` samples. Only the last `delay` samples of
+    // the block can ever be read back, so only those are written.
+    void feed (const SampleType* const* channels, size_t numChannels, size_t numSamples) noexcept
+    {
+        if (delay == 0)
+            return;
+
+        const auto skip = numSamples > delay ? numSamples - delay : 0;
+
+        for (size_t ch = 0; ch < juce::jmin (numChannels, rings.size()); ++ch)
+        {
+            const auto* x = channels[ch];
+            auto* ring = rings[ch].data();
+
+            for (size_t i = skip; i < numSamples; ++i)
+                ring[(writePos + i) & mask] = x[i];
+        }
+
+        writePos = (writePos + numSamples) & mask;
+    }
+
+private:
+    std::vector<std::vector<SampleType>> rings;
+    size_t mask = 0, writePos = 0, delay = 0;
+};
@@ -0,0 +1,815 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
+
+// ===== Uniform partitioned convolver =====
+// Overlap-save convolution of one channel with one IR segment cut into partitions of
+// blockSize samples. Input spectra go through a frequency-domain delay line, so a block
+// costs one forward FFT, one inverse FFT and a complex multiply-add per partition.
+// Spectra are kept split (re / im arrays) so that multiply-add is four flat loops.
+// Allocates only in prepare().
+class PartitionedConvolver
+{
+public:
+    void prepare (int newBlockSize, const float* ir, int irLength)
+    {
+        blockSize = newBlockSize;
+        fftSize = 2 * blockSize;
+        numBins = blockSize + 1;
+        numPartitions = juce::jmax (1, (irLength + blockSize - 1) / blockSize);
+
+        int order = 0;
+        while ((1 << order) < fftSize)
+            ++order;
+
+        fft = std::make_unique<juce::dsp::FFT> (order);
+        fftBuffer.assign ((size_t) (2 * fftSize), 0.0f);
+        input.assign ((size_t) fftSize, 0.0f);
+
+        const auto spectraSize = (size_t) (numPartitions * numBins);
+        irRe.assign (spectraSize, 0.0f);
+        irIm.assign (spectraSize, 0.0f);
+        fdlRe.assign (spectraSize, 0.0f);
+        fdlIm.assign (spectraSize, 0.0f);
+        accRe.assign ((size_t) numBins, 0.0f);
+        accIm.assign ((size_t) numBins, 0.0f);
+
+        for (int p = 0; p < numPartitions; ++p)
+        {
+            std::fill (fftBuffer.begin(), fftBuffer.end(), 0.0f);
+
+            const auto offset = p * blockSize;
+            const auto count = juce::jlimit (0, blockSize, irLength - offset);
+            std::copy (ir + offset, ir + offset + count, fftBuffer.begin());
+
+            fft->performRealOnlyForwardTransform (fftBuffer.data(), true);
+            deinterleave (irRe.data() + p * numBins, irIm.data() + p * numBins);
+        }
+
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        std::fill (input.begin(), input.end(), 0.0f);
+        std::fill (fdlRe.begin(), fdlRe.end(), 0.0f);
+        std::fill (fdlIm.begin(), fdlIm.end(), 0.0f);
+        fdlPos = 0;
+    }
+
+    int getBlockSize() const noexcept { return blockSize; }
+
+    // Consumes blockSize new samples and writes the matching blockSize output samples.
+    // The first partition's direct path is included: the output has no block latency.
+    void process (const float* newSamples, float* output) noexcept
+    {
+        std::copy (input.begin() + blockSize, input.end(), input.begin());
+        std::copy (newSamples, newSamples + blockSize, input.begin() + blockSize);
+
+        std::copy (input.begin(), input.end(), fftBuffer.begin());
+        std::fill (fftBuffer.begin() + fftSize, fftBuffer.end(), 0.0f);
+        fft->performRealOnlyForwardTransform (fftBuffer.data(), true);
+
+        fdlPos = (fdlPos + numPartitions - 1) % numPartitions;
+        deinterleave (fdlRe.data() + fdlPos * numBins, fdlIm.data() + fdlPos * numBins);
+
+        std::fill (accRe.begin(), accRe.end(), 0.0f);
+        std::fill (accIm.begin(), accIm.end(), 0.0f);
+
+        // Partition p meets the input spectrum from p blocks ago
+        for (int p = 0; p < numPartitions; ++p)
+        {
+            const auto slot = (fdlPos + p) % numPartitions;
+            const auto* xr = fdlRe.data() + slot * numBins;
+            const auto* xi = fdlIm.data() + slot * numBins;
+            const auto* hr = irRe.data() + p * numBins;
+            const auto* hi = irIm.data() + p * numBins;
+            auto* ar = accRe.data();
+            auto* ai = accIm.data();
+
+            for (int k = 0; k < numBins; ++k)
+            {
+                ar[k] += xr[k] * hr[k] - xi[k] * hi[k];
+                ai[k] += xr[k] * hi[k] + xi[k] * hr[k];
+            }
+        }
+
+        std::fill (fftBuffer.begin(), fftBuffer.end(), 0.0f);
+        for (int k = 0; k < numBins; ++k)
+        {
+            fftBuffer[(size_t) (2 * k)]     = accRe[(size_t) k];
+            fftBuffer[(size_t) (2 * k + 1)] = accIm[(size_t) k];
+        }
+
+        fft->performRealOnlyInverseTransform (fftBuffer.data());
+
+        // Overlap-save: the second half holds the linear convolution
+        std::copy (fftBuffer.begin() + blockSize, fftBuffer.begin() + fftSize, output);
+    }
+
+private:
+    int blockSize = 0, fftSize = 0, numBins = 0, numPartitions = 0, fdlPos = 0;
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::vector<float> fftBuffer, input; // input: previous block, then the newest one
+    std::vector<float> irRe, irIm, fdlRe, fdlIm, accRe, accIm;
+
+    void deinterleave (float* re, float* im) const noexcept
+    {
+        for (int k = 0; k < numBins; ++k)
+        {
+            re[k] = fftBuffer[(size_t) (2 * k)];
+            im[k] = fftBuffer[(size_t) (2 * k + 1)];
+        }
+    }
+};
+
+// ===== Convolution reverb =====
+// Non-uniformly partitioned convolution with the long tail off the audio thread.
+//
+//   IR [0, 64)          direct-form FIR, sample by sample        audio thread
+//   IR [64, 2048)       64-sample partitions, one FFT pair       audio thread
+//                       each time 64 input samples are complete
+//   IR [2048, end)      1024-sample partitions                   worker thread
+//
+// The head has no latency. A segment that starts at offset D >= 2B with block size B
+// can be computed one block period after its input is complete, which is the worker's
+// slack: each 1024-sample input block is handed over through a ring of slots with two
+// atomic counters (submitted / completed) and its output is read back 1024 samples later.
+// A late worker never blocks the audio thread: that tail block is skipped and counted
+// in getLateBlocks(). Offline (setNonRealtime) the audio thread waits for the worker
+// instead, so a render is complete and the same every time.
+//
+// IRs (a file or, by default, a synthetic room shaped by REV_SIZE / REV_DAMP) are
+// decoded, resampled to the session rate and turned into partition spectra on a loader
+// thread. The finished Instance is published through an atomic pointer; the audio thread
+// claims it at the start of the next block, and old instances are freed off the audio
+// thread once neither the audio thread nor the worker can still be using them; one that
+// was replaced before the audio thread claimed it is freed straight away.
+// A new IR starts from silence: the previous tail is cut, not crossfaded.
+//
+// Any number of bus channels is convolved; each one uses the IR channel given for it in
+// prepare() (the side of its stereo pair on a surround bus), by default channel 0 for
+// the first bus channel and the last IR channel for the rest.
+//
+// Nothing is built and neither the worker nor the loader thread exists until the engine is
+// made active (setActive), and file decoders are set up only to read an IR file, so an
+// instance that never selects convolution costs no memory and no thread.
+class ConvolutionReverb  : private juce::Thread
+{
+public:
+    static constexpr int headSize = 64;
+    static constexpr int tailBlockSize = 1024;
+    static constexpr int earlyEnd = 2 * tailBlockSize; // first tap handled by the worker
+    static constexpr double maxIrSeconds = 10.0;
+
+    ConvolutionReverb()
+        : juce::Thread ("Convolution tail")
+    {
+    }
+
+    ~ConvolutionReverb() override
+    {
+        if (loader != nullptr)
+            loader->removeAllJobs (true, 10000);
+
+        stopThread (2000);
+    }
+
+    // Message thread. Takes the session format and, optionally, the IR channel of each
+    // bus channel; an active engine rebuilds its IR for it here and starts the worker, an
+    // inactive one only stops the worker.
+    void prepare (const juce::dsp::ProcessSpec& spec, bool shouldBeActive, std::vector<int> irChannelOfBusChannel = {})
+    {
+        {
+            const juce::ScopedLock sl (sourceLock);
+            sampleRate = spec.sampleRate;
+            numChannels = (int) juce::jmax (1u, spec.numChannels);
+            irChannels = std::move (irChannelOfBusChannel);
+            ++sourceSerial;
+        }
+
+        // Half a tail block: a job submitted while the worker backs off still has more
+        // than one block of its two-block deadline left
+        idleWaitMs.store (juce::jmax (1, (int) (500.0 * tailBlockSize / spec.sampleRate)), std::memory_order_relaxed);
+
+        prepared = true;
+        enabled.store (shouldBeActive, std::memory_order_release);
+
+        if (shouldBeActive)
+        {
+            buildInstance();
+            startWorker();
+        }
+        else
+        {
+            stopWorker();
+        }
+    }
+
+    // Message thread. Switching on builds the IR on the loader thread and starts the
+    // worker; switching off stops the worker. The instance in use is kept.
+    void setActive (bool shouldBeActive)
+    {
+        if (shouldBeActive == enabled.load (std::memory_order_relaxed) || ! prepared)
+            return;
+
+        enabled.store (shouldBeActive, std::memory_order_release);
+
+        if (shouldBeActive)
+        {
+            startWorker();
+            requestBuild();
+        }
+        else
+        {
+            stopWorker();
+        }
+    }
+
+    // Offline the audio thread waits for late tail blocks instead of skipping them.
+    void setNonRealtime (bool isNonRealtime) noexcept { nonRealtime.store (isNonRealtime, std::memory_order_relaxed); }
+
+    // Audio thread: clears the signal held in the engine, keeps the IR.
+    void reset() noexcept { resetRequested.store (true, std::memory_order_relaxed); }
+
+    // Audio thread safe. Shapes the synthetic room used while no IR file is loaded; an
+    // active engine's worker rebuilds it once the values have stopped moving.
+    void setRoom (float size, float damping) noexcept
+    {
+        const bool sizeMoved = roomSize.exchange (size, std::memory_order_relaxed) != size;
+        const bool dampingMoved = roomDamping.exchange (damping, std::memory_order_relaxed) != damping;
+
+        if (sizeMoved || dampingMoved)
+            roomGeneration.fetch_add (1, std::memory_order_release);
+    }
+
+    // ===== IR loading (message thread) =====
+    // The decoders are only set up for a file actually being read.
+    bool loadImpulseResponse (const juce::File& file)
+    {
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+
+        std::unique_ptr<juce::AudioFormatReader> reader (formats.createReaderFor (file));
+
+        if (reader == nullptr)
+            return false;
+
+        const auto length = (int) juce::jmin ((juce::int64) (maxIrSeconds * reader->sampleRate), reader->lengthInSamples);
+        juce::AudioBuffer<float> ir ((int) juce::jmin (2u, reader->numChannels), length);
+        reader->read (&ir, 0, length, 0, true, ir.getNumChannels() > 1);
+
+        loadImpulseResponse (std::move (ir), reader->sampleRate, file.getFileNameWithoutExtension());
+        return true;
+    }
+
+    void loadImpulseResponse (juce::AudioBuffer<float>&& ir, double irSampleRate, const juce::String& name)
+    {
+        {
+            const juce::ScopedLock sl (sourceLock);
+            source = std::move (ir);
+            sourceRate = irSampleRate;
+            sourceName = name;
+            ++sourceSerial;
+        }
+
+        requestBuild();
+    }
+
+    // Back to the synthetic room.
+    void clearImpulseResponse()
+    {
+        loadImpulseResponse ({}, 0.0, {});
+    }
+
+    juce::String getImpulseResponseName() const
+    {
+        const juce::ScopedLock sl (sourceLock);
+        return sourceName;
+    }
+
+    // Length in samples of the IR the audio thread is running, 0 before the first one.
+    int getCurrentIrLength() const noexcept { return activeLength.load (std::memory_order_relaxed); }
+
+    // Tail blocks the worker did not deliver in time since prepare().
+    int getLateBlocks() const noexcept { return lateBlocks.load (std::memory_order_relaxed); }
+
+    // ===== Audio thread =====
+    template <typename ProcessContext>
+    void process (const ProcessContext& context) noexcept
+    {
+        adoptPendingInstance();
+
+        const auto& inputBlock = context.getInputBlock();
+        auto& outputBlock      = context.getOutputBlock();
+        const auto numSamples  = (int) outputBlock.getNumSamples();
+
+        if (active == nullptr)
+        {
+            outputBlock.clear();
+            return;
+        }
+
+        auto& inst = *active;
+
+        if (resetRequested.exchange (false, std::memory_order_relaxed))
+            clearSignal (inst);
+
+        const auto channels = (int) juce::jmin (outputBlock.getNumChannels(), (size_t) inst.numChannels);
+
+        for (int done = 0; done < numSamples;)
+        {
+            const auto len = juce::jmin (numSamples - done, headSize - inst.headPos);
+
+            for (int ch = 0; ch < channels; ++ch)
+                processHead (inst, ch, inputBlock.getChannelPointer ((size_t) ch) + done,
+                             outputBlock.getChannelPointer ((size_t) ch) + done, len);
+
+            inst.headPos += len;
+            done += len;
+
+            if (inst.headPos == headSize)
+                finishHeadBlock (inst, channels);
+        }
+
+        for (auto ch = (size_t) channels; ch < outputBlock.getNumChannels(); ++ch)
+            juce::FloatVectorOperations::clear (outputBlock.getChannelPointer (ch), numSamples);
+    }
+
+    // Decaying, progressively darker stereo noise: the default IR, same RT60 mapping as
+    // FdnReverb (0.25 s to 8 s).
+    static juce::AudioBuffer<float> makeRoomImpulse (float size, float damping, double rate)
+    {
+        const double rt60 = 0.25 * std::pow (32.0, (double) juce::jlimit (0.0f, 1.0f, size));
+        const auto length = juce::jmax (1, (int) (juce::jmin (rt60 * 1.2, maxIrSeconds) * rate));
+        const auto decay = (float) std::pow (10.0, -3.0 / (rt60 * rate));
+        const auto onset = (float) (0.004 * rate);
+
+        juce::AudioBuffer<float> ir (2, length);
+        juce::Random rng (0x5eed);
+
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            auto* x = ir.getWritePointer (ch);
+            float envelope = 1.0f, lowpass = 0.0f;
+
+            for (int i = 0; i < length; ++i)
+            {
+                const auto noise = rng.nextFloat() * 2.0f - 1.0f;
+                const auto coeff = 0.85f * damping * (float) i / (float) length;
+
+                lowpass = noise + coeff * (lowpass - noise);
+                x[i] = lowpass * envelope * juce::jmin (1.0f, (float) i / onset);
+                envelope *= decay;
+            }
+        }
+
+        return ir;
+    }
+
+private:
+    static constexpr int headsPerTail = tailBlockSize / headSize;
+    static constexpr int numSlots = 8;
+
+    // Everything tied to one IR at one sample rate, built off the audio thread.
+    struct Instance
+    {
+        struct Channel
+        {
+            std::array<float, headSize> headTaps {};    // IR [0, 64), reversed
+            std::array<float, 2 * headSize> history {}; // previous head block, then the current one
+            std::array<float, headSize> earlyOut {};
+            PartitionedConvolver early, tail;
+            std::vector<float> tailIn, tailOut;         // numSlots blocks each
+        };
+
+        juce::int64 id = 0;
+        int numChannels = 1, length = 0;
+        bool hasEarly = false, hasTail = false;
+        std::vector<Channel> channels;
+
+        // Audio thread
+        int headPos = 0;
+        juce::int64 headBlocks = 0;
+        bool tailReady = false, dropping = false;
+
+        // Hand-over with the worker
+        std::atomic<juce::int64> submitted { 0 }, completed { 0 }, resetFromJob { 0 };
+        juce::int64 workerResetJob = 0; // worker only
+
+        float* tailInput  (int ch, juce::int64 job) noexcept { return channels[(size_t) ch].tailIn.data()  + (job % numSlots) * tailBlockSize; }
+        float* tailOutput (int ch, juce::int64 job) noexcept { return channels[(size_t) ch].tailOut.data() + (job % numSlots) * tailBlockSize; }
+    };
+
+    // A JUCE ThreadPool starts its thread as it is constructed: this one is created the
+    // first time the engine is made active, on the message thread, before the worker that
+    // also queues builds on it is running
+    std::unique_ptr<juce::ThreadPool> loader;
+
+    // Source IR and session format, guarded by sourceLock (never taken on the audio thread)
+    juce::CriticalSection sourceLock;
+    juce::AudioBuffer<float> source;
+    double sourceRate = 0.0, sampleRate = 44100.0;
+    juce::String sourceName;
+    int numChannels = 2;
+    std::vector<int> irChannels; // per bus channel; empty: the default mapping
+    juce::int64 sourceSerial = 0; // bumped by every change a build depends on
+
+    // Instance pool: published by the loader, claimed by the audio thread (pending is
+    // swapped to null), freed by collectGarbage() once both real-time users have moved past
+    // it, or by the loader if it was superseded before anyone claimed it.
+    juce::CriticalSection poolLock;
+    std::vector<std::unique_ptr<Instance>> instances;
+    juce::int64 nextId = 0, publishedSerial = 0;
+    std::atomic<Instance*> pending { nullptr }, current { nullptr };
+    std::atomic<juce::int64> audioId { 0 }, workerId { 0 };
+    Instance* active = nullptr; // audio thread's copy of current
+
+    bool prepared = false; // message thread
+    std::atomic<bool> enabled { false }, resetRequested { false }, buildQueued { false }, nonRealtime { false };
+    std::atomic_flag jobsBusy = ATOMIC_FLAG_INIT;
+    std::atomic<float> roomSize { 0.35f }, roomDamping { 0.5f };
+    std::atomic<int> roomGeneration { 0 }, lateBlocks { 0 }, activeLength { 0 }, idleWaitMs { 1 };
+
+    // ===== Audio thread =====
+    void adoptPendingInstance() noexcept
+    {
+        auto* next = pending.exchange (nullptr, std::memory_order_acq_rel);
+
+        if (next == nullptr)
+            return;
+
+        active = next;
+        current.store (next, std::memory_order_release);
+        audioId.store (next->id, std::memory_order_release);
+        activeLength.store (next->length, std::memory_order_relaxed);
+    }
+
+    void processHead (Instance& inst, int ch, const float* in, float* out, int len) noexcept
+    {
+        auto& c = inst.channels[(size_t) ch];
+        const auto pos = inst.headPos;
+
+        // Input first: in and out may be the same buffer
+        std::copy (in, in + len, c.history.data() + headSize + pos);
+
+        std::copy (c.earlyOut.data() + pos, c.earlyOut.data() + pos + len, out);
+
+        if (inst.tailReady)
+        {
+            const auto* tail = inst.tailOutput (ch, inst.submitted.load (std::memory_order_relaxed) - 2)
+                                 + (inst.headBlocks % headsPerTail) * headSize + pos;
+            juce::FloatVectorOperations::add (out, tail, len);
+        }
+
+        // Direct form, tap-major so the inner loop runs across samples and vectorises.
+        // For output i, x[i + k] walks from 63 samples ago up to the current sample.
+        const auto* x = c.history.data() + pos + 1;
+
+        for (int k = 0; k < headSize; ++k)
+        {
+            const auto h = c.headTaps[(size_t) k];
+            const auto* xk = x + k;
+
+            for (int i = 0; i < len; ++i)
+                out[i] += h * xk[i];
+        }
+    }
+
+    void finishHeadBlock (Instance& inst, int channels) noexcept
+    {
+        const auto job = inst.submitted.load (std::memory_order_relaxed);
+        const auto slotOffset = (inst.headBlocks % headsPerTail) * headSize;
+
+        // A slot is reusable once the worker has read it: with eight slots that only
+        // fails if the worker is a whole 170 ms behind
+        if (inst.hasTail && slotOffset == 0)
+        {
+            if (nonRealtime.load (std::memory_order_relaxed))
+                waitForJob (inst, job - numSlots);
+
+            inst.dropping = inst.completed.load (std::memory_order_acquire) <= job - numSlots;
+        }
+
+        for (int ch = 0; ch < channels; ++ch)
+        {
+            auto& c = inst.channels[(size_t) ch];
+            const auto* block = c.history.data() + headSize;
+
+            if (inst.hasEarly)
+                c.early.process (block, c.earlyOut.data());
+
+            if (inst.hasTail && ! inst.dropping)
+                std::copy (block, block + headSize, inst.tailInput (ch, job) + slotOffset);
+
+            std::copy (block, block + headSize, c.history.data());
+        }
+
+        inst.headPos = 0;
+        ++inst.headBlocks;
+
+        if (! inst.hasTail || inst.headBlocks % headsPerTail != 0)
+            return;
+
+        inst.submitted.store (job + 1, std::memory_order_release);
+
+        // The tail block starting now plays the output of job - 1 (segment offset 2B)
+        const auto needed = job - 1;
+        const auto valid = needed >= 0 && needed >= inst.resetFromJob.load (std::memory_order_relaxed);
+
+        if (valid && nonRealtime.load (std::memory_order_relaxed))
+            waitForJob (inst, needed);
+
+        inst.tailReady = valid && inst.completed.load (std::memory_order_acquire) > needed;
+
+        if (valid && (! inst.tailReady || inst.dropping))
+            lateBlocks.fetch_add (1, std::memory_order_relaxed);
+    }
+
+    // Offline only: doesn't return until `job` is done, running jobs here whenever the
+    // worker isn't already on them (or isn't running at all).
+    void waitForJob (Instance& inst, juce::int64 job) noexcept
+    {
+        while (inst.completed.load (std::memory_order_acquire) <= job)
+        {
+            processTailJobs (inst, false);
+
+            if (inst.completed.load (std::memory_order_acquire) <= job)
+                juce::Thread::yield();
+        }
+    }
+
+    // Drops the signal but keeps the block grid, so head and tail stay aligned
+    void clearSignal (Instance& inst) noexcept
+    {
+        const auto job = inst.submitted.load (std::memory_order_relaxed);
+
+        for (auto& c : inst.channels)
+        {
+            c.history.fill (0.0f);
+            c.earlyOut.fill (0.0f);
+            c.early.reset();
+        }
+
+        if (inst.hasTail && ! inst.dropping)
+            for (int ch = 0; ch < inst.numChannels; ++ch)
+                juce::FloatVectorOperations::clear (inst.tailInput (ch, job), tailBlockSize);
+
+        // The worker restarts its tail state at this job; outputs of older jobs are ignored
+        inst.resetFromJob.store (job, std::memory_order_release);
+        inst.tailReady = false;
+        inst.headPos = 0;
+    }
+
+    // ===== Worker thread =====
+    void run() override
+    {
+        int lastRoom = roomGeneration.load (std::memory_order_acquire);
+        juce::uint32 roomChangedAt = 0;
+        int loops = 0, idleLoops = 0;
+
+        while (! threadShouldExit())
+        {
+            if (auto* inst = current.load (std::memory_order_acquire))
+            {
+                workerId.store (inst->id, std::memory_order_release);
+
+                const auto done = inst->completed.load (std::memory_order_relaxed);
+                processTailJobs (*inst, true);
+                idleLoops = inst->completed.load (std::memory_order_relaxed) != done ? 0 : idleLoops + 1;
+            }
+
+            // Synthetic room: rebuild once the knobs have rested for 150 ms
+            const auto room = roomGeneration.load (std::memory_order_acquire);
+            const auto now = juce::Time::getMillisecondCounter();
+
+            if (room != lastRoom)
+            {
+                lastRoom = room;
+                roomChangedAt = now;
+            }
+            else if (roomChangedAt != 0 && now - roomChangedAt > 150)
+            {
+                roomChangedAt = 0;
+
+                bool synthetic;
+                {
+                    const juce::ScopedLock sl (sourceLock);
+                    synthetic = source.getNumSamples() == 0;
+                }
+
+                if (synthetic)
+                    requestBuild();
+            }
+
+            if (++loops % 250 == 0)
+                collectGarbage();
+
+            // Poll every millisecond while blocks are coming in; an engine that is asleep or
+            // not selected backs off, so idle instances cost next to nothing
+            wait (idleLoops < 50 ? 1 : idleWaitMs.load (std::memory_order_relaxed));
+        }
+    }
+
+    // Offline, the audio thread runs jobs too; whoever holds jobsBusy owns the tails.
+    void processTailJobs (Instance& inst, bool onWorker) noexcept
+    {
+        if (jobsBusy.test_and_set (std::memory_order_acquire))
+            return;
+
+        for (auto job = inst.completed.load (std::memory_order_relaxed);
+             job < inst.submitted.load (std::memory_order_acquire) && ! (onWorker && threadShouldExit()); ++job)
+        {
+            const auto resetJob = inst.resetFromJob.load (std::memory_order_acquire);
+
+            if (job >= resetJob && inst.workerResetJob < resetJob)
+            {
+                for (auto& c : inst.channels)
+                    c.tail.reset();
+
+                inst.workerResetJob = resetJob;
+            }
+
+            for (int ch = 0; ch < inst.numChannels; ++ch)
+                inst.channels[(size_t) ch].tail.process (inst.tailInput (ch, job), inst.tailOutput (ch, job));
+
+            inst.completed.store (job + 1, std::memory_order_release);
+
+            if (current.load (std::memory_order_acquire) != &inst)
+                break;
+        }
+
+        jobsBusy.clear (std::memory_order_release);
+    }
+
+    // ===== Worker lifetime (message thread) =====
+    void startWorker()
+    {
+        if (loader == nullptr)
+            loader = std::make_unique<juce::ThreadPool> (1);
+
+        if (isThreadRunning())
+            return;
+
+        // Until it reports in, the worker can only be on the audio thread's instance
+        workerId.store (audioId.load (std::memory_order_acquire), std::memory_order_release);
+        startThread (juce::Thread::Priority::high);
+    }
+
+    void stopWorker()
+    {
+        stopThread (2000);
+
+        // A stopped worker holds nothing: only the audio thread limits collection
+        workerId.store (std::numeric_limits<juce::int64>::max(), std::memory_order_release);
+        collectGarbage();
+    }
+
+    // ===== Loader =====
+    void requestBuild()
+    {
+        if (! enabled.load (std::memory_order_acquire))
+            return; // setActive builds on the way in
+
+        if (! buildQueued.exchange (true))
+            loader->addJob ([this] { buildQueued.store (false); buildInstance(); });
+    }
+
+    void buildInstance()
+    {
+        juce::AudioBuffer<float> ir;
+        double rate, irRate;
+        int channels;
+        std::vector<int> irChannelOf;
+        juce::int64 serial;
+
+        {
+            const juce::ScopedLock sl (sourceLock);
+            ir = source;
+            irRate = sourceRate;
+            rate = sampleRate;
+            channels = numChannels;
+            irChannelOf = irChannels;
+            serial = sourceSerial;
+        }
+
+        ir = ir.getNumSamples() > 0 ? resample (ir, irRate, rate)
+                                    : makeRoomImpulse (roomSize.load(), roomDamping.load(), rate);
+
+        normalise (ir);
+
+        auto inst = std::make_unique<Instance>();
+        inst->numChannels = channels;
+        inst->channels.resize ((size_t) channels);
+        inst->length = ir.getNumSamples();
+        inst->hasEarly = inst->length > headSize;
+        inst->hasTail = inst->length > earlyEnd;
+
+        for (int ch = 0; ch < channels; ++ch)
+        {
+            auto& c = inst->channels[(size_t) ch];
+            const auto irChannel = (size_t) ch < irChannelOf.size() ? irChannelOf[(size_t) ch] : ch;
+            const auto* h = ir.getReadPointer (juce::jlimit (0, ir.getNumChannels() - 1, irChannel));
+
+            for (int k = 0; k < juce::jmin (headSize, inst->length); ++k)
+                c.headTaps[(size_t) (headSize - 1 - k)] = h[k];
+
+            if (inst->hasEarly)
+                c.early.prepare (headSize, h + headSize, juce::jmin (inst->length, earlyEnd) - headSize);
+
+            if (inst->hasTail)
+            {
+                c.tail.prepare (tailBlockSize, h + earlyEnd, inst->length - earlyEnd);
+                c.tailIn.assign ((size_t) (numSlots * tailBlockSize), 0.0f);
+                c.tailOut.assign ((size_t) (numSlots * tailBlockSize), 0.0f);
+            }
+        }
+
+        {
+            // A build that started before a newer one was published is stale (old rate or IR)
+            const juce::ScopedLock sl (poolLock);
+
+            if (serial < publishedSerial)
+                return;
+
+            publishedSerial = serial;
+            inst->id = ++nextId;
+            auto* superseded = pending.exchange (inst.get(), std::memory_order_acq_rel);
+            instances.push_back (std::move (inst));
+
+            // Still pending, so the audio thread never claimed it, and now it never will
+            if (superseded != nullptr)
+                instances.erase (std::remove_if (instances.begin(), instances.end(),
+                                                 [superseded] (const auto& i) { return i.get() == superseded; }),
+                                 instances.end());
+        }
+
+        collectGarbage();
+    }
+
+    // Frees instances older than both the audio thread's and the worker's current one.
+    void collectGarbage()
+    {
+        const juce::ScopedLock sl (poolLock);
+        const auto oldestInUse = juce::jmin (audioId.load (std::memory_order_acquire), workerId.load (std::memory_order_acquire));
+
+        instances.erase (std::remove_if (instances.begin(), instances.end(),
+                                         [oldestInUse] (const auto& i) { return i->id < oldestInUse; }),
+                         instances.end());
+    }
+
+    // Band-limited rate conversion, as juce::dsp::Convolution does it
+    static juce::AudioBuffer<float> resample (const juce::AudioBuffer<float>& ir, double fromRate, double toRate)
+    {
+        if (fromRate <= 0.0 || std::abs (fromRate - toRate) < 1.0e-6)
+            return ir;
+
+        const auto ratio = fromRate / toRate;
+        juce::AudioBuffer<float> in (ir), out (ir.getNumChannels(), (int) std::ceil (ir.getNumSamples() / ratio));
+
+        juce::MemoryAudioSource memory (in, false);
+        juce::ResamplingAudioSource resampler (&memory, false, ir.getNumChannels());
+        resampler.setResamplingRatio (ratio);
+        resampler.prepareToPlay (out.getNumSamples(), toRate);
+        resampler.getNextAudioBlock ({ &out, 0, out.getNumSamples() });
+        return out;
+    }
+
+    // Trims the silent end and scales every IR to the same energy (unit impulse in,
+    // about the loudness of the other two algorithms out).
+    static void normalise (juce::AudioBuffer<float>& ir)
+    {
+        const auto peak = ir.getMagnitude (0, ir.getNumSamples());
+        if (peak <= 0.0f)
+            return;
+
+        auto length = ir.getNumSamples();
+        for (bool silent = true; silent && length > 1;)
+        {
+            for (int ch = 0; ch < ir.getNumChannels(); ++ch)
+                silent = silent && std::abs (ir.getSample (ch, length - 1)) < peak * 1.0e-4f;
+
+            if (silent)
+                --length;
+        }
+
+        ir.setSize (ir.getNumChannels(), length, true);
+
+        double energy = 0.0;
+        for (int ch = 0; ch < ir.getNumChannels(); ++ch)
+        {
+            const auto* x = ir.getReadPointer (ch);
+            for (int i = 0; i < length; ++i)
+                energy += (double) x[i] * x[i];
+        }
+
+        ir.applyGain ((float) (2.0 / std::sqrt (energy / ir.getNumChannels())));
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ConvolutionReverb)
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include <JuceHeader.h>
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+// ===== Cycle counter =====
+// Cheapest monotonic counter the CPU offers: the timestamp counter on x86 (reference
+// cycles), the virtual counter on 64-bit ARM (fixed frequency, not core cycles).
+// Anything else falls back to juce::Time's high-resolution ticks.
+struct CycleCounter
+{
+    static juce::uint64 now() noexcept
+    {
+       #if JUCE_INTEL
+        return (juce::uint64) __rdtsc();
+       #elif JUCE_ARM && JUCE_64BIT && (JUCE_GCC || JUCE_CLANG)
+        juce::uint64 v;
+        asm volatile ("mrs %0, cntvct_el0" : "=r" (v));
+        return v;
+       #else
+        return (juce::uint64) juce::Time::getHighResolutionTicks();
+       #endif
+    }
+
+    // Counter frequency. The TSC has no architectural query, so it is measured once
+    // against the high-resolution clock (about 20 ms, first call only).
+    static double ticksPerSecond()
+    {
+       #if JUCE_INTEL
+        static const double measured = []
+        {
+            const auto hiResPerSecond = (double) juce::Time::getHighResolutionTicksPerSecond();
+            const auto t0 = juce::Time::getHighResolutionTicks();
+            const auto c0 = now();
+
+            while ((double) (juce::Time::getHighResolutionTicks() - t0) < 0.02 * hiResPerSecond) {}
+
+            const auto t1 = juce::Time::getHighResolutionTicks();
+            const auto c1 = now();
+            return (double) (c1 - c0) * hiResPerSecond / (double) (t1 - t0);
+        }();
+        return measured;
+       #elif JUCE_ARM && JUCE_64BIT && (JUCE_GCC || JUCE_CLANG)
+        juce::uint64 f;
+        asm volatile ("mrs %0, cntfrq_el0" : "=r" (f));
+        return (double) f;
+       #else
+        return (double) juce::Time::getHighResolutionTicksPerSecond();
+       #endif
+    }
+};
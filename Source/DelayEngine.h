@@ -0,0 +1,200 @@
+#pragma once
+#include <JuceHeader.h>
+#include <cmath>
+#include <vector>
+
+// ===== Delay engine =====
+// Stereo feedback delay on one interleaved ring sized in prepare() from the sample rate
+// and maxDelayMs (power of two, masked indices).
+//
+// While the delay time is steady, the block is processed in chunks no longer than the
+// delay, so a chunk never reads frames it writes. Each chunk reads the delayed frames
+// into scratch with one flat, contiguous loop and writes input + feedback back in a
+// second one. A host block shorter than the delay is therefore a single chunk. While
+// the time is moving (smoothed over smoothingSeconds), frames go through per-sample
+// fractional reads instead.
+//
+// Output: y = x + mix * (d - x), with x + fb * d written back, as before.
+template <typename SampleType>
+class DelayEngine
+{
+public:
+    static constexpr double maxDelayMs = 1200.0;
+    static constexpr double smoothingSeconds = 0.05;
+
+    void prepare (const juce::dsp::ProcessSpec& spec)
+    {
+        sampleRate = spec.sampleRate;
+
+        const auto maxDelaySamples = (int) std::ceil (maxDelayMs * 0.001 * sampleRate);
+        const auto ringSize = juce::nextPowerOfTwo (maxDelaySamples + 2);
+
+        mask = (size_t) ringSize - 1;
+        ring.assign ((size_t) ringSize * 2, (SampleType) 0);
+        wet.assign ((size_t) juce::jmax ((juce::uint32) 1, spec.maximumBlockSize) * 2, (SampleType) 0);
+
+        delaySamples.reset (sampleRate, smoothingSeconds);
+        snapOnNextUpdate = true;
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        std::fill (ring.begin(), ring.end(), (SampleType) 0);
+        writePos = 0;
+    }
+
+    // Target delay; the first call after prepare() jumps straight to it.
+    void setDelayMs (SampleType ms) noexcept
+    {
+        const auto samples = (SampleType) juce::jlimit (1.0, maxDelayMs * 0.001 * sampleRate, (double) ms * 0.001 * sampleRate);
+
+        if (snapOnNextUpdate)
+        {
+            delaySamples.setCurrentAndTargetValue (samples);
+            snapOnNextUpdate = false;
+        }
+        else
+        {
+            delaySamples.setTargetValue (samples);
+        }
+    }
+
+    void setFeedback (SampleType newFeedback) noexcept { feedback = newFeedback; }
+
+    // Gives the right channel the left one's history (after a stretch of mono processing).
+    void copyLeftToRight() noexcept
+    {
+        for (size_t i = 0; i < ring.size(); i += 2)
+            ring[i + 1] = ring[i];
+    }
+
+    // `right` may be null for a mono bus.
+    void process (SampleType* left, SampleType* right, int numSamples, SampleType mix) noexcept
+    {
+        int i = 0;
+
+        while (delaySamples.isSmoothing() && i < numSamples)
+        {
+            processFrame (left, right, i, delaySamples.getNextValue(), mix);
+            ++i;
+        }
+
+        if (i < numSamples)
+            processSteady (left + i, right != nullptr ? right + i : nullptr, numSamples - i, mix);
+    }
+
+private:
+    double sampleRate = 44100.0;
+    SampleType feedback = (SampleType) 0.35;
+
+    std::vector<SampleType> ring; // interleaved frames, 2 * (mask + 1)
+    std::vector<SampleType> wet;  // interleaved delayed frames for one chunk
+    size_t mask = 0, writePos = 0;
+
+    juce::SmoothedValue<SampleType, juce::ValueSmoothingTypes::Linear> delaySamples;
+    bool snapOnNextUpdate = true;
+
+    void processFrame (SampleType* left, SampleType* right, int i, SampleType d, SampleType mix) noexcept
+    {
+        const auto whole = (size_t) d;
+        const auto frac  = d - (SampleType) whole;
+
+        const auto newer = 2 * ((writePos - whole) & mask);
+        const auto older = 2 * ((writePos - whole - 1) & mask);
+        const auto slot  = 2 * writePos;
+
+        const auto dl = ring[newer] + frac * (ring[older] - ring[newer]);
+        ring[slot] = left[i] + feedback * dl;
+        left[i] += mix * (dl - left[i]);
+
+        if (right != nullptr)
+        {
+            const auto dr = ring[newer + 1] + frac * (ring[older + 1] - ring[newer + 1]);
+            ring[slot + 1] = right[i] + feedback * dr;
+            right[i] += mix * (dr - right[i]);
+        }
+
+        writePos = (writePos + 1) & mask;
+    }
+
+    void processSteady (SampleType* left, SampleType* right, int numSamples, SampleType mix) noexcept
+    {
+        const auto d     = delaySamples.getTargetValue();
+        const auto whole = (size_t) d;
+        const auto frac  = d - (SampleType) whole;
+
+        const auto maxChunk = (int) juce::jmin ((size_t) wet.size() / 2, whole);
+
+        for (int start = 0; start < numSamples; )
+        {
+            const int n = juce::jmin (maxChunk, numSamples - start);
+
+            readDelayed ((writePos - whole) & mask, n, frac);
+
+            if (right != nullptr) writeChunk<true>  (left + start, right + start, n, mix);
+            else                  writeChunk<false> (left + start, nullptr, n, mix);
+
+            start += n;
+        }
+    }
+
+    // wet[frame] = lerp (ring[r], ring[r - 1], frac) for n frames from r, split where the ring wraps
+    void readDelayed (size_t r, int n, SampleType frac) noexcept
+    {
+        auto* out = wet.data();
+        const auto* buf = ring.data();
+
+        while (n > 0)
+        {
+            const int len = (int) juce::jmin ((size_t) n, mask + 1 - r);
+            int k = 0;
+
+            if (r == 0) // older neighbour of frame 0 is the last frame
+            {
+                for (int c = 0; c < 2; ++c)
+                    out[c] = buf[c] + frac * (buf[2 * mask + (size_t) c] - buf[c]);
+                k = 1;
+            }
+
+            const auto* newer = buf + 2 * r;
+
+            for (int j = 2 * k; j < 2 * len; ++j)
+                out[j] = newer[j] + frac * (newer[j - 2] - newer[j]);
+
+            out += 2 * len;
+            n -= len;
+            r = (r + (size_t) len) & mask;
+        }
+    }
+
+    template <bool stereo>
+    void writeChunk (SampleType* left, SampleType* right, int n, SampleType mix) noexcept
+    {
+        const auto* d = wet.data();
+
+        while (n > 0)
+        {
+            const int len = (int) juce::jmin ((size_t) n, mask + 1 - writePos);
+            auto* slot = ring.data() + 2 * writePos;
+
+            for (int i = 0; i < len; ++i)
+            {
+                slot[2 * i] = left[i] + feedback * d[2 * i];
+                left[i] += mix * (d[2 * i] - left[i]);
+
+                if constexpr (stereo)
+                {
+                    slot[2 * i + 1] = right[i] + feedback * d[2 * i + 1];
+                    right[i] += mix * (d[2 * i + 1] - right[i]);
+                }
+            }
+
+            left += len;
+            if constexpr (stereo) right += len;
+            d += 2 * len;
+            n -= len;
+            writePos = (writePos + (size_t) len) & mask;
+        }
+    }
+};
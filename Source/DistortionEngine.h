@@ -0,0 +1,194 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <memory>
+#include <vector>
+#include "CompensationDelay.h"
+
+// ===== Distortion engine =====
+// tanh waveshaper with optional 2x/4x/8x oversampling through JUCE's polyphase IIR
+// half-band cascade. The shaper is an inlined rational approximation (no std::function,
+// no libm call) written as straight-line arithmetic so the loop vectorises.
+//
+// All oversamplers are built in prepare(), so changing quality on the audio thread only
+// switches pointers. They run with integer latency; the dry side of the stage crossfade
+// goes through a matching CompensationDelay, and processBypassed() keeps that delay in
+// the signal path while the stage is off so the reported latency never changes with it.
+//
+// Each channel has its own single-channel oversampler. JUCE's inner stages run every
+// channel an oversampler was built for, so this is what lets a one-channel block (mono
+// processing upstream of the fan-out) cost one channel.
+template <typename SampleType>
+class DistortionEngine
+{
+public:
+    static constexpr int numQualities = 4; // 1x, 2x, 4x, 8x
+
+    // tanh from Lambert's continued fraction (7/6), |error| < 1e-4, exactly bounded by 1
+    static SampleType fastTanh (SampleType x) noexcept
+    {
+        x = juce::jlimit ((SampleType) -4.97, (SampleType) 4.97, x);
+        const auto x2 = x * x;
+        const auto num = x * ((SampleType) 135135 + x2 * ((SampleType) 17325 + x2 * ((SampleType) 378 + x2)));
+        const auto den = (SampleType) 135135 + x2 * ((SampleType) 62370 + x2 * ((SampleType) 3150 + (SampleType) 28 * x2));
+        return num / den;
+    }
+
+    void prepare (const juce::dsp::ProcessSpec& spec)
+    {
+        numChannels = spec.numChannels;
+        int maxLatency = 0;
+
+        for (size_t q = 1; q < (size_t) numQualities; ++q)
+        {
+            oversamplers[q].clear();
+
+            for (size_t ch = 0; ch < numChannels; ++ch)
+            {
+                auto& os = oversamplers[q].emplace_back (std::make_unique<Oversampler> (
+                    1, q, Oversampler::filterHalfBandPolyphaseIIR, true, true));
+
+                os->initProcessing (spec.maximumBlockSize);
+            }
+
+            maxLatency = juce::jmax (maxLatency, latencyOf (q));
+        }
+
+        dry.setSize ((int) numChannels, (int) spec.maximumBlockSize);
+        dryDelay.prepare ((int) numChannels, maxLatency);
+
+        setQuality (quality);
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        resetOversamplers();
+        dryDelay.reset();
+    }
+
+    void setQuality (int newQuality) noexcept
+    {
+        quality = (size_t) juce::jlimit (0, numQualities - 1, newQuality);
+        dryDelay.setDelay (latencyOf (quality));
+        needsReset = true;
+    }
+
+    void setDrive (SampleType gain) noexcept { drive = gain; }
+
+    // Gives channel 1 the dry-delay history of channel 0 (after a stretch of mono
+    // processing). The oversamplers' filter state is private to JUCE and can't be copied;
+    // channel 1's would be stale, so its half-band cascades start again from zero instead.
+    void copyLeftToRight() noexcept
+    {
+        dryDelay.copyChannel (0, 1);
+
+        for (auto& perChannel : oversamplers)
+            if (perChannel.size() > 1)
+                perChannel[1]->reset();
+    }
+
+    int getLatencySamples() const noexcept    { return latencyOf (quality); }
+    int getMaxLatencySamples() const noexcept { return latencyOf ((size_t) numQualities - 1); }
+
+    // In place: block = dry + mix * (shape (dry) - dry), both sides delayed by the latency.
+    void process (juce::dsp::AudioBlock<SampleType>& block, SampleType mix) noexcept
+    {
+        if (needsReset)
+            resetOversamplers();
+
+        if (quality == 0)
+        {
+            for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+                shape (block.getChannelPointer (ch), block.getNumSamples(), mix);
+
+            return;
+        }
+
+        // The dry buffer and the oversamplers hold one prepared block
+        const auto chunkSize = (size_t) dry.getNumSamples();
+
+        for (size_t offset = 0; offset < block.getNumSamples() && chunkSize > 0; offset += chunkSize)
+        {
+            auto chunk = block.getSubBlock (offset, juce::jmin (chunkSize, block.getNumSamples() - offset));
+            processOversampled (chunk, mix);
+        }
+    }
+
+    // Stage off: delay only, so downstream timing matches the reported latency.
+    void processBypassed (juce::dsp::AudioBlock<SampleType>& block) noexcept
+    {
+        dryDelay.process (block);
+        needsReset = true;
+    }
+
+private:
+    using Oversampler = juce::dsp::Oversampling<SampleType>;
+    std::array<std::vector<std::unique_ptr<Oversampler>>, (size_t) numQualities> oversamplers; // [quality][channel]
+    juce::AudioBuffer<SampleType> dry;
+    CompensationDelay<SampleType> dryDelay;
+
+    size_t numChannels = 2, quality = 0;
+    SampleType drive = 1;
+    bool needsReset = true;
+
+    // At most one prepared block
+    void processOversampled (juce::dsp::AudioBlock<SampleType>& block, SampleType mix) noexcept
+    {
+        auto dryBlock = juce::dsp::AudioBlock<SampleType> (dry).getSubsetChannelBlock (0, block.getNumChannels())
+                                                               .getSubBlock (0, block.getNumSamples());
+        dryBlock.copyFrom (block);
+        dryDelay.process (dryBlock);
+
+        for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+        {
+            auto& os = *oversamplers[quality][ch];
+            auto channel = block.getSingleChannelBlock (ch);
+            auto up = os.processSamplesUp (channel);
+
+            shape (up.getChannelPointer (0), up.getNumSamples(), (SampleType) 1);
+            os.processSamplesDown (channel);
+        }
+
+        for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+        {
+            auto* y = block.getChannelPointer (ch);
+            const auto* d = dryBlock.getChannelPointer (ch);
+
+            for (size_t i = 0; i < block.getNumSamples(); ++i)
+                y[i] = d[i] + mix * (y[i] - d[i]);
+        }
+    }
+
+    int latencyOf (size_t q) const noexcept
+    {
+        return q == 0 || oversamplers[q].empty() ? 0
+                                                 : juce::roundToInt (oversamplers[q].front()->getLatencyInSamples());
+    }
+
+    // Filter state left over from before a bypass or quality switch would click; start clean
+    void resetOversamplers() noexcept
+    {
+        for (auto& perChannel : oversamplers)
+            for (auto& os : perChannel)
+                os->reset();
+
+        needsReset = false;
+    }
+
+    void shape (SampleType* x, size_t n, SampleType mix) noexcept
+    {
+        const auto g = drive;
+
+        if (mix >= (SampleType) 1)
+        {
+            for (size_t i = 0; i < n; ++i)
+                x[i] = fastTanh (x[i] * g);
+        }
+        else
+        {
+            for (size_t i = 0; i < n; ++i)
+                x[i] += mix * (fastTanh (x[i] * g) - x[i]);
+        }
+    }
+};
@@ -0,0 +1,258 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include "CycleCounter.h"
+#include "SeqLock.h"
+
+// Lean builds define ULTIMATEADLIBS_DSP_LOAD=0: the scopes below become empty and the
+// counters are never read.
+#ifndef ULTIMATEADLIBS_DSP_LOAD
+ #define ULTIMATEADLIBS_DSP_LOAD 1
+#endif
+
+// ===== Stages =====
+enum class StageId { Filter, Dist, Chorus, Flanger, Delay, Reverb, count };
+
+inline constexpr int numStages = (int) StageId::count;
+
+inline const char* stageName (StageId id) noexcept
+{
+    static constexpr const char* names[] = { "filter", "dist", "chorus", "flanger", "delay", "reverb" };
+    return names[(int) id];
+}
+
+// ===== Buffer traffic =====
+// Audio buffer bytes read and written by the chain's passes (a stage reading and writing
+// its block, the wet scratch, crossfades, precision conversions, copies and gains), added
+// by the code that runs each pass: channels x samples x sample size per sweep. What a
+// kernel does inside its own state (delay rings, oversampler, FFT buffers) isn't counted.
+struct BufferTraffic
+{
+    juce::uint64 bytes = 0;
+
+    template <typename SampleType>
+    void add (int numSweeps, int numChannels, int numSamples) noexcept
+    {
+       #if ULTIMATEADLIBS_DSP_LOAD
+        bytes += (juce::uint64) numSweeps * (juce::uint64) numChannels * (juce::uint64) numSamples * sizeof (SampleType);
+       #else
+        juce::ignoreUnused (numSweeps, numChannels, numSamples);
+       #endif
+    }
+};
+
+// ===== Load snapshot =====
+struct StageLoad
+{
+    float cpuPercent = 0.0f;      // share of real time over the last window
+    float worstBlockMs = 0.0f;    // slowest block in the last window
+    juce::uint64 totalTicks = 0;  // since the last reset
+    juce::uint64 totalBytes = 0;  // buffer traffic since the last reset (see BufferTraffic)
+};
+
+struct DspLoadSnapshot
+{
+    std::array<StageLoad, (size_t) numStages> stages;
+    StageLoad analyzer;           // the analyzer taps (AnalyzerFifo pushes)
+    StageLoad block;              // the whole processBlock call
+    double ticksPerSecond = 0.0;
+    juce::uint64 totalSamples = 0;
+
+    const StageLoad& operator[] (StageId id) const noexcept { return stages[(size_t) id]; }
+
+    // Average cost since the last reset, per sample frame.
+    double nsPerSample (const StageLoad& s) const noexcept
+    {
+        return totalSamples == 0 || ticksPerSecond <= 0.0 ? 0.0
+                                                          : 1.0e9 * (double) s.totalTicks / ticksPerSecond / (double) totalSamples;
+    }
+
+    double bytesPerSample (const StageLoad& s) const noexcept
+    {
+        return totalSamples == 0 ? 0.0 : (double) s.totalBytes / (double) totalSamples;
+    }
+};
+
+// ===== Per-stage DSP load =====
+// The audio thread brackets processBlock with a BlockScope and each active stage with a
+// StageScope; both read CycleCounter, nothing else. Stages and the chain around them
+// report their buffer traffic with addTraffic(). At the end of every block the totals
+// are published through a SeqLock, and CPU % / worst block are refreshed every
+// windowSeconds of audio. Readers (editor, tools) call getSnapshot() from any thread.
+class DspLoadMeter
+{
+public:
+    static constexpr bool enabled = ULTIMATEADLIBS_DSP_LOAD != 0;
+    static constexpr double windowSeconds = 0.5;
+
+    void prepare (double sampleRate) noexcept
+    {
+       #if ULTIMATEADLIBS_DSP_LOAD
+        ticksPerSecond = CycleCounter::ticksPerSecond();
+        rate = sampleRate;
+        windowLength = juce::jmax (1, (int) (sampleRate * windowSeconds));
+        clear();
+        published.store (current);
+       #else
+        juce::ignoreUnused (sampleRate);
+       #endif
+    }
+
+    // Zeroes the totals before the next block; safe to call while audio is running.
+    void resetTotals() noexcept
+    {
+       #if ULTIMATEADLIBS_DSP_LOAD
+        resetRequested.store (true, std::memory_order_relaxed);
+       #endif
+    }
+
+    DspLoadSnapshot getSnapshot() const noexcept { return published.load(); }
+
+    // Audio thread. A stage's traffic, or the chain's own passes outside the stages (the
+    // block total includes both).
+    void addTraffic (StageId stage, const BufferTraffic& t) noexcept { addSlotTraffic ((size_t) stage, t); }
+    void addChainTraffic (const BufferTraffic& t) noexcept          { addSlotTraffic (blockSlot, t); }
+
+    class StageScope
+    {
+    public:
+        StageScope (DspLoadMeter& m, StageId s) noexcept : StageScope (m, (size_t) s) {}
+
+        // The analyzer taps, timed like a stage in a slot of their own
+        struct AnalyzerTaps {};
+        StageScope (DspLoadMeter& m, AnalyzerTaps) noexcept : StageScope (m, analyzerSlot) {}
+
+       #if ULTIMATEADLIBS_DSP_LOAD
+        ~StageScope() noexcept { meter.blockTicks[slot] += CycleCounter::now() - start; }
+       #endif
+
+    private:
+        StageScope (DspLoadMeter& m, size_t s) noexcept
+           #if ULTIMATEADLIBS_DSP_LOAD
+            : meter (m), slot (s), start (CycleCounter::now())
+           #endif
+        {
+            juce::ignoreUnused (m, s);
+        }
+
+       #if ULTIMATEADLIBS_DSP_LOAD
+        DspLoadMeter& meter;
+        size_t slot;
+        juce::uint64 start;
+       #endif
+
+        JUCE_DECLARE_NON_COPYABLE (StageScope)
+    };
+
+    class BlockScope
+    {
+    public:
+        BlockScope (DspLoadMeter& m, int numSamplesIn) noexcept
+           #if ULTIMATEADLIBS_DSP_LOAD
+            : meter (m), numSamples (numSamplesIn), start (CycleCounter::now())
+           #endif
+        {
+            juce::ignoreUnused (m, numSamplesIn);
+        }
+
+       #if ULTIMATEADLIBS_DSP_LOAD
+        ~BlockScope() noexcept { meter.endBlock (numSamples, CycleCounter::now() - start); }
+
+    private:
+        DspLoadMeter& meter;
+        int numSamples;
+        juce::uint64 start;
+       #endif
+
+        JUCE_DECLARE_NON_COPYABLE (BlockScope)
+    };
+
+private:
+    // Slots after the stages
+    static constexpr size_t analyzerSlot = (size_t) numStages;
+    static constexpr size_t blockSlot = analyzerSlot + 1; // last slot: whole block
+
+   #if ULTIMATEADLIBS_DSP_LOAD
+    double ticksPerSecond = 1.0, rate = 44100.0;
+    int windowLength = 1, windowSamples = 0;
+    std::array<juce::uint64, blockSlot + 1> blockTicks {}, windowTicks {}, windowWorst {}, blockBytes {};
+    DspLoadSnapshot current;
+    std::atomic<bool> resetRequested { false };
+   #endif
+
+    SeqLock<DspLoadSnapshot> published;
+
+    void addSlotTraffic (size_t slot, const BufferTraffic& t) noexcept
+    {
+       #if ULTIMATEADLIBS_DSP_LOAD
+        blockBytes[slot] += t.bytes;
+       #else
+        juce::ignoreUnused (slot, t);
+       #endif
+    }
+
+   #if ULTIMATEADLIBS_DSP_LOAD
+    StageLoad& loadFor (size_t slot) noexcept
+    {
+        return slot == blockSlot ? current.block : slot == analyzerSlot ? current.analyzer : current.stages[slot];
+    }
+
+    void clear() noexcept
+    {
+        blockTicks.fill (0);
+        blockBytes.fill (0);
+        windowTicks.fill (0);
+        windowWorst.fill (0);
+        windowSamples = 0;
+        current = {};
+        current.ticksPerSecond = ticksPerSecond;
+    }
+
+    void endBlock (int numSamples, juce::uint64 ticks) noexcept
+    {
+        if (resetRequested.exchange (false, std::memory_order_relaxed))
+        {
+            clear();
+            return;
+        }
+
+        blockTicks[blockSlot] = ticks;
+
+        for (size_t i = 0; i < blockSlot; ++i)
+            blockBytes[blockSlot] += blockBytes[i];
+
+        for (size_t i = 0; i < blockTicks.size(); ++i)
+        {
+            loadFor (i).totalTicks += blockTicks[i];
+            loadFor (i).totalBytes += blockBytes[i];
+            blockBytes[i] = 0;
+            windowTicks[i] += blockTicks[i];
+            windowWorst[i] = juce::jmax (windowWorst[i], blockTicks[i]);
+            blockTicks[i] = 0;
+        }
+
+        current.totalSamples += (juce::uint64) numSamples;
+        windowSamples += numSamples;
+
+        if (windowSamples >= windowLength)
+        {
+            // Ticks spent against ticks of audio played: the real-time share
+            const double windowTicksOfAudio = (double) windowSamples / rate * ticksPerSecond;
+
+            for (size_t i = 0; i < windowTicks.size(); ++i)
+            {
+                auto& load = loadFor (i);
+                load.cpuPercent   = (float) (100.0 * (double) windowTicks[i] / windowTicksOfAudio);
+                load.worstBlockMs = (float) (1000.0 * (double) windowWorst[i] / ticksPerSecond);
+            }
+
+            windowTicks.fill (0);
+            windowWorst.fill (0);
+            windowSamples = 0;
+        }
+
+        published.store (current);
+    }
+   #endif
+};
@@ -0,0 +1,312 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <cmath>
+#include <vector>
+
+// ===== FDN reverb =====
+// Eight delay lines fed back through a permuted Householder matrix, H = (I - 2/N 11^T) P.
+// Each line is one SIMDRegister lane: the damping one-poles, the feedback gains and the
+// matrix are a few vector ops plus three horizontal sums per sample. A frame of all eight
+// lines is contiguous in the ring, so the write is aligned vector stores and only the
+// eight taps are scalar reads. P (line j feeds lane j - 1) moves the Householder's
+// dominant diagonal off the diagonal.
+//
+// A feedback network alone thickens slowly: after 100 ms an impulse has made only two
+// round trips. The input therefore first goes through three diffusion steps (eight short
+// delays, polarity flips, an 8-point Hadamard transform each), which turn it into
+// 512 echoes inside about 50 ms. The diffuser has no feedback, so it runs a whole block at a
+// time, channel by channel, as flat loops the compiler vectorises across samples.
+//
+// REV_SIZE sets the decay time (RT60 from 0.25 s to 8 s) and REV_DAMP the high-frequency
+// loss per pass. Line lengths depend only on the sample rate, so automation never moves
+// a tap.
+template <typename SampleType>
+class FdnReverb
+{
+public:
+    using Vec = juce::dsp::SIMDRegister<SampleType>;
+    static constexpr size_t numLines = 8;
+    static constexpr size_t lanes = Vec::SIMDNumElements;
+    static constexpr size_t numRegs = numLines / lanes;
+
+    static_assert (numLines % lanes == 0, "lines must fill whole registers");
+
+    void prepare (const juce::dsp::ProcessSpec& spec)
+    {
+        sampleRate = spec.sampleRate;
+
+        // Roughly 30-75 ms, mutually prime at 48 kHz
+        static constexpr double lineMs[numLines] = { 29.71, 37.13, 41.09, 43.69, 53.29, 59.87, 67.13, 73.31 };
+
+        size_t longest = 0;
+        for (size_t j = 0; j < numLines; ++j)
+        {
+            lengths[j] = (size_t) juce::jmax (1, juce::roundToInt (lineMs[j] * 0.001 * sampleRate));
+            longest = juce::jmax (longest, lengths[j]);
+        }
+
+        mask = (size_t) juce::nextPowerOfTwo ((int) longest + 1) - 1;
+        ring.assign ((mask + 1) * numRegs, Vec::expand ((SampleType) 0));
+
+        // Step s spreads its taps over diffusionMs[s]; the orders are shuffled so that no
+        // lane gets the longest tap twice.
+        static constexpr double diffusionMs[numDiffusers] = { 7.0, 15.0, 31.0 };
+        static constexpr double slot[numDiffusers][numLines] = { { 0.13, 5.71, 2.42, 7.94, 4.27, 1.58, 6.86, 3.05 },
+                                                                 { 3.62, 0.35, 6.18, 2.91, 7.47, 5.09, 1.74, 4.40 },
+                                                                 { 6.23, 2.81, 4.66, 0.52, 3.37, 7.70, 5.15, 1.98 } };
+        blockSize = (size_t) juce::jmax (1u, spec.maximumBlockSize);
+
+        for (size_t d = 0; d < numDiffusers; ++d)
+        {
+            auto& step = diffusers[d];
+            size_t longestTap = 0;
+
+            for (size_t j = 0; j < numLines; ++j)
+            {
+                step.taps[j] = (size_t) juce::jmax (1, juce::roundToInt (diffusionMs[d] * slot[d][j] / (double) numLines * 0.001 * sampleRate));
+                longestTap = juce::jmax (longestTap, step.taps[j]);
+            }
+
+            // Whole block is written before it is read back, so the ring covers both
+            step.mask = (size_t) juce::nextPowerOfTwo ((int) (longestTap + blockSize)) - 1;
+
+            for (auto& r : step.rings)
+                r.assign (step.mask + 1, (SampleType) 0);
+        }
+
+        for (auto& c : diffused)
+            c.assign (blockSize, (SampleType) 0);
+
+        setParameters (size, damping);
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        std::fill (ring.begin(), ring.end(), Vec::expand ((SampleType) 0));
+        lowpass.fill (Vec::expand ((SampleType) 0));
+        writePos = 0;
+
+        for (auto& step : diffusers)
+            for (auto& r : step.rings)
+                std::fill (r.begin(), r.end(), (SampleType) 0);
+
+        diffusePos = 0;
+    }
+
+    void setParameters (SampleType newSize, SampleType newDamping) noexcept
+    {
+        size = juce::jlimit ((SampleType) 0, (SampleType) 1, newSize);
+        damping = juce::jlimit ((SampleType) 0, (SampleType) 1, newDamping);
+
+        const double rt60 = rt60Seconds ((double) size);
+        alignas (sizeof (Vec)) SampleType g[numLines];
+
+        // Tap j has just travelled through line source (j), so it carries that line's loss
+        for (size_t j = 0; j < numLines; ++j)
+            g[j] = (SampleType) std::pow (10.0, -3.0 * (double) lengths[source (j)] / (rt60 * sampleRate));
+
+        for (size_t r = 0; r < numRegs; ++r)
+            gains[r] = Vec::fromRawArray (g + r * lanes);
+
+        dampCoeff = Vec::expand ((SampleType) 0.8 * damping);
+    }
+
+    // REV_SIZE 0..1 to decay time, 0.25 s to 8 s.
+    static double rt60Seconds (double size) noexcept { return 0.25 * std::pow (32.0, juce::jlimit (0.0, 1.0, size)); }
+
+    template <typename ProcessContext>
+    void process (const ProcessContext& context) noexcept
+    {
+        const auto& inputBlock = context.getInputBlock();
+        auto& outputBlock      = context.getOutputBlock();
+        const auto numSamples  = outputBlock.getNumSamples();
+        const bool stereo      = outputBlock.getNumChannels() > 1;
+
+        const auto* inL = inputBlock.getChannelPointer (0);
+        const auto* inR = stereo ? inputBlock.getChannelPointer (1) : inL;
+        auto* outL = outputBlock.getChannelPointer (0);
+        auto* outR = stereo ? outputBlock.getChannelPointer (1) : nullptr;
+
+        for (size_t start = 0; start < numSamples; start += blockSize)
+        {
+            const auto n = juce::jmin (blockSize, numSamples - start);
+
+            diffuse (inL + start, inR + start, n);
+            feedback (outL + start, outR != nullptr ? outR + start : nullptr, n);
+        }
+    }
+
+private:
+    static constexpr size_t numDiffusers = 3;
+    static constexpr SampleType inputGain  = (SampleType) 0.35;
+    static constexpr SampleType outputGain = (SampleType) 1.2;
+
+    struct Diffuser
+    {
+        std::array<size_t, numLines> taps {};
+        std::array<std::vector<SampleType>, numLines> rings;
+        size_t mask = 0;
+    };
+
+    double sampleRate = 44100.0;
+    SampleType size = (SampleType) 0.35, damping = (SampleType) 0.5;
+
+    std::array<size_t, numLines> lengths {};
+    std::vector<Vec> ring; // frames of numLines samples, numRegs registers each
+    size_t mask = 0, writePos = 0;
+
+    std::array<Diffuser, numDiffusers> diffusers;
+    std::array<std::vector<SampleType>, numLines> diffused; // one block per line
+    size_t blockSize = 0, diffusePos = 0;
+
+    std::array<Vec, numRegs> lowpass {}, gains {};
+    Vec dampCoeff = Vec::expand ((SampleType) 0);
+
+    // Two orthogonal +-1 rows (Hadamard rows 1 and 2): L and R are injected into and read
+    // from every line with different sign patterns, which keeps the outputs decorrelated.
+    // Loaded with fromRawArray, so every row starts on a register boundary.
+    alignas (sizeof (Vec)) static constexpr SampleType signRows[2][numLines] = { {  1, -1,  1, -1,  1, -1,  1, -1 },
+                                                                                 {  1,  1, -1, -1,  1,  1, -1, -1 } };
+    static_assert ((numLines * sizeof (SampleType)) % sizeof (Vec) == 0, "signRows rows must stay register aligned");
+    const std::array<std::array<Vec, numRegs>, 2> signs = makeSigns();
+
+    // Fills diffused[] with n samples of the input spread over the eight lines and passed
+    // through the diffusion steps.
+    void diffuse (const SampleType* inL, const SampleType* inR, size_t n) noexcept
+    {
+        for (size_t j = 0; j < numLines; ++j)
+        {
+            const auto gl = inputGain * signRows[0][j], gr = inputGain * signRows[1][j];
+            auto* d = diffused[j].data();
+
+            for (size_t i = 0; i < n; ++i)
+                d[i] = gl * inL[i] + gr * inR[i];
+        }
+
+        for (size_t s = 0; s < numDiffusers; ++s)
+        {
+            auto& step = diffusers[s];
+
+            for (size_t j = 0; j < numLines; ++j)
+            {
+                auto& ring = step.rings[j];
+                auto* d = diffused[j].data();
+
+                // Alternate polarities per step and line; 1/sqrt(8) keeps the transform unitary
+                const auto gain = (SampleType) (((j + s) & 1) != 0 ? -0.35355339059327373 : 0.35355339059327373);
+
+                forEachSegment (diffusePos, n, step.mask, [&] (size_t pos, size_t offset, size_t len)
+                {
+                    std::copy (d + offset, d + offset + len, ring.begin() + (std::ptrdiff_t) pos);
+                });
+
+                forEachSegment (diffusePos - step.taps[j], n, step.mask, [&] (size_t pos, size_t offset, size_t len)
+                {
+                    const auto* src = ring.data() + pos;
+                    for (size_t i = 0; i < len; ++i)
+                        d[offset + i] = gain * src[i];
+                });
+            }
+
+            for (size_t half = 1; half < numLines; half <<= 1)
+                for (size_t a = 0; a < numLines; a += 2 * half)
+                    for (size_t b = a; b < a + half; ++b)
+                    {
+                        auto* p = diffused[b].data();
+                        auto* q = diffused[b + half].data();
+
+                        for (size_t i = 0; i < n; ++i)
+                        {
+                            const auto x = p[i], y = q[i];
+                            p[i] = x + y;
+                            q[i] = x - y;
+                        }
+                    }
+        }
+
+        diffusePos += n;
+    }
+
+    // Splits n samples starting at ring position `start` into runs that do not wrap.
+    template <typename Fn>
+    static void forEachSegment (size_t start, size_t n, size_t ringMask, Fn&& fn) noexcept
+    {
+        for (size_t offset = 0; offset < n;)
+        {
+            const auto pos = (start + offset) & ringMask;
+            const auto len = juce::jmin (n - offset, ringMask + 1 - pos);
+            fn (pos, offset, len);
+            offset += len;
+        }
+    }
+
+    void feedback (SampleType* outL, SampleType* outR, size_t n) noexcept
+    {
+        const auto householder = (SampleType) 2 / (SampleType) numLines;
+        auto* frames = reinterpret_cast<SampleType*> (ring.data());
+
+        alignas (sizeof (Vec)) SampleType tap[numLines], in[numLines];
+        const SampleType* lineInput[numLines];
+
+        for (size_t j = 0; j < numLines; ++j)
+            lineInput[j] = diffused[j].data();
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            for (size_t j = 0; j < numLines; ++j)
+            {
+                const auto src = source (j);
+                tap[j] = frames[((writePos - lengths[src]) & mask) * numLines + src];
+                in[j] = lineInput[j][i];
+            }
+
+            Vec fed[numRegs];
+            auto sum = Vec::expand ((SampleType) 0), wetL = sum, wetR = sum;
+
+            // Registers are added lane-wise first: three horizontal sums per sample in total
+            for (size_t r = 0; r < numRegs; ++r)
+            {
+                const auto o = Vec::fromRawArray (tap + r * lanes);
+                lowpass[r] = o + dampCoeff * (lowpass[r] - o);
+                fed[r] = lowpass[r] * gains[r];
+                sum = sum + fed[r];
+
+                wetL = wetL + o * signs[0][r];
+                wetR = wetR + o * signs[1][r];
+            }
+
+            const auto reflect = Vec::expand (householder * sum.sum());
+            auto* frame = ring.data() + writePos * numRegs;
+
+            for (size_t r = 0; r < numRegs; ++r)
+                frame[r] = fed[r] - reflect + Vec::fromRawArray (in + r * lanes);
+
+            writePos = (writePos + 1) & mask;
+
+            if (outR != nullptr)
+            {
+                outL[i] = wetL.sum() * outputGain;
+                outR[i] = wetR.sum() * outputGain;
+            }
+            else
+            {
+                outL[i] = (wetL + wetR).sum() * (SampleType) 0.5 * outputGain;
+            }
+        }
+    }
+
+    static constexpr size_t source (size_t j) noexcept { return (j + 1) % numLines; }
+
+    static std::array<std::array<Vec, numRegs>, 2> makeSigns() noexcept
+    {
+        std::array<std::array<Vec, numRegs>, 2> s;
+
+        for (size_t row = 0; row < 2; ++row)
+            for (size_t r = 0; r < numRegs; ++r)
+                s[row][r] = Vec::fromRawArray (signRows[row] + r * lanes);
+
+        return s;
+    }
+};
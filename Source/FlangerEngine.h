@@ -0,0 +1,144 @@
+#pragma once
+#include <JuceHeader.h>
+#include <cmath>
+#include <vector>
+
+// ===== Flanger engine =====
+// Stereo flanger on one interleaved ring (L/R of a frame side by side) whose size is a
+// power of two, so wraparound is a mask instead of DelayLine's modulo. The LFO is a
+// quadrature oscillator: one 2x2 rotation per sample replaces std::sin, and both
+// channels share it. Each block runs in two passes, first the modulated delay times
+// into a scratch array, then a branch-free read/write loop over frames.
+//
+// Output matches the loop it replaces: y = x + mix * d, with d read through linear
+// interpolation and x + fb * d written back.
+template <typename SampleType>
+class FlangerEngine
+{
+public:
+    static constexpr SampleType minDelayMs = (SampleType) 0.2;
+    static constexpr SampleType maxDelayMs = (SampleType) 8.0;
+
+    void prepare (const juce::dsp::ProcessSpec& spec)
+    {
+        sampleRate = spec.sampleRate;
+
+        const auto maxDelaySamples = (int) std::ceil (maxDelayMs * 0.001 * sampleRate);
+        const auto ringSize = juce::nextPowerOfTwo (maxDelaySamples + 2);
+
+        mask = (size_t) ringSize - 1;
+        ring.assign ((size_t) ringSize * 2, (SampleType) 0);
+        delays.assign (juce::jmax ((size_t) 1, (size_t) spec.maximumBlockSize), (SampleType) 0);
+
+        setRate (rateHz);
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        std::fill (ring.begin(), ring.end(), (SampleType) 0);
+        writePos = 0;
+        sinPhase = 0;
+        cosPhase = 1;
+    }
+
+    void setRate (SampleType hz) noexcept
+    {
+        rateHz = hz;
+        const auto w = juce::MathConstants<double>::twoPi * (double) hz / sampleRate;
+        rotCos = (SampleType) std::cos (w);
+        rotSin = (SampleType) std::sin (w);
+    }
+
+    void setDepth (SampleType newDepth) noexcept    { depth = newDepth; }
+    void setFeedback (SampleType newFeedback) noexcept { feedback = newFeedback; }
+
+    // Gives the right channel the left one's history (after a stretch of mono processing).
+    void copyLeftToRight() noexcept
+    {
+        for (size_t i = 0; i < ring.size(); i += 2)
+            ring[i + 1] = ring[i];
+    }
+
+    // `right` may be null for a mono bus.
+    void process (SampleType* left, SampleType* right, int numSamples, SampleType mix) noexcept
+    {
+        const auto chunk = (int) delays.size();
+
+        for (int start = 0; start < numSamples; start += chunk)
+        {
+            const int n = juce::jmin (chunk, numSamples - start);
+            renderDelayTimes (n);
+
+            if (right != nullptr)
+                processFrames<true>  (left + start, right + start, n, mix);
+            else
+                processFrames<false> (left + start, left + start, n, mix);
+        }
+    }
+
+private:
+    double sampleRate = 44100.0;
+    SampleType rateHz = (SampleType) 0.35, depth = (SampleType) 0.6, feedback = (SampleType) 0.2;
+
+    std::vector<SampleType> ring;   // interleaved frames, 2 * (mask + 1)
+    std::vector<SampleType> delays; // per-frame delay in samples, one block
+    size_t mask = 0, writePos = 0;
+
+    SampleType sinPhase = 0, cosPhase = 1, rotCos = 1, rotSin = 0;
+
+    // delay = (min + lfo * depth * (max - min)) ms, lfo = (1 + sin) / 2 as before
+    void renderDelayTimes (int n) noexcept
+    {
+        const auto msToSamples = (SampleType) (0.001 * sampleRate);
+        const auto base  = minDelayMs * msToSamples;
+        const auto swing = (SampleType) 0.5 * depth * (maxDelayMs - minDelayMs) * msToSamples;
+
+        auto s = sinPhase, c = cosPhase;
+
+        for (int i = 0; i < n; ++i)
+        {
+            delays[(size_t) i] = base + swing * ((SampleType) 1 + s);
+
+            const auto nextS = s * rotCos + c * rotSin;
+            c = c * rotCos - s * rotSin;
+            s = nextS;
+        }
+
+        // The rotation leaks amplitude slowly; pull it back onto the unit circle once per block
+        const auto norm = (SampleType) 1 / std::sqrt (s * s + c * c);
+        sinPhase = s * norm;
+        cosPhase = c * norm;
+    }
+
+    template <bool stereo>
+    void processFrames (SampleType* left, SampleType* right, int n, SampleType mix) noexcept
+    {
+        auto* buf = ring.data();
+        auto w = writePos;
+
+        for (int i = 0; i < n; ++i, ++w)
+        {
+            const auto d    = delays[(size_t) i];
+            const auto whole = (size_t) d;
+            const auto frac = d - (SampleType) whole;
+
+            const auto newer = 2 * ((w - whole) & mask);
+            const auto older = 2 * ((w - whole - 1) & mask);
+            const auto slot  = 2 * (w & mask);
+
+            const auto dl = buf[newer] + frac * (buf[older] - buf[newer]);
+            buf[slot] = left[i] + feedback * dl;
+            left[i] += mix * dl;
+
+            if constexpr (stereo)
+            {
+                const auto dr = buf[newer + 1] + frac * (buf[older + 1] - buf[newer + 1]);
+                buf[slot + 1] = right[i] + feedback * dr;
+                right[i] += mix * dr;
+            }
+        }
+
+        writePos = w & mask;
+    }
+};
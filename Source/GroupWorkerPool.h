@@ -0,0 +1,121 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// ===== Group worker pool =====
+// Spreads the channel groups of one stage over a few threads during offline renders.
+// The workers are started off the audio thread and sleep between stages; run() hands
+// them the stage through a function pointer and a context (nothing is allocated), takes
+// tasks itself as well, and returns once every task has finished.
+//
+// Tasks are claimed from one 64-bit cursor holding the task count and the next index,
+// so a worker that wakes late, after its run is over, can never claim a task twice or
+// run one against a stale count. Waking a worker takes a lock: real-time processing
+// doesn't use the pool.
+class GroupWorkerPool
+{
+public:
+    GroupWorkerPool() = default;
+    ~GroupWorkerPool() { stop(); }
+
+    // Message thread. Keeps the workers already running when the count is unchanged.
+    void start (int numWorkers)
+    {
+        if ((int) workers.size() == numWorkers)
+            return;
+
+        stop();
+
+        for (int i = 0; i < numWorkers; ++i)
+        {
+            workers.push_back (std::make_unique<Worker> (*this));
+            workers.back()->startThread (juce::Thread::Priority::high);
+        }
+    }
+
+    void stop()
+    {
+        for (auto& w : workers)
+            w->stopThread (2000);
+
+        workers.clear();
+    }
+
+    int getNumWorkers() const noexcept { return (int) workers.size(); }
+
+    // Calls fn (i) for every i in [0, numTasks), on this thread and the workers.
+    template <typename Fn>
+    void run (int numTasks, Fn& fn) noexcept
+    {
+        if (workers.empty() || numTasks < 2)
+        {
+            for (int i = 0; i < numTasks; ++i)
+                fn (i);
+
+            return;
+        }
+
+        task = [] (void* context, int i) { (*static_cast<Fn*> (context)) (i); };
+        taskContext = &fn;
+        finished.store (0, std::memory_order_relaxed);
+        cursor.store ((juce::uint64) numTasks << 32, std::memory_order_release);
+
+        for (int i = 0; i < juce::jmin ((int) workers.size(), numTasks - 1); ++i)
+            workers[(size_t) i]->notify();
+
+        work();
+
+        while (finished.load (std::memory_order_acquire) < numTasks)
+            juce::Thread::yield();
+    }
+
+private:
+    struct Worker  : public juce::Thread
+    {
+        explicit Worker (GroupWorkerPool& p) : juce::Thread ("Channel group worker"), pool (p) {}
+
+        void run() override
+        {
+            while (! threadShouldExit())
+            {
+                wait (-1);
+                pool.work();
+            }
+        }
+
+        GroupWorkerPool& pool;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    // Written before the cursor is published, read only after a task has been claimed
+    void (*task) (void*, int) = nullptr;
+    void* taskContext = nullptr;
+
+    std::atomic<juce::uint64> cursor { 0 }; // task count << 32 | next index
+    std::atomic<int> finished { 0 };
+
+    void work() noexcept
+    {
+        auto c = cursor.load (std::memory_order_acquire);
+
+        for (;;)
+        {
+            const auto index = (int) (c & 0xffffffffu);
+
+            if (index >= (int) (c >> 32))
+                return;
+
+            if (! cursor.compare_exchange_weak (c, c + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+                continue;
+
+            task (taskContext, index);
+            finished.fetch_add (1, std::memory_order_release);
+            c = cursor.load (std::memory_order_acquire);
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GroupWorkerPool)
+};
@@ -0,0 +1,410 @@
+#pragma once
+#include <JuceHeader.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <initializer_list>
+#include "SeqLock.h"
+
+// ===== Level snapshot =====
+// Every channel of the widest bus the processor accepts (7.1.4, 9.1.6...)
+inline constexpr int maxMeterChannels = 16;
+
+struct ChannelLevels
+{
+    float peak = 0.0f;      // sample peak, linear, held and decayed
+    float rms = 0.0f;       // linear, exponential average over rmsSeconds
+    float truePeak = 0.0f;  // 4x oversampled peak, linear, held like `peak`
+};
+
+struct LevelSnapshot
+{
+    std::array<ChannelLevels, (size_t) maxMeterChannels> channels;
+    int numChannels = 0;
+    float shortTermLufs = -100.0f; // K-weighted, last 3 s
+
+    float loudestRms() const noexcept      { return loudest (&ChannelLevels::rms); }
+    float loudestTruePeak() const noexcept { return loudest (&ChannelLevels::truePeak); }
+
+    float loudest (float ChannelLevels::* field) const noexcept
+    {
+        float v = 0.0f;
+        for (int ch = 0; ch < numChannels; ++ch)
+            v = juce::jmax (v, channels[(size_t) ch].*field);
+        return v;
+    }
+};
+
+// ===== Level meter =====
+// Per-channel peak, RMS and true-peak plus short-term loudness (ITU-R BS.1770 K-weighting,
+// 3 s window), computed together in one pass over the block. Ballistics are in seconds,
+// so the display doesn't change with the host's block size. The audio thread calls
+// process() (or processSilence()) once per block; results are published through a
+// SeqLock and getSnapshot() may be called from any thread.
+//
+// Channels are packed into the lanes of a juce::dsp::SIMDRegister<float>, as in
+// SvfFilterEngine: the K-weighting filters, the RMS average and the true-peak interpolator
+// step a whole group of channels per instruction, in single precision. The sample peak
+// comes from FloatVectorOperations::findMinAndMax. Blocks are interleaved a chunk at a
+// time into a fixed scratch, so nothing is allocated and the float energy sums stay short.
+class LevelMeter
+{
+public:
+    using Vec = juce::dsp::SIMDRegister<float>;
+    static constexpr int lanes = (int) Vec::SIMDNumElements;
+
+    static constexpr double rmsSeconds = 0.3;           // VU-like integration
+    static constexpr double peakFallDbPerSecond = 20.0;
+    static constexpr float silentLufs = -100.0f;
+
+    LevelMeter() noexcept { designTruePeakFilter(); }
+
+    // The layout sets each channel's loudness weight; without one every channel counts fully.
+    void prepare (double newSampleRate, int numChannelsIn, const juce::AudioChannelSet& layout = {}) noexcept
+    {
+        sampleRate = newSampleRate;
+        numChannels = juce::jlimit (1, maxMeterChannels, numChannelsIn);
+        numGroups = (numChannels + lanes - 1) / lanes;
+
+        // Lanes past the last channel run on silence and weigh nothing
+        for (int ch = 0; ch < (int) loudnessWeights.size(); ++ch)
+            loudnessWeights[(size_t) ch] = ch < numChannels ? loudnessWeightOf (layout.getTypeOfChannel (ch)) : 0.0;
+
+        rmsCoeff = (float) (1.0 - std::exp (-1.0 / (rmsSeconds * sampleRate)));
+        subBlockLength = juce::jmax (1, (int) (sampleRate * subBlockSeconds));
+        designKWeighting();
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        for (auto& g : groups)
+            g = {};
+
+        levels.fill ({});
+
+        energies.fill ({});
+        pendingEnergy = 0.0;
+        pendingSamples = 0;
+        energyIndex = 0;
+        published.store (makeSnapshot());
+    }
+
+    // Reads the first numChannelsToRead channels; the others show channel 0, which is
+    // what the processor's mono path leaves in them. Returns the block's sample peak.
+    template <typename SampleType>
+    float process (const juce::AudioBuffer<SampleType>& buffer, int numChannelsToRead, int numSamples) noexcept
+    {
+        const int n = juce::jlimit (1, numChannels, numChannelsToRead);
+        std::array<const SampleType*, (size_t) maxMeterChannels> sources {};
+        std::array<float, (size_t) maxMeterChannels> peaks {};
+        float blockPeak = 0.0f;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            sources[(size_t) ch] = buffer.getReadPointer (ch < n ? ch : 0);
+
+            if (ch < n)
+            {
+                const auto range = juce::FloatVectorOperations::findMinAndMax (sources[(size_t) ch], numSamples);
+                peaks[(size_t) ch] = (float) juce::jmax (-range.getStart(), range.getEnd());
+            }
+            else
+            {
+                peaks[(size_t) ch] = peaks[0];
+            }
+
+            blockPeak = juce::jmax (blockPeak, peaks[(size_t) ch]);
+        }
+
+        double blockEnergy = 0.0;
+        const auto fall = peakFallFor (numSamples);
+
+        for (int g = 0; g < numGroups; ++g)
+        {
+            const auto truePeak = runGroup (groups[(size_t) g], g * lanes, sources.data() + g * lanes, numSamples, blockEnergy);
+
+            for (int lane = 0, ch = g * lanes; lane < lanes && ch < numChannels; ++lane, ++ch)
+            {
+                auto& l = levels[(size_t) ch];
+                const auto peak = peaks[(size_t) ch];
+
+                l.peak = juce::jmax (peak, l.peak * fall);
+                l.truePeak = juce::jmax (juce::jmax (truePeak.get ((size_t) lane), peak), l.truePeak * fall);
+                l.rms = std::sqrt (groups[(size_t) g].meanSquare.get ((size_t) lane));
+            }
+        }
+
+        endBlock (blockEnergy, numSamples);
+        return blockPeak;
+    }
+
+    // A silent block, without reading it: levels fall and the loudness window fills with silence.
+    void processSilence (int numSamples) noexcept
+    {
+        const auto rmsFall = std::pow (1.0f - rmsCoeff, (float) numSamples);
+        const auto peakFall = peakFallFor (numSamples);
+
+        for (int g = 0; g < numGroups; ++g)
+        {
+            auto& group = groups[(size_t) g];
+            const auto meanSquare = group.meanSquare * rmsFall;
+            group = {};
+            group.meanSquare = meanSquare;
+        }
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto& l = levels[(size_t) ch];
+            l.rms = std::sqrt (groups[(size_t) (ch / lanes)].meanSquare.get ((size_t) (ch % lanes)));
+            l.peak *= peakFall;
+            l.truePeak *= peakFall;
+        }
+
+        endBlock (0.0, numSamples);
+    }
+
+    LevelSnapshot getSnapshot() const noexcept { return published.load(); }
+
+private:
+    // ===== True-peak interpolator =====
+    // 4x polyphase windowed sinc, 12 taps per phase. Phase 0 lands on the input samples
+    // (a pure delay), so only phases 1..3 are computed; the sample peak covers phase 0.
+    static constexpr int oversampling = 4;
+    static constexpr int tapsPerPhase = 12;
+    static_assert (oversampling == 4, "runGroup() computes phases 1..3");
+
+    std::array<std::array<Vec, tapsPerPhase>, oversampling - 1> phaseTaps {}; // each tap in every lane
+
+    void designTruePeakFilter() noexcept
+    {
+        constexpr int numTaps = oversampling * tapsPerPhase;
+        constexpr double centre = numTaps / 2;
+
+        for (int p = 1; p < oversampling; ++p)
+            for (int k = 0; k < tapsPerPhase; ++k)
+            {
+                const double t = (k * oversampling + p - centre) / (double) oversampling;
+                const double w = (k * oversampling + p - centre) / (centre + 1.0);
+                const double sinc = std::sin (juce::MathConstants<double>::pi * t) / (juce::MathConstants<double>::pi * t);
+                const double blackman = 0.42 + 0.5 * std::cos (juce::MathConstants<double>::pi * w)
+                                      + 0.08 * std::cos (juce::MathConstants<double>::twoPi * w);
+
+                // The window runs oldest to newest, so tap k lines up with slot tapsPerPhase - 1 - k
+                phaseTaps[(size_t) p - 1][(size_t) (tapsPerPhase - 1 - k)] = Vec::expand ((float) (sinc * blackman));
+            }
+    }
+
+    // ===== K-weighting (BS.1770: high shelf, then the RLB high-pass) =====
+    // Transposed direct form II, one channel per lane
+    struct Biquad
+    {
+        Vec s1 = Vec::expand (0.0f), s2 = Vec::expand (0.0f);
+
+        Vec process (Vec x, const std::array<Vec, 5>& c) noexcept // b0 b1 b2 a1 a2
+        {
+            const auto y = c[0] * x + s1;
+            s1 = c[1] * x - c[3] * y + s2;
+            s2 = c[2] * x - c[4] * y;
+            return y;
+        }
+    };
+
+    std::array<Vec, 5> shelfCoeffs {}, highPassCoeffs {};
+
+    static std::array<Vec, 5> expandCoeffs (std::initializer_list<double> c) noexcept
+    {
+        std::array<Vec, 5> v {};
+        std::transform (c.begin(), c.end(), v.begin(), [] (double x) { return Vec::expand ((float) x); });
+        return v;
+    }
+
+    void designKWeighting() noexcept
+    {
+        {
+            constexpr double f0 = 1681.974450955533, gainDb = 3.999843853973347, q = 0.7071752369554196;
+            const double k = std::tan (juce::MathConstants<double>::pi * f0 / sampleRate);
+            const double vh = std::pow (10.0, gainDb / 20.0);
+            const double vb = std::pow (vh, 0.4996667741545416);
+            const double a0 = 1.0 + k / q + k * k;
+
+            shelfCoeffs = expandCoeffs ({ (vh + vb * k / q + k * k) / a0, 2.0 * (k * k - vh) / a0, (vh - vb * k / q + k * k) / a0,
+                                          2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0 });
+        }
+
+        {
+            constexpr double f0 = 38.13547087602444, q = 0.5003270373238773;
+            const double k = std::tan (juce::MathConstants<double>::pi * f0 / sampleRate);
+            const double a0 = 1.0 + k / q + k * k;
+
+            highPassCoeffs = expandCoeffs ({ 1.0, -2.0, 1.0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0 });
+        }
+    }
+
+    // ===== Channel groups =====
+    // `lanes` channels each; the last group's spare lanes run on silence.
+    struct GroupState
+    {
+        Vec meanSquare = Vec::expand (0.0f);
+        Biquad shelf, highPass;
+        std::array<Vec, tapsPerPhase - 1> history {}; // last frames of the previous chunk
+    };
+
+    static constexpr int maxGroups = (maxMeterChannels + lanes - 1) / lanes;
+    static constexpr int chunkSize = 64;
+
+    std::array<GroupState, (size_t) maxGroups> groups;
+    std::array<ChannelLevels, (size_t) maxMeterChannels> levels;
+    std::array<double, (size_t) (maxGroups * lanes)> loudnessWeights {};
+    int numChannels = maxMeterChannels, numGroups = maxGroups;
+    double sampleRate = 44100.0;
+    float rmsCoeff = 0.0f;
+
+    // Interleaved frames of one chunk, behind the true-peak history it continues
+    std::array<Vec, (size_t) (tapsPerPhase - 1 + chunkSize)> frames {};
+
+    float peakFallFor (int numSamples) const noexcept
+    {
+        return (float) std::pow (10.0, -peakFallDbPerSecond / 20.0 * numSamples / sampleRate);
+    }
+
+    // One group of channels through RMS, K-weighting and the true-peak interpolator. Adds
+    // their weighted K energy to `energy`; returns each lane's inter-sample peak.
+    template <typename SampleType>
+    Vec runGroup (GroupState& g, int firstChannel, const SampleType* const* sources, int numSamples, double& energy) noexcept
+    {
+        const auto rms = Vec::expand (rmsCoeff);
+        const int count = juce::jmin (lanes, numChannels - firstChannel);
+        auto* x = frames.data() + (tapsPerPhase - 1);
+        auto* raw = reinterpret_cast<float*> (x);
+        auto truePeak = Vec::expand (0.0f);
+
+        std::copy (g.history.begin(), g.history.end(), frames.begin());
+
+        for (int offset = 0; offset < numSamples; offset += chunkSize)
+        {
+            const int len = juce::jmin (chunkSize, numSamples - offset);
+
+            if (count < lanes)
+                std::fill (x, x + len, Vec::expand (0.0f));
+
+            for (int lane = 0; lane < count; ++lane)
+            {
+                const auto* src = sources[lane] + offset;
+                for (int i = 0; i < len; ++i)
+                    raw[i * lanes + lane] = (float) src[i];
+            }
+
+            auto ms = g.meanSquare, chunkEnergy = Vec::expand (0.0f);
+
+            for (int i = 0; i < len; ++i)
+            {
+                const auto s = x[i];
+                ms += rms * (s * s - ms);
+
+                const auto k = g.highPass.process (g.shelf.process (s, shelfCoeffs), highPassCoeffs);
+                chunkEnergy += k * k;
+            }
+
+            // Each phase is a dot product over the window ending at frame i
+            for (int i = 0; i < len; ++i)
+            {
+                const auto* window = x + i - (tapsPerPhase - 1);
+                auto y1 = Vec::expand (0.0f), y2 = y1, y3 = y1;
+
+                for (size_t t = 0; t < (size_t) tapsPerPhase; ++t)
+                {
+                    y1 += window[t] * phaseTaps[0][t];
+                    y2 += window[t] * phaseTaps[1][t];
+                    y3 += window[t] * phaseTaps[2][t];
+                }
+
+                truePeak = Vec::max (truePeak, Vec::max (Vec::abs (y1), Vec::max (Vec::abs (y2), Vec::abs (y3))));
+            }
+
+            g.meanSquare = ms;
+            std::copy (x + len - (tapsPerPhase - 1), x + len, frames.begin());
+
+            for (int lane = 0; lane < count; ++lane)
+                energy += loudnessWeights[(size_t) (firstChannel + lane)] * (double) chunkEnergy.get ((size_t) lane);
+        }
+
+        std::copy (frames.begin(), frames.begin() + (tapsPerPhase - 1), g.history.begin());
+        return truePeak;
+    }
+
+    // BS.1770 channel weights: the surrounds count 1.41, the LFE not at all
+    static double loudnessWeightOf (juce::AudioChannelSet::ChannelType type) noexcept
+    {
+        switch (type)
+        {
+            case juce::AudioChannelSet::LFE:
+            case juce::AudioChannelSet::LFE2:
+                return 0.0;
+
+            case juce::AudioChannelSet::leftSurround:
+            case juce::AudioChannelSet::rightSurround:
+            case juce::AudioChannelSet::leftSurroundSide:
+            case juce::AudioChannelSet::rightSurroundSide:
+            case juce::AudioChannelSet::leftSurroundRear:
+            case juce::AudioChannelSet::rightSurroundRear:
+                return 1.41;
+
+            default:
+                return 1.0;
+        }
+    }
+
+    // ===== Short-term loudness =====
+    // K-weighted energy in sub-blocks of at least 100 ms; the last 30 make up the window.
+    static constexpr double subBlockSeconds = 0.1;
+    static constexpr size_t numSubBlocks = 30;
+
+    struct SubBlock { double energy = 0.0; int samples = 0; };
+    std::array<SubBlock, numSubBlocks> energies {};
+    size_t energyIndex = 0;
+    double pendingEnergy = 0.0;
+    int pendingSamples = 0, subBlockLength = 4410;
+
+    SeqLock<LevelSnapshot> published;
+
+    void endBlock (double blockEnergy, int numSamples) noexcept
+    {
+        pendingEnergy += blockEnergy;
+        pendingSamples += numSamples;
+
+        if (pendingSamples >= subBlockLength)
+        {
+            energies[energyIndex] = { pendingEnergy, pendingSamples };
+            energyIndex = (energyIndex + 1) % numSubBlocks;
+            pendingEnergy = 0.0;
+            pendingSamples = 0;
+        }
+
+        published.store (makeSnapshot());
+    }
+
+    LevelSnapshot makeSnapshot() const noexcept
+    {
+        LevelSnapshot s;
+        s.numChannels = numChannels;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            s.channels[(size_t) ch] = levels[(size_t) ch];
+
+        double energy = 0.0;
+        juce::int64 samples = 0;
+
+        for (const auto& b : energies)
+        {
+            energy += b.energy;
+            samples += b.samples;
+        }
+
+        // Channel weights are already in the sub-block energies
+        if (samples > 0 && energy > 0.0)
+            s.shortTermLufs = juce::jmax (silentLufs, (float) (-0.691 + 10.0 * std::log10 (energy / (double) samples)));
+
+        return s;
+    }
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include <JuceHeader.h>
+#include "DspLoadMeter.h"
+
+// ===== Wet/dry pipeline =====
+// Each stage lands its crossfade in a single pass over the block: per-sample stages fuse
+// it into their own loop with crossfade() on scalars, block processors write their wet
+// signal next to the untouched dry input and runBlockStage() blends the two once.
+// A stage at 100% mix processes the buffer in place and never touches the scratch.
+// runBlockStage() counts the sweeps it makes over the buffers into a BufferTraffic.
+namespace MixPipeline
+{
+    static constexpr float minMix   = 0.0001f; // at or below: stage is skipped
+    static constexpr float fullyWet = 0.9999f; // at or above: stage runs in place
+
+    template <typename SampleType>
+    inline SampleType crossfade (SampleType dry, SampleType wet, SampleType mix) noexcept
+    {
+        return dry + mix * (wet - dry);
+    }
+
+    // dst = dry + mix * (wet - dry). dst may alias dry or wet.
+    template <typename SampleType>
+    inline void crossfade (SampleType* dst, const SampleType* dry, const SampleType* wet, int numSamples, SampleType mix) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+            dst[i] = dry[i] + mix * (wet[i] - dry[i]);
+    }
+
+    // Runs a juce::dsp style processor as one stage. `process` receives either a
+    // ProcessContextReplacing (fully wet) or a ProcessContextNonReplacing reading `io`
+    // and writing `wetScratch`, so it must be a generic lambda.
+    template <typename SampleType, typename ProcessFn>
+    void runBlockStage (juce::AudioBuffer<SampleType>& io, juce::AudioBuffer<SampleType>& wetScratch,
+                        int numCh, int numSamples, float mix, BufferTraffic& traffic, ProcessFn&& process)
+    {
+        auto ioBlock = juce::dsp::AudioBlock<SampleType> (io).getSubsetChannelBlock (0, (size_t) numCh)
+                                                             .getSubBlock (0, (size_t) numSamples);
+
+        if (mix >= fullyWet)
+        {
+            process (juce::dsp::ProcessContextReplacing<SampleType> (ioBlock));
+            traffic.add<SampleType> (2, numCh, numSamples); // read io, write io
+            return;
+        }
+
+        auto wetBlock = juce::dsp::AudioBlock<SampleType> (wetScratch).getSubsetChannelBlock (0, (size_t) numCh)
+                                                                      .getSubBlock (0, (size_t) numSamples);
+
+        process (juce::dsp::ProcessContextNonReplacing<SampleType> (ioBlock, wetBlock));
+
+        for (int ch = 0; ch < numCh; ++ch)
+            crossfade (io.getWritePointer (ch), io.getReadPointer (ch), wetScratch.getReadPointer (ch), numSamples, (SampleType) mix);
+
+        traffic.add<SampleType> (5, numCh, numSamples); // read io, write wet; read both, write io
+    }
+}
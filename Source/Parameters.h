@@ -0,0 +1,191 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// ===== Parameter table =====
+// Single source of truth for every automatable parameter. createParameterLayout(),
+// the cached atomic handles and the per-block snapshot are all generated from it,
+// so the audio thread never has to resolve a parameter by string. Choice parameters
+// hold their index (Min 0, Max the last index); the labels live in choicesOf().
+//
+//      ID             Name               Kind   Min      Max       Step     Skew   Default
+#define ULTIMATEADLIBS_PARAMETERS(X) \
+    X (IN_GAIN,    "Input Gain",      Float, -24.0f,  24.0f,    0.01f,   1.0f,  0.0f)     \
+    X (OUT_GAIN,   "Output Gain",     Float, -24.0f,  24.0f,    0.01f,   1.0f,  0.0f)     \
+    X (GLOBAL_MIX, "Global Mix",      Float,   0.0f,  100.0f,   0.01f,   1.0f,  100.0f)   \
+                                                                                           \
+    X (FILT_ON,    "Filters On",      Bool,    0.0f,  1.0f,     1.0f,    1.0f,  1.0f)     \
+    X (HPF_HZ,     "HPF (Hz)",        Float,  20.0f,  20000.0f, 1.0f,    0.5f,  120.0f)   \
+    X (LPF_HZ,     "LPF (Hz)",        Float,  20.0f,  20000.0f, 1.0f,    0.5f,  16000.0f) \
+    X (FILT_MIX,   "Filters Mix",     Float,   0.0f,  100.0f,   0.01f,   1.0f,  100.0f)   \
+                                                                                           \
+    X (DIST_ON,    "Dist On",         Bool,    0.0f,  1.0f,     1.0f,    1.0f,  1.0f)     \
+    X (DIST_DRIVE, "Drive (dB)",      Float,   0.0f,  24.0f,    0.01f,   1.0f,  6.0f)     \
+    X (DIST_QUALITY, "Dist Quality",  Choice,  0.0f,  3.0f,     1.0f,    1.0f,  0.0f)     \
+    X (DIST_MIX,   "Dist Mix",        Float,   0.0f,  100.0f,   0.01f,   1.0f,  30.0f)    \
+                                                                                           \
+    X (CHO_ON,     "Chorus On",       Bool,    0.0f,  1.0f,     1.0f,    1.0f,  1.0f)     \
+    X (CHO_RATE,   "Chorus Rate",     Float,   0.05f, 8.0f,     0.001f,  0.5f,  0.8f)     \
+    X (CHO_DEPTH,  "Chorus Depth",    Float,   0.0f,  1.0f,     0.001f,  1.0f,  0.25f)    \
+    X (CHO_MIX,    "Chorus Mix",      Float,   0.0f,  100.0f,   0.01f,   1.0f,  25.0f)    \
+                                                                                           \
+    X (FLA_ON,     "Flanger On",      Bool,    0.0f,  1.0f,     1.0f,    1.0f,  1.0f)     \
+    X (FLA_RATE,   "Flanger Rate",    Float,   0.05f, 5.0f,     0.001f,  0.5f,  0.35f)    \
+    X (FLA_DEPTH,  "Flanger Depth",   Float,   0.0f,  1.0f,     0.001f,  1.0f,  0.6f)     \
+    X (FLA_FB,     "Flanger FB",      Float,  -0.95f, 0.95f,    0.001f,  1.0f,  0.2f)     \
+    X (FLA_MIX,    "Flanger Mix",     Float,   0.0f,  100.0f,   0.01f,   1.0f,  20.0f)    \
+                                                                                           \
+    X (DLY_ON,     "Delay On",        Bool,    0.0f,  1.0f,     1.0f,    1.0f,  1.0f)     \
+    X (DLY_TIME,   "Delay Time (ms)", Float,   1.0f,  1200.0f,  0.01f,   0.5f,  220.0f)   \
+    X (DLY_SYNC,   "Delay Sync",      Choice,  0.0f,  12.0f,    1.0f,    1.0f,  0.0f)     \
+    X (DLY_FB,     "Delay Feedback",  Float,   0.0f,  0.95f,    0.001f,  1.0f,  0.35f)    \
+    X (DLY_MIX,    "Delay Mix",       Float,   0.0f,  100.0f,   0.01f,   1.0f,  22.0f)    \
+                                                                                           \
+    X (REV_ON,     "Reverb On",       Bool,    0.0f,  1.0f,     1.0f,    1.0f,  1.0f)     \
+    X (REV_ALGO,   "Reverb Algorithm", Choice, 0.0f,  2.0f,     1.0f,    1.0f,  0.0f)     \
+    X (REV_SIZE,   "Room Size",       Float,   0.0f,  1.0f,     0.001f,  1.0f,  0.35f)    \
+    X (REV_DAMP,   "Damping",         Float,   0.0f,  1.0f,     0.001f,  1.0f,  0.5f)     \
+    X (REV_MIX,    "Reverb Mix",      Float,   0.0f,  100.0f,   0.01f,   1.0f,  18.0f)
+
+enum class Param : int
+{
+   #define ULTIMATEADLIBS_PARAM_ENUM(id, ...) id,
+    ULTIMATEADLIBS_PARAMETERS (ULTIMATEADLIBS_PARAM_ENUM)
+   #undef ULTIMATEADLIBS_PARAM_ENUM
+    count
+};
+
+static constexpr int numParameters = (int) Param::count;
+
+enum class ParamKind { Float, Bool, Choice };
+
+struct ParamSpec
+{
+    const char* id;
+    const char* name;
+    ParamKind kind;
+    float minValue, maxValue, step, skew, defaultValue;
+};
+
+inline constexpr std::array<ParamSpec, numParameters> paramSpecs
+{{
+   #define ULTIMATEADLIBS_PARAM_SPEC(id, name, kind, mn, mx, step, skew, def) \
+    { #id, name, ParamKind::kind, mn, mx, step, skew, def },
+    ULTIMATEADLIBS_PARAMETERS (ULTIMATEADLIBS_PARAM_SPEC)
+   #undef ULTIMATEADLIBS_PARAM_SPEC
+}};
+
+constexpr const ParamSpec& specOf (Param p) noexcept { return paramSpecs[(size_t) p]; }
+constexpr const char* paramId (Param p) noexcept     { return specOf (p).id; }
+
+// ===== Choice labels =====
+inline juce::StringArray choicesOf (Param p)
+{
+    switch (p)
+    {
+        case Param::DIST_QUALITY: return { "1x", "2x", "4x", "8x" };
+        case Param::DLY_SYNC: return { "Off", "1/32", "1/16T", "1/16", "1/16D", "1/8T", "1/8",
+                                       "1/8D", "1/4T", "1/4", "1/4D", "1/2", "1/1" };
+        case Param::REV_ALGO: return { "Classic", "FDN", "Convolution" };
+        default:              return {};
+    }
+}
+
+// Length in quarter notes of each DLY_SYNC entry; index 0 (Off) is unused.
+inline constexpr std::array<double, 13> delaySyncBeats { 0.0, 0.125, 0.25 * 2.0 / 3.0, 0.25, 0.375, 0.5 * 2.0 / 3.0, 0.5,
+                                                         0.75, 2.0 / 3.0, 1.0, 1.5, 2.0, 4.0 };
+
+// ===== Change masks =====
+using ParamMask = std::uint64_t;
+static_assert (numParameters <= 64, "ParamMask holds one bit per parameter");
+
+constexpr ParamMask maskOf (Param p) noexcept { return ParamMask (1) << (int) p; }
+
+template <typename... Params>
+constexpr ParamMask maskOf (Param p, Params... rest) noexcept { return maskOf (p) | maskOf (rest...); }
+
+static constexpr ParamMask allParamsMask = (numParameters == 64) ? ~ParamMask (0)
+                                                                   : (ParamMask (1) << numParameters) - 1;
+
+// Parameters that force a stage to rebuild its internal state (coefficients, LFOs...).
+// Mix and on/off values are read straight from the snapshot and never reconfigure anything.
+namespace StageMasks
+{
+    static constexpr ParamMask filter = maskOf (Param::HPF_HZ, Param::LPF_HZ);
+    static constexpr ParamMask dist = maskOf (Param::DIST_DRIVE, Param::DIST_QUALITY);
+    static constexpr ParamMask chorus = maskOf (Param::CHO_RATE, Param::CHO_DEPTH);
+    static constexpr ParamMask flanger = maskOf (Param::FLA_RATE, Param::FLA_DEPTH, Param::FLA_FB);
+    static constexpr ParamMask delay = maskOf (Param::DLY_TIME, Param::DLY_SYNC, Param::DLY_FB);
+    static constexpr ParamMask reverb = maskOf (Param::REV_ALGO, Param::REV_SIZE, Param::REV_DAMP);
+
+    // Not a stage: on/mix values decide which stages go into the execution plan
+    static constexpr ParamMask enable = maskOf (Param::FILT_ON, Param::FILT_MIX, Param::DIST_ON, Param::DIST_MIX,
+                                                Param::CHO_ON, Param::CHO_MIX, Param::FLA_ON, Param::FLA_MIX,
+                                                Param::DLY_ON, Param::DLY_MIX, Param::REV_ON, Param::REV_MIX);
+}
+
+// ===== Per-block snapshot =====
+struct ParameterSnapshot
+{
+    std::array<float, numParameters> values {};
+    ParamMask changed = allParamsMask; // bits set for values that moved since the previous block
+
+    float operator[] (Param p) const noexcept       { return values[(size_t) p]; }
+    bool isOn (Param p) const noexcept              { return values[(size_t) p] > 0.5f; }
+    int choice (Param p) const noexcept             { return juce::roundToInt (values[(size_t) p]); }
+    float percent01 (Param p) const noexcept        { return juce::jlimit (0.0f, 1.0f, values[(size_t) p] / 100.0f); }
+    bool anyChanged (ParamMask mask) const noexcept { return (changed & mask) != 0; }
+};
+
+// ===== Cached handles =====
+// Resolves every parameter ID once; update() is a straight walk over the table.
+class ParameterCache
+{
+public:
+    explicit ParameterCache (juce::AudioProcessorValueTreeState& vts)
+    {
+        for (size_t i = 0; i < handles.size(); ++i)
+        {
+            handles[i] = vts.getRawParameterValue (paramSpecs[i].id);
+            parameters[i] = vts.getParameter (paramSpecs[i].id);
+            jassert (handles[i] != nullptr && parameters[i] != nullptr);
+        }
+    }
+
+    // Any thread: the current value, in the parameter's own range
+    float get (Param p) const noexcept { return handles[(size_t) p]->load (std::memory_order_relaxed); }
+
+    // Message thread: sets a value in the parameter's own range and tells the host. A
+    // value that hasn't moved is left alone.
+    void set (Param p, float value) const
+    {
+        auto& param = *parameters[(size_t) p];
+        const float normalised = param.convertTo0to1 (value);
+
+        if (param.getValue() != normalised)
+            param.setValueNotifyingHost (normalised);
+    }
+
+    void update (ParameterSnapshot& s) const noexcept
+    {
+        ParamMask changed = 0;
+
+        for (size_t i = 0; i < handles.size(); ++i)
+        {
+            const float v = handles[i]->load (std::memory_order_relaxed);
+            if (v != s.values[i])
+            {
+                s.values[i] = v;
+                changed |= ParamMask (1) << i;
+            }
+        }
+
+        s.changed = changed;
+    }
+
+private:
+    std::array<std::atomic<float>*, numParameters> handles {};
+    std::array<juce::RangedAudioParameter*, numParameters> parameters {};
+};
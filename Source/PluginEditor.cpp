@@ -4,21 +4,29 @@ UltimateAdlibsAudioProcessorEditor::UltimateAdlibsAudioProcessorEditor (Ultimate
     : AudioProcessorEditor (&p), audioProcessor (p)
 {
     setLookAndFeel (&lnf);
+    setOpaque (true); // the background covers every pixel
 
     auto& vts = audioProcessor.apvts;
 
-    auto bindS = [&] (juce::Slider& s, const char* id, std::unique_ptr<SliderAttachment>& a)
+    auto bindS = [&] (juce::Slider& s, Param id, std::unique_ptr<SliderAttachment>& a)
     {
         makeKnob (s);
         addAndMakeVisible (s);
-        a = std::make_unique<SliderAttachment> (vts, id, s);
+        a = std::make_unique<SliderAttachment> (vts, paramId (id), s);
     };
 
-    auto bindB = [&] (juce::ToggleButton& b, const char* id, const juce::String& label, std::unique_ptr<ButtonAttachment>& a)
+    auto bindB = [&] (juce::ToggleButton& b, Param id, const juce::String& label, std::unique_ptr<ButtonAttachment>& a)
     {
         addAndMakeVisible (b);
         b.setButtonText (label);
-        a = std::make_unique<ButtonAttachment> (vts, id, b);
+        a = std::make_unique<ButtonAttachment> (vts, paramId (id), b);
+    };
+
+    auto bindC = [&] (juce::ComboBox& c, Param id, std::unique_ptr<ComboBoxAttachment>& a)
+    {
+        c.addItemList (choicesOf (id), 1);
+        addAndMakeVisible (c);
+        a = std::make_unique<ComboBoxAttachment> (vts, paramId (id), c);
     };
 
     // Title / preset
@@ -28,15 +36,28 @@ UltimateAdlibsAudioProcessorEditor::UltimateAdlibsAudioProcessorEditor (Ultimate
     title.setFont (juce::Font (22.0f, juce::Font::bold));
     addAndMakeVisible (title);
 
-    presetBox.addItem ("Default", 1);
-    presetBox.addItem ("Wide Throw", 2);
-    presetBox.addItem ("Tight Double", 3);
-    presetBox.setSelectedId (1);
+    refreshPresets();
+    presetBox.onChange = [this]
+    {
+        if (const auto index = presetBox.getSelectedId() - 1; index >= 0 && index != audioProcessor.getCurrentProgram())
+            audioProcessor.setCurrentProgram (index);
+    };
     addAndMakeVisible (presetBox);
+    audioProcessor.getPresetBank().addChangeListener (this);
+
+    presetMenu.setButtonText ("...");
+    presetMenu.onClick = [this] { showPresetMenu(); };
+    addAndMakeVisible (presetMenu);
 
     // VU meters
     addAndMakeVisible (inVu);
     addAndMakeVisible (outVu);
+    meterScheduler.add (inVu);
+    meterScheduler.add (outVu);
+
+    // Analyzer
+    addAndMakeVisible (analyzer);
+    meterScheduler.add (analyzer);
 
     inLbl.setText ("IN", juce::dontSendNotification);
     outLbl.setText ("OUT", juce::dontSendNotification);
@@ -48,52 +69,97 @@ UltimateAdlibsAudioProcessorEditor::UltimateAdlibsAudioProcessorEditor (Ultimate
         addAndMakeVisible (*l);
     }
 
+    // DSP load readouts (absent in lean builds)
+    if (DspLoadMeter::enabled)
+    {
+        for (size_t i = 0; i < loadReadouts.size(); ++i)
+        {
+            loadReadouts[i] = std::make_unique<StageLoadReadout> ([this, i] { return audioProcessor.getDspLoad().stages[i]; });
+            addAndMakeVisible (*loadReadouts[i]);
+            meterScheduler.add (*loadReadouts[i]);
+        }
+    }
+
     // Global
-    bindS (inGain, "IN_GAIN", inGainA);
-    bindS (globalMix, "GLOBAL_MIX", globalMixA);
-    bindS (outGain, "OUT_GAIN", outGainA);
+    bindS (inGain, Param::IN_GAIN, inGainA);
+    bindS (globalMix, Param::GLOBAL_MIX, globalMixA);
+    bindS (outGain, Param::OUT_GAIN, outGainA);
 
     // Filters
-    bindB (filtOn, "FILT_ON", "Filters", filtOnA);
-    bindS (hpf, "HPF_HZ", hpfA);
-    bindS (lpf, "LPF_HZ", lpfA);
-    bindS (filtMix, "FILT_MIX", filtMixA);
+    bindB (filtOn, Param::FILT_ON, "Filters", filtOnA);
+    bindS (hpf, Param::HPF_HZ, hpfA);
+    bindS (lpf, Param::LPF_HZ, lpfA);
+    bindS (filtMix, Param::FILT_MIX, filtMixA);
 
     // Dist
-    bindB (distOn, "DIST_ON", "Dist", distOnA);
-    bindS (distDrive, "DIST_DRIVE", distDriveA);
-    bindS (distMix, "DIST_MIX", distMixA);
+    bindB (distOn, Param::DIST_ON, "Dist", distOnA);
+    bindS (distDrive, Param::DIST_DRIVE, distDriveA);
+    bindS (distMix, Param::DIST_MIX, distMixA);
+    bindC (distQuality, Param::DIST_QUALITY, distQualityA);
 
     // Chorus
-    bindB (choOn, "CHO_ON", "Chorus", choOnA);
-    bindS (choRate, "CHO_RATE", choRateA);
-    bindS (choDepth, "CHO_DEPTH", choDepthA);
-    bindS (choMix, "CHO_MIX", choMixA);
+    bindB (choOn, Param::CHO_ON, "Chorus", choOnA);
+    bindS (choRate, Param::CHO_RATE, choRateA);
+    bindS (choDepth, Param::CHO_DEPTH, choDepthA);
+    bindS (choMix, Param::CHO_MIX, choMixA);
 
     // Flanger
-    bindB (flaOn, "FLA_ON", "Flanger", flaOnA);
-    bindS (flaRate, "FLA_RATE", flaRateA);
-    bindS (flaDepth, "FLA_DEPTH", flaDepthA);
-    bindS (flaFb, "FLA_FB", flaFbA);
-    bindS (flaMix, "FLA_MIX", flaMixA);
+    bindB (flaOn, Param::FLA_ON, "Flanger", flaOnA);
+    bindS (flaRate, Param::FLA_RATE, flaRateA);
+    bindS (flaDepth, Param::FLA_DEPTH, flaDepthA);
+    bindS (flaFb, Param::FLA_FB, flaFbA);
+    bindS (flaMix, Param::FLA_MIX, flaMixA);
 
     // Delay
-    bindB (dlyOn, "DLY_ON", "Delay", dlyOnA);
-    bindS (dlyTime, "DLY_TIME", dlyTimeA);
-    bindS (dlyFb, "DLY_FB", dlyFbA);
-    bindS (dlyMix, "DLY_MIX", dlyMixA);
+    bindB (dlyOn, Param::DLY_ON, "Delay", dlyOnA);
+    bindS (dlyTime, Param::DLY_TIME, dlyTimeA);
+    bindS (dlyFb, Param::DLY_FB, dlyFbA);
+    bindS (dlyMix, Param::DLY_MIX, dlyMixA);
+    bindC (dlySync, Param::DLY_SYNC, dlySyncA);
+
+    // A synced delay ignores the free time
+    dlySync.onChange = [this] { dlyTime.setEnabled (dlySync.getSelectedItemIndex() <= 0); };
+    dlySync.onChange();
 
     // Reverb
-    bindB (revOn, "REV_ON", "Reverb", revOnA);
-    bindS (revSize, "REV_SIZE", revSizeA);
-    bindS (revDamp, "REV_DAMP", revDampA);
-    bindS (revMix, "REV_MIX", revMixA);
+    bindB (revOn, Param::REV_ON, "Reverb", revOnA);
+    bindS (revSize, Param::REV_SIZE, revSizeA);
+    bindS (revDamp, Param::REV_DAMP, revDampA);
+    bindS (revMix, Param::REV_MIX, revMixA);
+    bindC (revAlgo, Param::REV_ALGO, revAlgoA);
+
+    // The IR menu only matters for the convolution algorithm
+    addAndMakeVisible (revIr);
+    revIr.onClick = [this] { showImpulseResponseMenu(); };
+    revAlgo.onChange = [this] { revIr.setEnabled (revAlgo.getSelectedItemIndex() == 2); };
+    revAlgo.onChange();
+    updateImpulseResponseButton();
+
+    // Chain order
+    for (int i = 0; i < numStages; ++i)
+    {
+        const auto stage = (StageId) i;
 
-    setSize (1080, 580);
+        for (auto* b : { &moveEarlier[(size_t) i], &moveLater[(size_t) i] })
+            addAndMakeVisible (*b);
+
+        moveEarlier[(size_t) i].setButtonText ("<");
+        moveLater[(size_t) i].setButtonText (">");
+        moveEarlier[(size_t) i].setTooltip ("Move earlier in the chain");
+        moveLater[(size_t) i].setTooltip ("Move later in the chain");
+        moveEarlier[(size_t) i].onClick = [this, stage] { moveStage (stage, -1); };
+        moveLater[(size_t) i].onClick   = [this, stage] { moveStage (stage, +1); };
+    }
+
+    audioProcessor.apvts.state.addListener (this);
+
+    setSize (1080, 720);
 }
 
 UltimateAdlibsAudioProcessorEditor::~UltimateAdlibsAudioProcessorEditor()
 {
+    audioProcessor.apvts.state.removeListener (this);
+    audioProcessor.getPresetBank().removeChangeListener (this);
     setLookAndFeel (nullptr);
 }
 
@@ -103,7 +169,40 @@ void UltimateAdlibsAudioProcessorEditor::makeKnob (juce::Slider& s)
     s.setTextBoxStyle (juce::Slider::TextBoxBelow, false, 86, 18);
 }
 
+void UltimateAdlibsAudioProcessorEditor::setRenderCaching (bool shouldCache)
+{
+    cacheBackground = shouldCache;
+    background = {};
+    lnf.setKnobCaching (shouldCache);
+    repaint();
+}
+
 void UltimateAdlibsAudioProcessorEditor::paint (juce::Graphics& g)
+{
+    if (! cacheBackground)
+    {
+        drawBackground (g);
+        return;
+    }
+
+    // Redrawn only after a layout change or a move to a display with another scale
+    const auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+    if (background.isNull() || scale != backgroundScale)
+    {
+        backgroundScale = scale;
+        background = juce::Image (juce::Image::RGB, juce::jmax (1, juce::roundToInt ((float) getWidth() * scale)),
+                                  juce::jmax (1, juce::roundToInt ((float) getHeight() * scale)), false);
+
+        juce::Graphics bg (background);
+        bg.addTransform (juce::AffineTransform::scale (scale));
+        drawBackground (bg);
+    }
+
+    g.drawImage (background, getLocalBounds().toFloat());
+}
+
+void UltimateAdlibsAudioProcessorEditor::drawBackground (juce::Graphics& g)
 {
     g.fillAll (juce::Colour (0xFF0B0B0B));
 
@@ -129,17 +228,31 @@ void UltimateAdlibsAudioProcessorEditor::paint (juce::Graphics& g)
         auto t = s.area.reduced (14).removeFromTop (18);
         g.drawText (s.name, t, juce::Justification::centredLeft);
     }
+
+    // Chain position, left of the move arrows
+    g.setFont (juce::Font (11.0f));
+    g.setColour (juce::Colours::white.withAlpha (0.45f));
+    for (auto& s : sections)
+    {
+        auto t = s.area.reduced (14).removeFromBottom (18);
+        g.drawText (juce::String (s.position + 1) + " / " + juce::String (numStages), t, juce::Justification::centredLeft);
+    }
 }
 
 void UltimateAdlibsAudioProcessorEditor::resized()
 {
+    background = {};
+
     auto r = getLocalBounds().reduced (10);
 
     // Top bar
     auto top = r.removeFromTop (66).reduced (10, 10);
 
     title.setBounds (top.removeFromLeft (280));
-    presetBox.setBounds (top.removeFromLeft (240).reduced (0, 12));
+    auto presetArea = top.removeFromLeft (240).reduced (0, 12);
+    presetMenu.setBounds (presetArea.removeFromRight (34));
+    presetArea.removeFromRight (6);
+    presetBox.setBounds (presetArea);
 
     // meters area
     auto meters = top.removeFromLeft (160);
@@ -163,6 +276,10 @@ void UltimateAdlibsAudioProcessorEditor::resized()
 
     r.removeFromTop (10);
 
+    // Analyzer strip along the bottom
+    analyzer.setBounds (r.removeFromBottom (130));
+    r.removeFromBottom (10);
+
     // Grid 2 rows x 3 cols
     auto grid = r;
     auto rowH = (grid.getHeight() - 10) / 2;
@@ -180,20 +297,36 @@ void UltimateAdlibsAudioProcessorEditor::resized()
     auto c23 = row2;
 
     sections = {{
-        { "FILTER",  c11 },
-        { "DIST",    c12 },
-        { "CHORUS",  c13 },
-        { "FLANGER", c21 },
-        { "DELAY",   c22 },
-        { "REVERB",  c23 },
+        { "FILTER",  {} },
+        { "DIST",    {} },
+        { "CHORUS",  {} },
+        { "FLANGER", {} },
+        { "DELAY",   {} },
+        { "REVERB",  {} },
     }};
 
-    auto place = [] (juce::Rectangle<int> area, juce::ToggleButton& on, std::initializer_list<juce::Component*> knobs)
+    // Cards in reading order follow the chain
+    const std::array<juce::Rectangle<int>, (size_t) numStages> cells { c11, c12, c13, c21, c22, c23 };
+    const auto order = audioProcessor.getChainOrder();
+
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        auto& section = sections[(size_t) order[i]];
+        section.area = cells[i];
+        section.position = (int) i;
+    }
+
+    auto place = [this] (StageId stage, juce::ToggleButton& on, std::initializer_list<juce::Component*> knobs)
     {
-        area = area.reduced (12);
+        auto area = sections[(size_t) stage].area.reduced (12);
         on.setBounds (area.removeFromTop (22));
         area.removeFromTop (8);
 
+        auto footer = area.removeFromBottom (20);
+        moveLater[(size_t) stage].setBounds (footer.removeFromRight (24));
+        footer.removeFromRight (4);
+        moveEarlier[(size_t) stage].setBounds (footer.removeFromRight (24));
+
         const int n = (int)knobs.size();
         const int w = area.getWidth() / juce::jmax (1, n);
 
@@ -201,11 +334,149 @@ void UltimateAdlibsAudioProcessorEditor::resized()
             k->setBounds (area.removeFromLeft (w).reduced (6));
     };
 
-    place (c11, filtOn, { &hpf, &lpf, &filtMix });
-    place (c12, distOn, { &distDrive, &distMix });
-    place (c13, choOn,  { &choRate, &choDepth, &choMix });
+    place (StageId::Filter,  filtOn, { &hpf, &lpf, &filtMix });
+    place (StageId::Dist,    distOn, { &distDrive, &distMix, &distQuality });
+    distQuality.setBounds (distQuality.getBounds().withSizeKeepingCentre (distQuality.getWidth(), 24));
+    place (StageId::Chorus,  choOn,  { &choRate, &choDepth, &choMix });
+
+    place (StageId::Flanger, flaOn,  { &flaRate, &flaDepth, &flaFb, &flaMix });
+    place (StageId::Delay,   dlyOn,  { &dlyTime, &dlyFb, &dlyMix, &dlySync });
+    dlySync.setBounds (dlySync.getBounds().withSizeKeepingCentre (dlySync.getWidth(), 24));
+    place (StageId::Reverb,  revOn,  { &revSize, &revDamp, &revMix, &revAlgo });
+    revAlgo.setBounds (revAlgo.getBounds().withSizeKeepingCentre (revAlgo.getWidth(), 24));
+
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        moveEarlier[(size_t) order[i]].setEnabled (i > 0);
+        moveLater[(size_t) order[i]].setEnabled (i + 1 < order.size());
+    }
+
+    // Load readouts share the title row, right of the section name
+    for (size_t i = 0; i < loadReadouts.size(); ++i)
+        if (loadReadouts[i] != nullptr)
+            loadReadouts[i]->setBounds (sections[i].area.reduced (12).removeFromTop (22).removeFromRight (110));
 
-    place (c21, flaOn,  { &flaRate, &flaDepth, &flaFb, &flaMix });
-    place (c22, dlyOn,  { &dlyTime, &dlyFb, &dlyMix });
-    place (c23, revOn,  { &revSize, &revDamp, &revMix });
+    revIr.setBounds (sections[(size_t) StageId::Reverb].area.reduced (12).removeFromTop (22).withTrimmedRight (120).removeFromRight (130));
+}
+
+void UltimateAdlibsAudioProcessorEditor::refreshPresets()
+{
+    const auto& bank = audioProcessor.getPresetBank();
+    presetBox.clear (juce::dontSendNotification);
+
+    for (int i = 0; i < bank.size(); ++i)
+    {
+        const auto* preset = bank.get (i);
+
+        if (i > 0 && ! preset->factory && bank.get (i - 1)->factory)
+            presetBox.addSeparator();
+
+        presetBox.addItem (preset->name, i + 1);
+    }
+
+    presetBox.setSelectedId (bank.getCurrent() + 1, juce::dontSendNotification);
+}
+
+void UltimateAdlibsAudioProcessorEditor::showPresetMenu()
+{
+    const auto current = audioProcessor.getCurrentProgram();
+    const auto* preset = audioProcessor.getPresetBank().get (current);
+
+    int numUser = 0;
+    for (int i = 0; i < audioProcessor.getPresetBank().size(); ++i)
+        numUser += audioProcessor.getPresetBank().get (i)->factory ? 0 : 1;
+
+    juce::PopupMenu menu;
+    menu.addItem ("Save as new preset...", [this, numUser]
+    {
+        showPresetNameDialog ("Save preset", "User " + juce::String (numUser + 1),
+                              [this] (const juce::String& name) { audioProcessor.saveUserPreset (name); });
+    });
+    menu.addItem ("Rename...", preset != nullptr && ! preset->factory, false, [this, current, preset]
+    {
+        showPresetNameDialog ("Rename preset", preset->name,
+                              [this, current] (const juce::String& name) { audioProcessor.changeProgramName (current, name); });
+    });
+
+    juce::PopupMenu morph;
+    for (const auto ms : { 0.0f, 30.0f, 200.0f, 1000.0f, 3000.0f })
+        morph.addItem (ms == 0.0f ? juce::String ("Instant") : ms < 1000.0f ? juce::String (ms, 0) + " ms" : juce::String (ms / 1000.0f, 0) + " s",
+                       true, audioProcessor.getPresetMorphMs() == ms, [this, ms] { audioProcessor.setPresetMorphMs (ms); });
+
+    menu.addSeparator();
+    menu.addSubMenu ("Morph time", morph);
+
+    menu.showMenuAsync (juce::PopupMenu::Options().withTargetComponent (presetMenu));
+}
+
+void UltimateAdlibsAudioProcessorEditor::showPresetNameDialog (const juce::String& title, const juce::String& initialName,
+                                                              std::function<void (const juce::String&)> onOk)
+{
+    auto* dialog = new juce::AlertWindow (title, {}, juce::MessageBoxIconType::NoIcon, this);
+    dialog->addTextEditor ("name", initialName);
+    dialog->addButton ("OK", 1, juce::KeyPress (juce::KeyPress::returnKey));
+    dialog->addButton ("Cancel", 0, juce::KeyPress (juce::KeyPress::escapeKey));
+
+    dialog->enterModalState (true, juce::ModalCallbackFunction::create ([safeThis = SafePointer<UltimateAdlibsAudioProcessorEditor> (this), dialog, onOk] (int result)
+    {
+        const auto name = dialog->getTextEditorContents ("name").trim();
+
+        if (safeThis != nullptr && result == 1 && name.isNotEmpty())
+            onOk (name);
+    }), true);
+}
+
+void UltimateAdlibsAudioProcessorEditor::showImpulseResponseMenu()
+{
+    juce::PopupMenu menu;
+    menu.addItem ("Load IR file...", [this]
+    {
+        irChooser = std::make_unique<juce::FileChooser> ("Impulse response", juce::File(), "*.wav;*.aif;*.aiff;*.flac");
+        irChooser->launchAsync (juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+                                [this] (const juce::FileChooser& chooser)
+        {
+            if (chooser.getResult().existsAsFile())
+                audioProcessor.loadImpulseResponse (chooser.getResult());
+
+            updateImpulseResponseButton();
+        });
+    });
+    menu.addItem ("Synthetic room", [this]
+    {
+        audioProcessor.clearImpulseResponse();
+        updateImpulseResponseButton();
+    });
+
+    menu.showMenuAsync (juce::PopupMenu::Options().withTargetComponent (revIr));
+}
+
+void UltimateAdlibsAudioProcessorEditor::updateImpulseResponseButton()
+{
+    const auto name = audioProcessor.getImpulseResponseName();
+    revIr.setButtonText (name.isEmpty() ? "Synthetic room" : name);
+}
+
+void UltimateAdlibsAudioProcessorEditor::moveStage (StageId stage, int delta)
+{
+    auto order = audioProcessor.getChainOrder();
+    const auto from = (int) (std::find (order.begin(), order.end(), stage) - order.begin());
+    const auto to = from + delta;
+
+    if (to < 0 || to >= numStages)
+        return;
+
+    std::swap (order[(size_t) from], order[(size_t) to]);
+    audioProcessor.setChainOrder (order); // the state change lays the cards out again
+}
+
+void UltimateAdlibsAudioProcessorEditor::chainOrderChanged()
+{
+    resized();
+    repaint();
+}
+
+void UltimateAdlibsAudioProcessorEditor::valueTreePropertyChanged (juce::ValueTree&, const juce::Identifier& property)
+{
+    if (property == UltimateAdlibsAudioProcessor::chainOrderProperty)
+        chainOrderChanged();
 }
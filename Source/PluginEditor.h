@@ -2,15 +2,17 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
 #include "CLALookAndFeel.h"
+#include "SpectrumAnalyzer.h"
 
 // ===== Simple VU meter component (vertical bar) =====
-class VUMeter  : public juce::Component, private juce::Timer
+// Polled by a MeterScheduler; repaints only the strip around the bar top or the peak tick
+// when either moves by a pixel.
+class VUMeter  : public juce::Component
 {
 public:
-    explicit VUMeter (std::function<float()> valueFnIn)
+    explicit VUMeter (std::function<LevelSnapshot()> valueFnIn)
         : valueFn (std::move (valueFnIn))
     {
-        startTimerHz (30);
     }
 
     void paint (juce::Graphics& g) override
@@ -24,14 +26,10 @@ public:
         g.setColour (juce::Colour (0xFF2A2A2A));
         g.drawRoundedRectangle (r, 10.0f, 1.5f);
 
-        // value (linear RMS -> dB scale display)
-        float v = juce::jlimit (0.0f, 2.0f, currentValue);
-        float db = juce::Decibels::gainToDecibels (v, -60.0f); // [-60..+]
-        // map [-60..0] dB to [0..1]
-        float norm = juce::jmap (db, -60.0f, 0.0f, 0.0f, 1.0f);
-        norm = juce::jlimit (0.0f, 1.0f, norm);
+        // value (loudest channel's RMS -> dB scale display)
+        const float norm = toNorm (current.loudestRms());
 
-        auto inner = r.reduced (6.0f);
+        auto inner = innerArea();
         auto filled = inner.withY (inner.getY() + inner.getHeight() * (1.0f - norm));
         filled.setHeight (inner.getHeight() * norm);
 
@@ -39,25 +37,197 @@ public:
         g.setColour (juce::Colour (0xFF3DFF7A).withAlpha (0.85f));
         g.fillRoundedRectangle (filled, 8.0f);
 
+        // true-peak tick
+        if (const float peakNorm = toNorm (current.loudestTruePeak()); peakNorm > 0.0f)
+        {
+            const auto peakY = inner.getY() + inner.getHeight() * (1.0f - peakNorm);
+            g.setColour (juce::Colours::white.withAlpha (0.8f));
+            g.drawLine (inner.getX() + 2.0f, peakY, inner.getRight() - 2.0f, peakY, 1.5f);
+        }
+
         // clip line at "red zone" near top
         auto redLineY = inner.getY() + inner.getHeight() * 0.12f;
         g.setColour (juce::Colour (0xFFFF3D3D).withAlpha (0.7f));
         g.drawLine (inner.getX(), redLineY, inner.getRight(), redLineY, 1.0f);
     }
 
+    // Reads the level and repaints what moved. Returns false once the meter shows nothing
+    // (or isn't on screen), which lets the scheduler go idle.
+    bool poll()
+    {
+        if (! isShowing() || ! valueFn)
+            return false;
+
+        current = valueFn();
+
+        const float barNorm = toNorm (current.loudestRms());
+        const float tickNorm = toNorm (current.loudestTruePeak());
+
+        repaintMoved (shownBarY, pixelRow (barNorm), 9);    // bar corners round over 8 px
+        repaintMoved (shownTickY, pixelRow (tickNorm), 2);
+
+        return barNorm > 0.0f || tickNorm > 0.0f;
+    }
+
 private:
-    void timerCallback() override
+    // linear -> [-60..0] dB -> [0..1]
+    static float toNorm (float linear)
     {
-        if (valueFn)
-            currentValue = valueFn();
-        repaint();
+        if (linear <= UltimateAdlibsAudioProcessor::meterFloor)
+            return 0.0f;
+
+        const float db = juce::Decibels::gainToDecibels (juce::jlimit (0.0f, 2.0f, linear), -60.0f);
+        return juce::jlimit (0.0f, 1.0f, juce::jmap (db, -60.0f, 0.0f, 0.0f, 1.0f));
     }
 
-    std::function<float()> valueFn;
-    float currentValue = 0.0f;
+    juce::Rectangle<float> innerArea() const { return getLocalBounds().toFloat().reduced (6.0f); }
+
+    int pixelRow (float norm) const
+    {
+        const auto inner = innerArea();
+        return juce::roundToInt (inner.getY() + inner.getHeight() * (1.0f - norm));
+    }
+
+    void repaintMoved (int& shownY, int newY, int margin)
+    {
+        if (newY == shownY)
+            return;
+
+        const int top = juce::jmin (shownY, newY) - margin;
+        repaint (0, top, getWidth(), std::abs (newY - shownY) + 2 * margin);
+        shownY = newY;
+    }
+
+    std::function<LevelSnapshot()> valueFn;
+    LevelSnapshot current;
+    int shownBarY = 0, shownTickY = 0;
 };
 
-class UltimateAdlibsAudioProcessorEditor  : public juce::AudioProcessorEditor
+// ===== DSP load readout ("3.2%  0.41 ms" in a section header) =====
+// Polled by a MeterScheduler a few times a second.
+class StageLoadReadout  : public juce::Component
+{
+public:
+    explicit StageLoadReadout (std::function<StageLoad()> loadFnIn)
+        : loadFn (std::move (loadFnIn))
+    {
+        setInterceptsMouseClicks (false, false);
+    }
+
+    void paint (juce::Graphics& g) override
+    {
+        // Amber once a stage takes more than a tenth of the real-time budget
+        g.setColour (current.cpuPercent > 10.0f ? juce::Colour (0xFFFFB13D) : juce::Colours::white.withAlpha (0.45f));
+        g.setFont (juce::Font (11.0f));
+        g.drawText (juce::String (current.cpuPercent, 1) + "%  " + juce::String (current.worstBlockMs, 2) + " ms",
+                    getLocalBounds(), juce::Justification::centredRight);
+    }
+
+    void poll()
+    {
+        if (! isShowing())
+            return;
+
+        const auto next = loadFn();
+
+        if (next.cpuPercent != current.cpuPercent || next.worstBlockMs != current.worstBlockMs)
+        {
+            current = next;
+            repaint();
+        }
+    }
+
+private:
+    std::function<StageLoad()> loadFn;
+    StageLoad current;
+};
+
+// ===== Meter scheduler =====
+// One vblank callback per editor drives its VU meters and analyzer, and the load
+// readouts every readoutIntervalMs, instead of a timer per component. When every meter has come to rest below
+// the floor the callback is detached and the processor is told (sleepMeters); it wakes
+// the scheduler through onMetersWake once there is something to show again.
+class MeterScheduler  : private juce::AsyncUpdater
+{
+public:
+    static constexpr juce::uint32 readoutIntervalMs = 250; // 4 Hz
+
+    MeterScheduler (juce::Component& ownerIn, UltimateAdlibsAudioProcessor& processorIn)
+        : owner (ownerIn), processor (processorIn)
+    {
+        processor.onMetersWake = [this] { wake(); };
+        wake();
+    }
+
+    ~MeterScheduler() override
+    {
+        processor.onMetersWake = nullptr;
+        cancelPendingUpdate();
+    }
+
+    void add (VUMeter& m)          { meters.push_back (&m); }
+    void add (StageLoadReadout& r) { readouts.push_back (&r); }
+    void add (SpectrumAnalyzer& a) { analyzers.push_back (&a); }
+
+private:
+    juce::Component& owner;
+    UltimateAdlibsAudioProcessor& processor;
+    std::vector<VUMeter*> meters;
+    std::vector<StageLoadReadout*> readouts;
+    std::vector<SpectrumAnalyzer*> analyzers;
+    std::unique_ptr<juce::VBlankAttachment> vblank;
+    juce::uint32 lastReadoutMs = 0;
+    bool asleep = false;
+
+    void wake()
+    {
+        asleep = false;
+        cancelPendingUpdate();
+
+        if (vblank == nullptr)
+            vblank = std::make_unique<juce::VBlankAttachment> (&owner, [this] { frame(); });
+    }
+
+    // The attachment can't be destroyed from inside its own callback
+    void handleAsyncUpdate() override
+    {
+        if (asleep)
+            vblank.reset();
+    }
+
+    void frame()
+    {
+        if (asleep)
+            return;
+
+        bool moving = false;
+        for (auto* m : meters)
+            moving = m->poll() || moving;
+
+        for (auto* a : analyzers)
+            moving = a->poll() || moving;
+
+        const auto now = juce::Time::getMillisecondCounter();
+
+        if (now - lastReadoutMs >= readoutIntervalMs || ! moving)
+        {
+            lastReadoutMs = now;
+            for (auto* r : readouts)
+                r->poll();
+        }
+
+        if (! moving)
+        {
+            asleep = true;
+            processor.sleepMeters();
+            triggerAsyncUpdate();
+        }
+    }
+};
+
+class UltimateAdlibsAudioProcessorEditor  : public juce::AudioProcessorEditor,
+                                            private juce::ValueTree::Listener,
+                                            private juce::ChangeListener
 {
 public:
     UltimateAdlibsAudioProcessorEditor (UltimateAdlibsAudioProcessor&);
@@ -66,24 +236,53 @@ public:
     void paint (juce::Graphics&) override;
     void resized() override;
 
+    // Cached background and knob filmstrips on (the default) or off; the paint benchmark
+    // times both.
+    void setRenderCaching (bool shouldCache);
+
 private:
     UltimateAdlibsAudioProcessor& audioProcessor;
     CLALookAndFeel lnf;
 
     using SliderAttachment = juce::AudioProcessorValueTreeState::SliderAttachment;
     using ButtonAttachment = juce::AudioProcessorValueTreeState::ButtonAttachment;
+    using ComboBoxAttachment = juce::AudioProcessorValueTreeState::ComboBoxAttachment;
 
     void makeKnob (juce::Slider& s);
 
+    // ===== Background =====
+    // Cards, titles and chain positions only change with the layout: drawn once into an
+    // image at the display's scale, then blitted by paint().
+    juce::Image background;
+    float backgroundScale = 0.0f;
+    bool cacheBackground = true;
+
+    void drawBackground (juce::Graphics&);
+
     // Top bar
     juce::Label title;
-    juce::ComboBox presetBox; // placeholder
+    juce::ComboBox presetBox;   // the bank, factory presets first
+    juce::TextButton presetMenu; // save, rename, morph time
+
+    void refreshPresets();
+    void showPresetMenu();
+    void showPresetNameDialog (const juce::String& title, const juce::String& initialName, std::function<void (const juce::String&)> onOk);
+    void changeListenerCallback (juce::ChangeBroadcaster*) override { refreshPresets(); }
 
     // VU meters (IN/OUT)
-    VUMeter inVu  { [this]{ return audioProcessor.getInputMeter();  } };
-    VUMeter outVu { [this]{ return audioProcessor.getOutputMeter(); } };
+    VUMeter inVu  { [this]{ return audioProcessor.getInputLevels();  } };
+    VUMeter outVu { [this]{ return audioProcessor.getOutputLevels(); } };
     juce::Label inLbl, outLbl;
 
+    // Per-stage DSP load, one per section in FILTER..REVERB order
+    std::array<std::unique_ptr<StageLoadReadout>, (size_t) numStages> loadReadouts;
+
+    // Pre/post spectrum and scope, along the bottom
+    SpectrumAnalyzer analyzer { audioProcessor };
+
+    // Drives the meters, readouts and analyzer above; declared after them so it is destroyed first
+    MeterScheduler meterScheduler { *this, audioProcessor };
+
     // Global
     juce::Slider inGain, globalMix, outGain;
     std::unique_ptr<SliderAttachment> inGainA, globalMixA, outGainA;
@@ -99,6 +298,8 @@ private:
     // Dist
     juce::Slider distDrive, distMix;
     std::unique_ptr<SliderAttachment> distDriveA, distMixA;
+    juce::ComboBox distQuality;
+    std::unique_ptr<ComboBoxAttachment> distQualityA;
 
     // Chorus
     juce::Slider choRate, choDepth, choMix;
@@ -111,13 +312,33 @@ private:
     // Delay
     juce::Slider dlyTime, dlyFb, dlyMix;
     std::unique_ptr<SliderAttachment> dlyTimeA, dlyFbA, dlyMixA;
+    juce::ComboBox dlySync;
+    std::unique_ptr<ComboBoxAttachment> dlySyncA;
 
     // Reverb
     juce::Slider revSize, revDamp, revMix;
     std::unique_ptr<SliderAttachment> revSizeA, revDampA, revMixA;
+    juce::ComboBox revAlgo;
+    std::unique_ptr<ComboBoxAttachment> revAlgoA;
+    juce::TextButton revIr;                  // convolution IR menu
+    std::unique_ptr<juce::FileChooser> irChooser;
+
+    void showImpulseResponseMenu();
+    void updateImpulseResponseButton();
+
+    // Chain order: the cards follow the processing order, and the arrows in each card's
+    // footer move its stage one place earlier or later.
+    std::array<juce::TextButton, (size_t) numStages> moveEarlier, moveLater;
+
+    void moveStage (StageId, int delta);
+    void chainOrderChanged();
+
+    void valueTreePropertyChanged (juce::ValueTree&, const juce::Identifier&) override;
+    void valueTreeRedirected (juce::ValueTree&) override { chainOrderChanged(); }
 
-    struct Section { juce::String name; juce::Rectangle<int> area; };
-    std::array<Section, 6> sections;
+    // Indexed by StageId; `position` is the place in the chain
+    struct Section { juce::String name; juce::Rectangle<int> area; int position = 0; };
+    std::array<Section, (size_t) numStages> sections;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (UltimateAdlibsAudioProcessorEditor)
 };
@@ -1,7 +1,6 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
-
-static constexpr float twoPi = 6.2831853071795864769f;
+#include "MixPipeline.h"
 
 UltimateAdlibsAudioProcessor::UltimateAdlibsAudioProcessor()
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -16,7 +15,7 @@ UltimateAdlibsAudioProcessor::UltimateAdlibsAudioProcessor()
 #endif
       apvts (*this, nullptr, "PARAMS", createParameterLayout())
 {
-    waveshaper.functionToUse = [] (float x) { return std::tanh (x); };
+    presets.addChangeListener (this);
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -29,11 +28,12 @@ bool UltimateAdlibsAudioProcessor::isBusesLayoutSupported (const BusesLayout& la
     const auto in  = layouts.getMainInputChannelSet();
     const auto out = layouts.getMainOutputChannelSet();
 
-    if (out != juce::AudioChannelSet::mono() && out != juce::AudioChannelSet::stereo())
+    if (out.isDisabled() || out.size() > maxBusChannels)
         return false;
 
    #if ! JucePlugin_IsSynth
-    if (in != out)
+    // Matching buses, or a mono source spread to stereo
+    if (in != out && ! (in == juce::AudioChannelSet::mono() && out == juce::AudioChannelSet::stereo()))
         return false;
    #endif
 
@@ -47,334 +47,1119 @@ UltimateAdlibsAudioProcessor::createParameterLayout()
 {
     using namespace juce;
     std::vector<std::unique_ptr<RangedAudioParameter>> p;
+    p.reserve (paramSpecs.size());
 
-    auto pct = NormalisableRange<float> (0.f, 100.f, 0.01f);
-    auto db  = NormalisableRange<float> (-24.f, 24.f, 0.01f);
-    auto hz  = NormalisableRange<float> (20.f, 20000.f, 1.f, 0.5f);
-
-    p.push_back (std::make_unique<AudioParameterFloat> ("IN_GAIN",    "Input Gain",  db, 0.f));
-    p.push_back (std::make_unique<AudioParameterFloat> ("OUT_GAIN",   "Output Gain", db, 0.f));
-    p.push_back (std::make_unique<AudioParameterFloat> ("GLOBAL_MIX", "Global Mix",  pct, 100.f));
-
-    p.push_back (std::make_unique<AudioParameterBool>  ("FILT_ON",  "Filters On", true));
-    p.push_back (std::make_unique<AudioParameterFloat> ("HPF_HZ",   "HPF (Hz)", hz, 120.f));
-    p.push_back (std::make_unique<AudioParameterFloat> ("LPF_HZ",   "LPF (Hz)", hz, 16000.f));
-    p.push_back (std::make_unique<AudioParameterFloat> ("FILT_MIX", "Filters Mix", pct, 100.f));
-
-    p.push_back (std::make_unique<AudioParameterBool>  ("DIST_ON",   "Dist On", true));
-    p.push_back (std::make_unique<AudioParameterFloat> ("DIST_DRIVE","Drive (dB)", NormalisableRange<float>(0.f, 24.f, 0.01f), 6.f));
-    p.push_back (std::make_unique<AudioParameterFloat> ("DIST_MIX",  "Dist Mix", pct, 30.f));
-
-    p.push_back (std::make_unique<AudioParameterBool>  ("CHO_ON",   "Chorus On", true));
-    p.push_back (std::make_unique<AudioParameterFloat> ("CHO_RATE", "Chorus Rate", NormalisableRange<float>(0.05f, 8.f, 0.001f, 0.5f), 0.8f));
-    p.push_back (std::make_unique<AudioParameterFloat> ("CHO_DEPTH","Chorus Depth", NormalisableRange<float>(0.f, 1.f, 0.001f), 0.25f));
-    p.push_back (std::make_unique<AudioParameterFloat> ("CHO_MIX",  "Chorus Mix", pct, 25.f));
-
-    p.push_back (std::make_unique<AudioParameterBool>  ("FLA_ON",   "Flanger On", true));
-    p.push_back (std::make_unique<AudioParameterFloat> ("FLA_RATE", "Flanger Rate", NormalisableRange<float>(0.05f, 5.f, 0.001f, 0.5f), 0.35f));
-    p.push_back (std::make_unique<AudioParameterFloat> ("FLA_DEPTH","Flanger Depth", NormalisableRange<float>(0.f, 1.f, 0.001f), 0.6f));
-    p.push_back (std::make_unique<AudioParameterFloat> ("FLA_FB",   "Flanger FB", NormalisableRange<float>(-0.95f, 0.95f, 0.001f), 0.2f));
-    p.push_back (std::make_unique<AudioParameterFloat> ("FLA_MIX",  "Flanger Mix", pct, 20.f));
-
-    p.push_back (std::make_unique<AudioParameterBool>  ("DLY_ON",   "Delay On", true));
-    p.push_back (std::make_unique<AudioParameterFloat> ("DLY_TIME", "Delay Time (ms)", NormalisableRange<float>(1.f, 1200.f, 0.01f, 0.5f), 220.f));
-    p.push_back (std::make_unique<AudioParameterFloat> ("DLY_FB",   "Delay Feedback", NormalisableRange<float>(0.f, 0.95f, 0.001f), 0.35f));
-    p.push_back (std::make_unique<AudioParameterFloat> ("DLY_MIX",  "Delay Mix", pct, 22.f));
+    for (int i = 0; i < numParameters; ++i)
+    {
+        const auto& spec = specOf ((Param) i);
 
-    p.push_back (std::make_unique<AudioParameterBool>  ("REV_ON",   "Reverb On", true));
-    p.push_back (std::make_unique<AudioParameterFloat> ("REV_SIZE", "Room Size", NormalisableRange<float>(0.f, 1.f, 0.001f), 0.35f));
-    p.push_back (std::make_unique<AudioParameterFloat> ("REV_DAMP", "Damping", NormalisableRange<float>(0.f, 1.f, 0.001f), 0.5f));
-    p.push_back (std::make_unique<AudioParameterFloat> ("REV_MIX",  "Reverb Mix", pct, 18.f));
+        if (spec.kind == ParamKind::Bool)
+        {
+            p.push_back (std::make_unique<AudioParameterBool> (spec.id, spec.name, spec.defaultValue > 0.5f));
+        }
+        else if (spec.kind == ParamKind::Choice)
+        {
+            p.push_back (std::make_unique<AudioParameterChoice> (spec.id, spec.name, choicesOf ((Param) i), (int) spec.defaultValue));
+        }
+        else
+        {
+            NormalisableRange<float> range (spec.minValue, spec.maxValue, spec.step, spec.skew);
+            p.push_back (std::make_unique<AudioParameterFloat> (spec.id, spec.name, range, spec.defaultValue));
+        }
+    }
 
     return { p.begin(), p.end() };
 }
 
 void UltimateAdlibsAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    sr = (float) sampleRate;
+    sr.store ((float) sampleRate, std::memory_order_relaxed);
 
     spec.sampleRate = sampleRate;
     spec.maximumBlockSize = (juce::uint32) samplesPerBlock;
     spec.numChannels = (juce::uint32) juce::jmax (1, getTotalNumOutputChannels());
 
-    dryBuffer.setSize (getTotalNumOutputChannels(), samplesPerBlock);
-    tempBuffer.setSize (getTotalNumOutputChannels(), samplesPerBlock);
+    channelGroups = channelGroupsOf (getChannelLayoutOfBus (false, 0), (int) spec.numChannels);
 
-    hpf.reset(); lpf.reset();
-    hpf.prepare (spec);
-    lpf.prepare (spec);
+    // Only the chain at the host's precision is allocated; the other stays empty
+    const bool useDouble = isUsingDoublePrecision();
 
-    chorus.prepare (spec);
-    chorus.reset();
+    if (useDouble)
+        doubleChain.prepare (spec, channelGroups);
+    else
+        floatChain.prepare (spec, channelGroups);
 
-    flangerDL.prepare (spec); flangerDR.prepare (spec);
-    flangerDL.reset(); flangerDR.reset();
-    flangerPhase = 0.0f;
+    floatIo.setSize  (useDouble ? (int) spec.numChannels : 0, useDouble ? samplesPerBlock : 0);
+    floatWet.setSize (useDouble ? (int) spec.numChannels : 0, useDouble ? samplesPerBlock : 0);
 
-    delayL.prepare (spec); delayR.prepare (spec);
-    delayL.reset(); delayR.reset();
+    updateGroupWorkers();
 
-    reverb.reset();
+    // Synthetic room from the current knobs, so the first IR is already the right one.
+    // Each channel convolves with its side of the IR.
+    std::vector<int> irChannels ((size_t) spec.numChannels, 0);
+    for (const auto& group : channelGroups)
+        for (int i = 0; i < group.size; ++i)
+            irChannels[(size_t) group.index[(size_t) i]] = i;
+
+    params.update (snapshot);
+    convolution.setRoom (snapshot[Param::REV_SIZE], snapshot[Param::REV_DAMP]);
+    convolutionWanted.store (snapshot.choice (Param::REV_ALGO) == 2, std::memory_order_relaxed);
+    convolution.setNonRealtime (isNonRealtime());
+    convolution.prepare (spec, convolutionWanted.load (std::memory_order_relaxed), std::move (irChannels));
+
+    inLevels.prepare (sampleRate, (int) spec.numChannels, getChannelLayoutOfBus (false, 0));
+    outLevels.prepare (sampleRate, (int) spec.numChannels, getChannelLayoutOfBus (false, 0));
+    dspLoad.prepare (sampleRate);
+
+    for (auto& gate : gates)
+        gate.reset();
+
+    monoInput = getTotalNumInputChannels() == 1 && getTotalNumOutputChannels() > 1;
+    dualMono = false;
+    dualMonoSamples = 0;
+    ranMono.fill (false);
+
+    // Sample rate may have moved: rebuild every stage from a full snapshot. The parameters
+    // already hold any preset selected before now.
+    presetRequest.store (nullptr, std::memory_order_relaxed);
+    morph.active = false;
+    params.update (snapshot);
+    snapshot.changed = allParamsMask;
+
+    if (useDouble)
+    {
+        updateDSP (doubleChain, snapshot);
+        updatePlan (doubleChain, snapshot, true);
+    }
+    else
+    {
+        updateDSP (floatChain, snapshot);
+        updatePlan (floatChain, snapshot, true);
+    }
+
+    // Called off the audio thread: the host can have the latency now
+    messageUpdatePending.store (false, std::memory_order_relaxed);
+    setLatencySamples (chainLatency.load (std::memory_order_relaxed));
+    startTimerHz (messageUpdateHz);
+}
+
+void UltimateAdlibsAudioProcessor::releaseResources()
+{
+    stopTimer();
+    groupWorkers.stop();
+}
+
+void UltimateAdlibsAudioProcessor::timerCallback()
+{
+    if (! messageUpdatePending.exchange (false, std::memory_order_acquire))
+        return;
+
+    setLatencySamples (chainLatency.load (std::memory_order_relaxed));
+    convolution.setActive (convolutionWanted.load (std::memory_order_relaxed));
+
+    if (onMetersWake != nullptr && ! metersAsleep.load (std::memory_order_relaxed))
+        onMetersWake();
+}
+
+void UltimateAdlibsAudioProcessor::setNonRealtime (bool isNonRealtime) noexcept
+{
+    AudioProcessor::setNonRealtime (isNonRealtime);
+    convolution.setNonRealtime (isNonRealtime);
+    updateGroupWorkers();
+}
 
-    inMeter.store (0.0f);
-    outMeter.store (0.0f);
+void UltimateAdlibsAudioProcessor::setMaxGroupWorkers (int numWorkers)
+{
+    maxGroupWorkers = juce::jmax (0, numWorkers);
+    updateGroupWorkers();
+}
 
-    updateDSP();
+// Only offline renders use the workers: real time, none are running. One worker fewer
+// than groups, as the audio thread takes a group itself.
+void UltimateAdlibsAudioProcessor::updateGroupWorkers()
+{
+    groupWorkers.start (isNonRealtime() ? juce::jlimit (0, maxGroupWorkers, (int) channelGroups.size() - 1) : 0);
 }
 
-void UltimateAdlibsAudioProcessor::updateDSP()
+template <typename SampleType>
+void UltimateAdlibsAudioProcessor::Chain<SampleType>::prepare (const juce::dsp::ProcessSpec& spec, const std::vector<GroupChannels>& layout)
 {
-    const float hpfHz = apvts.getRawParameterValue ("HPF_HZ")->load();
-    const float lpfHz = apvts.getRawParameterValue ("LPF_HZ")->load();
+    dryBuffer.setSize ((int) spec.numChannels, (int) spec.maximumBlockSize);
+    tempBuffer.setSize ((int) spec.numChannels, (int) spec.maximumBlockSize);
 
-    *hpf.state = *juce::dsp::IIR::Coefficients<float>::makeHighPass (sr, hpfHz);
-    *lpf.state = *juce::dsp::IIR::Coefficients<float>::makeLowPass  (sr, lpfHz);
+    groups.clear();
 
-    chorus.setRate (apvts.getRawParameterValue ("CHO_RATE")->load());
-    chorus.setDepth (apvts.getRawParameterValue ("CHO_DEPTH")->load());
-    chorus.setCentreDelay (7.0f);
-    chorus.setFeedback (0.0f);
-    chorus.setMix (1.0f);
+    for (const auto& channels : layout)
+    {
+        groups.push_back (std::make_unique<ChannelGroup<SampleType>>());
+        groups.back()->prepare (spec, channels);
+    }
 
-    revParams.roomSize = apvts.getRawParameterValue ("REV_SIZE")->load();
-    revParams.damping  = apvts.getRawParameterValue ("REV_DAMP")->load();
-    revParams.width    = 1.0f;
-    revParams.wetLevel = 1.0f;
-    revParams.dryLevel = 0.0f;
-    reverb.setParameters (revParams);
+    dryLatency.prepare ((int) spec.numChannels, first().distortion.getMaxLatencySamples());
+
+    planSize = 0;
+    planOrder = 0;
 }
 
-void UltimateAdlibsAudioProcessor::updateMeterAtomic (std::atomic<float>& dst, float newValue)
+template <typename SampleType>
+void UltimateAdlibsAudioProcessor::ChannelGroup<SampleType>::prepare (const juce::dsp::ProcessSpec& busSpec, const GroupChannels& groupChannels)
 {
-    newValue = juce::jmax (0.0f, newValue);
-    const float prev = dst.load (std::memory_order_relaxed);
-    const float decayed = prev * meterHold;
-    const float out = (newValue > decayed) ? newValue : decayed;
-    dst.store (out, std::memory_order_relaxed);
+    channels = groupChannels;
+
+    const juce::dsp::ProcessSpec spec { busSpec.sampleRate, busSpec.maximumBlockSize, (juce::uint32) channels.size };
+    tempBuffer.setSize (channels.size, (int) spec.maximumBlockSize);
+
+    filters.prepare (spec);
+    distortion.prepare (spec);
+
+    chorus.prepare (spec);
+    chorus.reset();
+
+    flanger.prepare (spec);
+    delay.prepare (spec);
+    fdnReverb.prepare (spec);
+    reverb.reset();
+
+    const bool useDouble = std::is_same_v<SampleType, double>;
+    floatIo.setSize  (useDouble ? channels.size : 0, useDouble ? (int) spec.maximumBlockSize : 0);
+    floatWet.setSize (useDouble ? channels.size : 0, useDouble ? (int) spec.maximumBlockSize : 0);
 }
 
-static float computeRmsStereo (const juce::AudioBuffer<float>& b, int numCh)
+// Left/right pairs by speaker position; anything else is a group of its own, except
+// discrete channels, which pair up in order.
+std::vector<UltimateAdlibsAudioProcessor::GroupChannels>
+UltimateAdlibsAudioProcessor::channelGroupsOf (const juce::AudioChannelSet& layout, int numChannels)
 {
-    const int n = b.getNumSamples();
-    if (n <= 0 || numCh <= 0) return 0.0f;
+    using Set = juce::AudioChannelSet;
+
+    static constexpr std::pair<Set::ChannelType, Set::ChannelType> pairs[]
+    {
+        { Set::left,             Set::right },
+        { Set::leftCentre,       Set::rightCentre },
+        { Set::leftSurround,     Set::rightSurround },
+        { Set::leftSurroundSide, Set::rightSurroundSide },
+        { Set::leftSurroundRear, Set::rightSurroundRear },
+        { Set::wideLeft,         Set::wideRight },
+        { Set::topFrontLeft,     Set::topFrontRight },
+        { Set::topSideLeft,      Set::topSideRight },
+        { Set::topRearLeft,      Set::topRearRight },
+    };
+
+    std::vector<GroupChannels> groups;
+    std::vector<bool> grouped ((size_t) numChannels, false);
 
-    double sum = 0.0;
-    int count = 0;
+    auto partnerOf = [&] (int ch)
+    {
+        if (layout.size() != numChannels)
+            return ch + 1; // no usable layout: consecutive pairs
+
+        const auto type = layout.getTypeOfChannel (ch);
+
+        if (type >= Set::discreteChannel0)
+            return ch + 1 < numChannels && layout.getTypeOfChannel (ch + 1) >= Set::discreteChannel0 ? ch + 1 : -1;
+
+        for (const auto& [left, right] : pairs)
+            if (type == left)
+                return layout.getChannelIndexForType (right);
+
+        return -1;
+    };
 
-    for (int ch = 0; ch < numCh; ++ch)
+    for (int ch = 0; ch < numChannels; ++ch)
     {
-        const float* x = b.getReadPointer (ch);
-        for (int i = 0; i < n; ++i)
+        if (grouped[(size_t) ch])
+            continue;
+
+        GroupChannels group;
+        group.index[0] = ch;
+        grouped[(size_t) ch] = true;
+
+        if (const auto partner = partnerOf (ch); partner > ch && partner < numChannels && ! grouped[(size_t) partner])
         {
-            const double v = (double) x[i];
-            sum += v * v;
+            group.index[1] = partner;
+            group.size = 2;
+            grouped[(size_t) partner] = true;
         }
-        count += n;
+
+        groups.push_back (group);
     }
 
-    if (count <= 0) return 0.0f;
-    return (float) std::sqrt (sum / (double) count);
+    return groups;
 }
 
-void UltimateAdlibsAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+template <typename SampleType, typename Fn>
+void UltimateAdlibsAudioProcessor::forEachGroup (const StageIo<SampleType>& io, Fn&& fn)
 {
-    juce::ScopedNoDenormals noDenormals;
+    auto& c = chain<SampleType>();
+    auto* const* bus = io.buffer.getArrayOfWritePointers();
 
-    const int numSamples = buffer.getNumSamples();
-    const int numIn  = getTotalNumInputChannels();
-    const int numOut = getTotalNumOutputChannels();
+    auto runGroup = [&c, &io, &fn, bus] (int g)
+    {
+        auto& group = *c.groups[(size_t) g];
 
-    for (int ch = numIn; ch < numOut; ++ch)
-        buffer.clear (ch, 0, numSamples);
+        // A group is cut to the channels the stage runs on (channel 0 alone while mono)
+        int n = 0;
+        SampleType* channels[2] {};
 
-    const int numCh = juce::jmin (2, numOut);
+        for (int i = 0; i < group.channels.size; ++i)
+            if (group.channels.index[(size_t) i] < io.numCh)
+                channels[n++] = bus[group.channels.index[(size_t) i]];
 
-    // Dry copy before anything (also used for IN meter)
-    dryBuffer.makeCopyOf (buffer, true);
+        if (n == 0)
+            return;
 
-    // IN meter (pre gain)
-    updateMeterAtomic (inMeter, computeRmsStereo (dryBuffer, numCh));
+        juce::AudioBuffer<SampleType> view (channels, n, io.numSamples);
+        group.traffic = {};
+        fn (group, StageIo<SampleType> { view, n, io.numSamples, group.traffic });
+    };
 
-    updateDSP();
+    if (isNonRealtime())
+    {
+        groupWorkers.run ((int) c.groups.size(), runGroup);
+    }
+    else
+    {
+        for (int g = 0; g < (int) c.groups.size(); ++g)
+            runGroup (g);
+    }
 
-    // Input gain
-    buffer.applyGain (dbToGain (apvts.getRawParameterValue ("IN_GAIN")->load()));
+    for (const auto& group : c.groups)
+        io.traffic.bytes += std::exchange (group->traffic.bytes, 0);
+}
 
-    auto mixWetFromTemp = [&] (float mix01)
+template <typename SampleType>
+void UltimateAdlibsAudioProcessor::updateDSP (Chain<SampleType>& c, const ParameterSnapshot& p)
+{
+    if (p.anyChanged (StageMasks::filter))
     {
-        mix01 = clamp01 (mix01);
-        if (mix01 <= 0.000001f) return;
+        for (auto& g : c.groups)
+            g->filters.setCutoffs (p[Param::HPF_HZ], p[Param::LPF_HZ]);
 
-        for (int ch = 0; ch < numCh; ++ch)
+        sleepTails[(size_t) StageId::Filter] = sleepTailSamples (StageId::Filter, p);
+    }
+
+    if (p.anyChanged (StageMasks::dist))
+    {
+        for (auto& g : c.groups)
         {
-            buffer.applyGain (ch, 0, numSamples, 1.0f - mix01);
-            buffer.addFrom  (ch, 0, tempBuffer, ch, 0, numSamples, mix01);
+            g->distortion.setDrive (dbToGain (p[Param::DIST_DRIVE]));
+            g->distortion.setQuality (p.choice (Param::DIST_QUALITY));
         }
-    };
 
-    // 1) FILTERS
+        // Reported whether or not the stage is on: it keeps running as a delay when off
+        const int latency = c.first().distortion.getLatencySamples();
+        c.dryLatency.setDelay (latency);
+
+        if (chainLatency.exchange (latency, std::memory_order_relaxed) != latency)
+            requestMessageUpdate();
+        sleepTails[(size_t) StageId::Dist] = sleepTailSamples (StageId::Dist, p);
+    }
+
+    if (p.anyChanged (StageMasks::chorus))
     {
-        const bool on  = apvts.getRawParameterValue ("FILT_ON")->load() > 0.5f;
-        const float mix = apvts.getRawParameterValue ("FILT_MIX")->load() / 100.0f;
+        for (auto& g : c.groups)
+        {
+            g->chorus.setRate (p[Param::CHO_RATE]);
+            g->chorus.setDepth (p[Param::CHO_DEPTH]);
+            g->chorus.setCentreDelay (7.0f);
+            g->chorus.setFeedback (0.0f);
+            g->chorus.setMix (1.0f);
+        }
 
-        if (on && mix > 0.0001f)
+        sleepTails[(size_t) StageId::Chorus] = sleepTailSamples (StageId::Chorus, p);
+    }
+
+    if (p.anyChanged (StageMasks::flanger))
+    {
+        for (auto& g : c.groups)
         {
-            tempBuffer.makeCopyOf (buffer, true);
-            juce::dsp::AudioBlock<float> block (tempBuffer);
-            auto ctx = juce::dsp::ProcessContextReplacing<float> (block);
-            hpf.process (ctx);
-            lpf.process (ctx);
-            mixWetFromTemp (mix);
+            g->flanger.setRate (p[Param::FLA_RATE]);
+            g->flanger.setDepth (p[Param::FLA_DEPTH]);
+            g->flanger.setFeedback (p[Param::FLA_FB]);
         }
+
+        sleepTails[(size_t) StageId::Flanger] = sleepTailSamples (StageId::Flanger, p);
     }
 
-    // 2) DIST
+    if (p.anyChanged (StageMasks::delay))
     {
-        const bool on  = apvts.getRawParameterValue ("DIST_ON")->load() > 0.5f;
-        const float mix = apvts.getRawParameterValue ("DIST_MIX")->load() / 100.0f;
-        const float driveDb = apvts.getRawParameterValue ("DIST_DRIVE")->load();
-        const float drive = dbToGain (driveDb);
+        for (auto& g : c.groups)
+        {
+            g->delay.setDelayMs (delayTimeMs (p));
+            g->delay.setFeedback (p[Param::DLY_FB]);
+        }
 
-        if (on && mix > 0.0001f)
+        sleepTails[(size_t) StageId::Delay] = sleepTailSamples (StageId::Delay, p);
+    }
+
+    if (p.anyChanged (StageMasks::reverb))
+    {
+        revParams.roomSize = p[Param::REV_SIZE];
+        revParams.damping  = p[Param::REV_DAMP];
+        revParams.width    = 1.0f;
+        revParams.wetLevel = 1.0f;
+        revParams.dryLevel = 0.0f;
+
+        for (auto& g : c.groups)
         {
-            tempBuffer.makeCopyOf (buffer, true);
-            tempBuffer.applyGain (drive);
+            g->reverb.setParameters (revParams);
+            g->fdnReverb.setParameters (p[Param::REV_SIZE], p[Param::REV_DAMP]);
+        }
 
-            for (int ch = 0; ch < numCh; ++ch)
+        convolution.setRoom (p[Param::REV_SIZE], p[Param::REV_DAMP]);
+
+        // The engine coming in starts from silence rather than whatever it held last time
+        const int algo = p.choice (Param::REV_ALGO);
+        if (algo != reverbAlgo)
+        {
+            reverbAlgo = algo;
+
+            for (auto& g : c.groups)
             {
-                auto* x = tempBuffer.getWritePointer (ch);
-                for (int i = 0; i < numSamples; ++i)
-                    x[i] = waveshaper.processSample (x[i]);
+                g->reverb.reset();
+                g->fdnReverb.reset();
             }
 
-            mixWetFromTemp (mix);
+            convolution.reset();
+
+            // Only the selected engine keeps an IR built and a worker running
+            convolutionWanted.store (algo == 2, std::memory_order_relaxed);
+            requestMessageUpdate();
         }
+
+        sleepTails[(size_t) StageId::Reverb] = sleepTailSamples (StageId::Reverb, p);
     }
+}
+
+// Free time, or the synced note length at the host tempo (clamped to the delay's range)
+float UltimateAdlibsAudioProcessor::delayTimeMs (const ParameterSnapshot& p) const noexcept
+{
+    const int sync = p.choice (Param::DLY_SYNC);
+
+    if (sync <= 0 || sync >= (int) delaySyncBeats.size())
+        return p[Param::DLY_TIME];
+
+    return (float) juce::jmin (DelayEngine<float>::maxDelayMs, delaySyncBeats[(size_t) sync] * 60000.0 / hostBpm.load (std::memory_order_relaxed));
+}
 
-    // 3) CHORUS
+// ===== Stages =====
+template <typename SampleType>
+static juce::dsp::AudioBlock<SampleType> blockOf (juce::AudioBuffer<SampleType>& buffer, int numCh, int numSamples)
+{
+    return juce::dsp::AudioBlock<SampleType> (buffer).getSubsetChannelBlock (0, (size_t) numCh)
+                                                     .getSubBlock (0, (size_t) numSamples);
+}
+
+// One entry per StageId, in enum order. Only the reverbs widen the image: JUCE's chorus
+// drives both channels from one LFO, so it keeps identical channels identical, but its
+// delay line can't be mirrored and it asserts on a block narrower than it was prepared
+// for, so it always runs on every channel (fed a fanned-out copy while the rest is mono).
+const std::array<UltimateAdlibsAudioProcessor::StageInfo, (size_t) numStages> UltimateAdlibsAudioProcessor::stageInfo
+{{
+    { StageId::Filter,  Param::FILT_ON, Param::FILT_MIX, false },
+    { StageId::Dist,    Param::DIST_ON, Param::DIST_MIX, false },
+    { StageId::Chorus,  Param::CHO_ON,  Param::CHO_MIX,  false },
+    { StageId::Flanger, Param::FLA_ON,  Param::FLA_MIX,  false },
+    { StageId::Delay,   Param::DLY_ON,  Param::DLY_MIX,  false },
+    { StageId::Reverb,  Param::REV_ON,  Param::REV_MIX,  true  },
+}};
+
+// Same order as stageInfo. Every stage but the convolution runs per channel group (see
+// forEachGroup); a mirror only ever concerns the first group, the one stereo bus that can
+// run mono. Flanger and delay fuse the crossfade into their own loops (wet = x + d for
+// the flanger); the rest crossfade through MixPipeline.
+template <typename SampleType>
+const std::array<UltimateAdlibsAudioProcessor::StageOps<SampleType>, (size_t) numStages>& UltimateAdlibsAudioProcessor::stageOps()
+{
+    using Processor = UltimateAdlibsAudioProcessor;
+    using Io = StageIo<SampleType>;
+    using Group = ChannelGroup<SampleType>;
+
+    static constexpr std::array<StageOps<SampleType>, (size_t) numStages> ops
+    {{
+        { [] (Processor& a, const Io& io, float mix)
+          {
+              a.forEachGroup (io, [mix] (Group& g, const Io& gio)
+              {
+                  MixPipeline::runBlockStage (gio.buffer, g.tempBuffer, gio.numCh, gio.numSamples, mix, gio.traffic, [&g] (const auto& ctx) { g.filters.process (ctx); });
+              });
+          },
+          nullptr,
+          [] (Processor& a) { for (auto& g : a.chain<SampleType>().groups) g->filters.reset(); },
+          [] (Processor& a) { a.chain<SampleType>().first().filters.copyLeftToRight(); } },
+
+        { [] (Processor& a, const Io& io, float mix)
+          {
+              a.forEachGroup (io, [mix] (Group& g, const Io& gio)
+              {
+                  auto block = blockOf (gio.buffer, gio.numCh, gio.numSamples);
+                  g.distortion.process (block, mix);
+                  gio.traffic.template add<SampleType> (2, gio.numCh, gio.numSamples);
+              });
+          },
+          [] (Processor& a, const Io& io, float)
+          {
+              a.forEachGroup (io, [] (Group& g, const Io& gio)
+              {
+                  auto block = blockOf (gio.buffer, gio.numCh, gio.numSamples);
+                  g.distortion.processBypassed (block);
+                  gio.traffic.template add<SampleType> (2, gio.numCh, gio.numSamples);
+              });
+          },
+          [] (Processor& a) { for (auto& g : a.chain<SampleType>().groups) g->distortion.reset(); },
+          [] (Processor& a) { a.chain<SampleType>().first().distortion.copyLeftToRight(); } },
+
+        { [] (Processor& a, const Io& io, float mix)
+          {
+              a.forEachGroup (io, [mix] (Group& g, const Io& gio)
+              {
+                  MixPipeline::runBlockStage (gio.buffer, g.tempBuffer, gio.numCh, gio.numSamples, mix, gio.traffic, [&g] (const auto& ctx) { g.chorus.process (ctx); });
+              });
+          },
+          nullptr,
+          [] (Processor& a) { for (auto& g : a.chain<SampleType>().groups) g->chorus.reset(); },
+          nullptr },
+
+        { [] (Processor& a, const Io& io, float mix)
+          {
+              a.forEachGroup (io, [mix] (Group& g, const Io& gio)
+              {
+                  g.flanger.process (gio.buffer.getWritePointer (0), gio.numCh > 1 ? gio.buffer.getWritePointer (1) : nullptr, gio.numSamples, mix);
+                  gio.traffic.template add<SampleType> (2, gio.numCh, gio.numSamples);
+              });
+          },
+          nullptr,
+          [] (Processor& a) { for (auto& g : a.chain<SampleType>().groups) g->flanger.reset(); },
+          [] (Processor& a) { a.chain<SampleType>().first().flanger.copyLeftToRight(); } },
+
+        { [] (Processor& a, const Io& io, float mix)
+          {
+              a.forEachGroup (io, [mix] (Group& g, const Io& gio)
+              {
+                  g.delay.process (gio.buffer.getWritePointer (0), gio.numCh > 1 ? gio.buffer.getWritePointer (1) : nullptr, gio.numSamples, mix);
+                  gio.traffic.template add<SampleType> (2, gio.numCh, gio.numSamples);
+              });
+          },
+          nullptr,
+          [] (Processor& a) { for (auto& g : a.chain<SampleType>().groups) g->delay.reset(); },
+          [] (Processor& a) { a.chain<SampleType>().first().delay.copyLeftToRight(); } },
+
+        // Placeholder: updatePlan() binds the selected algorithm from reverbOps
+        { nullptr, nullptr, nullptr, nullptr },
+    }};
+
+    return ops;
+}
+
+// Indexed by REV_ALGO
+template <typename SampleType>
+const std::array<UltimateAdlibsAudioProcessor::StageOps<SampleType>, 3>& UltimateAdlibsAudioProcessor::reverbOps()
+{
+    using Processor = UltimateAdlibsAudioProcessor;
+    using Io = StageIo<SampleType>;
+    using Group = ChannelGroup<SampleType>;
+
+    static constexpr std::array<StageOps<SampleType>, 3> ops
+    {{
+        { [] (Processor& a, const Io& io, float mix)
+          {
+              a.forEachGroup (io, [mix] (Group& g, const Io& gio)
+              {
+                  runFloatStage (gio, mix, g.tempBuffer, g.floatIo, g.floatWet, [&g] (const auto& ctx) { g.reverb.process (ctx); });
+              });
+          },
+          nullptr,
+          [] (Processor& a) { for (auto& g : a.chain<SampleType>().groups) g->reverb.reset(); },
+          nullptr },
+
+        { [] (Processor& a, const Io& io, float mix)
+          {
+              a.forEachGroup (io, [mix] (Group& g, const Io& gio)
+              {
+                  MixPipeline::runBlockStage (gio.buffer, g.tempBuffer, gio.numCh, gio.numSamples, mix, gio.traffic, [&g] (const auto& ctx) { g.fdnReverb.process (ctx); });
+              });
+          },
+          nullptr,
+          [] (Processor& a) { for (auto& g : a.chain<SampleType>().groups) g->fdnReverb.reset(); },
+          nullptr },
+
+        { [] (Processor& a, const Io& io, float mix)
+          {
+              runFloatStage (io, mix, a.chain<SampleType>().tempBuffer, a.floatIo, a.floatWet, [&a] (const auto& ctx) { a.convolution.process (ctx); });
+          },
+          nullptr,
+          [] (Processor& a) { a.convolution.reset(); },
+          nullptr },
+    }};
+
+    return ops;
+}
+
+// Runs a float-only block processor. In the double chain the block goes through the
+// float scratch: the one place that chain converts samples.
+template <typename SampleType, typename ProcessFn>
+void UltimateAdlibsAudioProcessor::runFloatStage (const StageIo<SampleType>& io, float mix, juce::AudioBuffer<SampleType>& wetScratch,
+                                                  juce::AudioBuffer<float>& floatIoScratch, juce::AudioBuffer<float>& floatWetScratch,
+                                                  ProcessFn&& process)
+{
+    if constexpr (std::is_same_v<SampleType, float>)
     {
-        const bool on  = apvts.getRawParameterValue ("CHO_ON")->load() > 0.5f;
-        const float mix = apvts.getRawParameterValue ("CHO_MIX")->load() / 100.0f;
+        juce::ignoreUnused (floatIoScratch, floatWetScratch);
+        MixPipeline::runBlockStage (io.buffer, wetScratch, io.numCh, io.numSamples, mix, io.traffic, process);
+    }
+    else
+    {
+        juce::ignoreUnused (wetScratch);
+
+        for (int ch = 0; ch < io.numCh; ++ch)
+        {
+            const auto* src = io.buffer.getReadPointer (ch);
+            auto* dst = floatIoScratch.getWritePointer (ch);
+
+            for (int i = 0; i < io.numSamples; ++i)
+                dst[i] = (float) src[i];
+        }
+
+        MixPipeline::runBlockStage (floatIoScratch, floatWetScratch, io.numCh, io.numSamples, mix, io.traffic, process);
 
-        if (on && mix > 0.0001f)
+        for (int ch = 0; ch < io.numCh; ++ch)
         {
-            tempBuffer.makeCopyOf (buffer, true);
-            juce::dsp::AudioBlock<float> block (tempBuffer);
-            chorus.process (juce::dsp::ProcessContextReplacing<float> (block));
-            mixWetFromTemp (mix);
+            const auto* src = floatIoScratch.getReadPointer (ch);
+            auto* dst = io.buffer.getWritePointer (ch);
+
+            for (int i = 0; i < io.numSamples; ++i)
+                dst[i] = (SampleType) src[i];
         }
+
+        // Both conversions: one sweep at each precision
+        io.traffic.template add<SampleType> (2, io.numCh, io.numSamples);
+        io.traffic.template add<float> (2, io.numCh, io.numSamples);
     }
+}
+
+static bool isStageActive (const ParameterSnapshot& p, Param on, Param mix) noexcept
+{
+    return p.isOn (on) && p.percent01 (mix) > MixPipeline::minMix;
+}
+
+// ===== Execution plan =====
+template <typename SampleType>
+void UltimateAdlibsAudioProcessor::updatePlan (Chain<SampleType>& c, const ParameterSnapshot& p, bool force)
+{
+    const auto order = packedOrder.load (std::memory_order_relaxed);
+
+    if (! force && order == c.planOrder && ! p.anyChanged (StageMasks::enable | maskOf (Param::REV_ALGO)))
+        return;
 
-    // 4) FLANGER
+    c.planOrder = order;
+    c.planSize = 0;
+
+    for (auto stage : unpackOrder (order))
     {
-        const bool on  = apvts.getRawParameterValue ("FLA_ON")->load() > 0.5f;
-        const float mix = apvts.getRawParameterValue ("FLA_MIX")->load() / 100.0f;
-        const float rate  = apvts.getRawParameterValue ("FLA_RATE")->load();
-        const float depth = apvts.getRawParameterValue ("FLA_DEPTH")->load();
-        const float fb    = apvts.getRawParameterValue ("FLA_FB")->load();
+        const auto& info = stageInfo[(size_t) stage];
+        auto ops = stageOps<SampleType>()[(size_t) stage];
+
+        if (stage == StageId::Reverb)
+            ops = reverbOps<SampleType>()[(size_t) juce::jlimit (0, 2, reverbAlgo)];
+
+        const bool active = isStageActive (p, info.on, info.mix);
+
+        if (active || ops.bypass != nullptr)
+            c.plan[(size_t) c.planSize++] = { stage, active ? p.percent01 (info.mix) : 0.0f, info.widens,
+                                              active ? ops.process : ops.bypass, ops.flush, ops.mirror };
+    }
+}
+
+// True when every stage in the plan is asleep: with silent input the block is silence.
+template <typename SampleType>
+bool UltimateAdlibsAudioProcessor::chainAsleep (const Chain<SampleType>& c) const noexcept
+{
+    for (int i = 0; i < c.planSize; ++i)
+        if (! gates[(size_t) c.plan[(size_t) i].stage].isAsleep())
+            return false;
+
+    return true;
+}
+
+// ===== Mono processing =====
+// Stereo input counts as dual mono once its channels have been identical for longer than
+// the tails of every stage ahead of the first widening one: by then those stages hold the
+// same state in both channels, and running them on one loses nothing. Any difference ends
+// it at once.
+template <typename SampleType>
+void UltimateAdlibsAudioProcessor::updateDualMono (const Chain<SampleType>& c, const juce::AudioBuffer<SampleType>& buffer, int numSamples) noexcept
+{
+    const auto* l = buffer.getReadPointer (0);
 
-        if (on && mix > 0.0001f && numCh >= 1)
+    if (! std::equal (l, l + numSamples, buffer.getReadPointer (1)))
+    {
+        dualMono = false;
+        dualMonoSamples = 0;
+        return;
+    }
+
+    dualMonoSamples += numSamples;
+
+    juce::int64 settle = 0;
+    for (int i = 0; i < c.planSize && ! c.plan[(size_t) i].widens; ++i)
+        settle += sleepTails[(size_t) c.plan[(size_t) i].stage];
+
+    dualMono = dualMonoSamples > settle;
+}
+
+// ===== Chain order =====
+static juce::String chainOrderToString (const UltimateAdlibsAudioProcessor::ChainOrder& order)
+{
+    juce::StringArray names;
+
+    for (auto stage : order)
+        names.add (stageName (stage));
+
+    return names.joinIntoString (",");
+}
+
+// False (and `order` untouched) unless the text names every stage exactly once
+static bool chainOrderFromString (const juce::String& text, UltimateAdlibsAudioProcessor::ChainOrder& order)
+{
+    const auto names = juce::StringArray::fromTokens (text, ",", {});
+
+    if (names.size() != numStages)
+        return false;
+
+    UltimateAdlibsAudioProcessor::ChainOrder parsed {};
+    std::array<bool, (size_t) numStages> seen {};
+
+    for (int i = 0; i < numStages; ++i)
+    {
+        int stage = 0;
+        while (stage < numStages && names[i].trim() != stageName ((StageId) stage))
+            ++stage;
+
+        if (stage == numStages || seen[(size_t) stage])
+            return false;
+
+        seen[(size_t) stage] = true;
+        parsed[(size_t) i] = (StageId) stage;
+    }
+
+    order = parsed;
+    return true;
+}
+
+void UltimateAdlibsAudioProcessor::setChainOrder (const ChainOrder& order)
+{
+    std::array<bool, (size_t) numStages> seen {};
+
+    for (auto stage : order)
+    {
+        const auto i = (int) stage;
+
+        if (i < 0 || i >= numStages || seen[(size_t) i])
+            return;
+
+        seen[(size_t) i] = true;
+    }
+
+    packedOrder.store (packOrder (order), std::memory_order_relaxed);
+    apvts.state.setProperty (chainOrderProperty, chainOrderToString (order), nullptr);
+}
+
+// ===== Tails =====
+// How long a stage keeps ringing after its input stops, until it has fallen by decayDb.
+// Feedback stages decay by |fb| per pass; the reverbs by their RT60 (or the Freeverb comb
+// feedback, or the IR length). Besides the snapshot it reads only atomics (sr, hostBpm,
+// the latency and IR length), so getTailLengthSeconds() can call it on the message thread.
+double UltimateAdlibsAudioProcessor::stageTailSeconds (StageId stage, const ParameterSnapshot& p, double decayDb) const noexcept
+{
+    const double rate = sr.load (std::memory_order_relaxed);
+
+    switch (stage)
+    {
+        case StageId::Filter:
         {
-            tempBuffer.makeCopyOf (buffer, true);
+            // Slowest Butterworth pole pair: envelope exp (-2 pi f t / sqrt 2)
+            const double nepers = decayDb * std::log (10.0) / 20.0;
+            const double f = (double) juce::jmin (p[Param::HPF_HZ], p[Param::LPF_HZ]);
+            return nepers / (juce::MathConstants<double>::twoPi * f * 0.7071067811865476);
+        }
 
-            const float minDelayMs = 0.2f;
-            const float maxDelayMs = 8.0f;
-            const float phaseInc = (twoPi * rate) / sr;
+        // Oversampler ringing plus its latency, which also sits in the bypass path
+        case StageId::Dist:    return chainLatency.load (std::memory_order_relaxed) / rate + 0.01;
 
-            auto* l = tempBuffer.getWritePointer (0);
-            auto* r = (numCh > 1) ? tempBuffer.getWritePointer (1) : nullptr;
+        // Modulated delay without feedback: the longest tap
+        case StageId::Chorus:  return 0.05;
 
-            for (int i = 0; i < numSamples; ++i)
-            {
-                const float lfo = 0.5f * (1.0f + std::sin (flangerPhase));
-                const float dMs = juce::jmap (lfo * depth, minDelayMs, maxDelayMs);
-                const float dSamp = (dMs / 1000.0f) * sr;
-
-                const float dl = flangerDL.popSample (0, dSamp);
-                const float inL = l[i] + dl * fb;
-                flangerDL.pushSample (0, inL);
-                l[i] = l[i] + dl;
-
-                if (r)
-                {
-                    const float dr = flangerDR.popSample (0, dSamp);
-                    const float inR = r[i] + dr * fb;
-                    flangerDR.pushSample (0, inR);
-                    r[i] = r[i] + dr;
-                }
-
-                flangerPhase += phaseInc;
-                if (flangerPhase >= twoPi) flangerPhase -= twoPi;
-            }
+        case StageId::Flanger: return TailGate::feedbackTailSeconds (FlangerEngine<float>::maxDelayMs * 0.001, p[Param::FLA_FB], decayDb);
+        case StageId::Delay:   return TailGate::feedbackTailSeconds (delayTimeMs (p) * 0.001, p[Param::DLY_FB], decayDb);
+
+        case StageId::Reverb:
+        {
+            const int algo = p.choice (Param::REV_ALGO);
 
-            mixWetFromTemp (mix);
+            if (algo == 2)
+                return convolution.getCurrentIrLength() / rate;
+
+            if (algo == 1) // plus the diffuser and one pass of the longest line
+                return TailGate::rt60TailSeconds (FdnReverb<float>::rt60Seconds (p[Param::REV_SIZE]), decayDb) + 0.1;
+
+            // juce::dsp::Reverb: comb feedback size * 0.28 + 0.7, longest comb about 37 ms
+            return TailGate::feedbackTailSeconds (0.037, p[Param::REV_SIZE] * 0.28 + 0.7, decayDb);
         }
+
+        case StageId::count: break;
     }
 
-    // 5) DELAY
+    return 0.0;
+}
+
+juce::int64 UltimateAdlibsAudioProcessor::sleepTailSamples (StageId stage, const ParameterSnapshot& p) const noexcept
+{
+    return (juce::int64) std::ceil (stageTailSeconds (stage, p, TailGate::sleepDecayDb) * sr.load (std::memory_order_relaxed));
+}
+
+// Enabled stages in series, each to -60 dB: chiefly DLY_TIME / DLY_FB and REV_SIZE.
+double UltimateAdlibsAudioProcessor::getTailLengthSeconds() const
+{
+    ParameterSnapshot p;
+    params.update (p);
+
+    double seconds = 0.0;
+
+    for (const auto& info : stageInfo)
+        if (isStageActive (p, info.on, info.mix))
+            seconds += stageTailSeconds (info.stage, p, 60.0);
+
+    return seconds;
+}
+
+// ===== Preset morph =====
+// Runs in place of params.update(). Outside a morph the snapshot follows the parameters.
+// During one it steps from start to end every morphStepSeconds, whatever the block size,
+// and marks only the values that moved: a stage rebuilds its coefficients at that rate at
+// most, and only while its own values are moving.
+void UltimateAdlibsAudioProcessor::updateSnapshot (int numSamples) noexcept
+{
+    if (presetCancel.exchange (false, std::memory_order_relaxed))
+        morph.active = false;
+
+    // Starts from the values the chain ran on last block, before the parameters move
+    if (const auto* target = presetRequest.exchange (nullptr, std::memory_order_acquire))
+        startMorph (*target);
+
+    params.update (snapshot);
+
+    if (! morph.active)
+        return;
+
+    ParamMask changed = 0;
+
+    if (morph.position >= morph.nextStep)
     {
-        const bool on  = apvts.getRawParameterValue ("DLY_ON")->load() > 0.5f;
-        const float mix = apvts.getRawParameterValue ("DLY_MIX")->load() / 100.0f;
-        const float timeMs = apvts.getRawParameterValue ("DLY_TIME")->load();
-        const float fb     = apvts.getRawParameterValue ("DLY_FB")->load();
+        const float t = morph.length > 0 ? juce::jmin (1.0f, (float) morph.position / (float) morph.length) : 1.0f;
+        morph.reached = t >= 1.0f;
 
-        if (on && mix > 0.0001f && numCh >= 1)
+        for (size_t i = 0; i < morph.held.size(); ++i)
         {
-            tempBuffer.makeCopyOf (buffer, true);
-            const float dSamp = (timeMs / 1000.0f) * sr;
+            const float v = morph.reached ? morph.target[i] : morphValue ((Param) i, morph.start[i], morph.end[i], t);
+
+            if (v != morph.held[i])
+            {
+                morph.held[i] = v;
+                changed |= ParamMask (1) << i;
+            }
+        }
+
+        morph.nextStep = morph.position + juce::jmax ((juce::int64) 1, (juce::int64) (morphStepSeconds * sr.load (std::memory_order_relaxed)));
+    }
+
+    morph.position += numSamples;
+    snapshot.values = morph.held;
+    snapshot.changed = changed;
+
+    // From the next block the parameters, now holding the preset, take over
+    if (morph.reached && (juce::int32) (presetCommits.load (std::memory_order_acquire) - morph.request) >= 0)
+        morph.active = false;
+}
+
+void UltimateAdlibsAudioProcessor::startMorph (const PresetValues& target) noexcept
+{
+    morph.held = morph.start = snapshot.values;
+    morph.end = morph.target = target;
+
+    // A stage switching on or off stays on for the morph while its mix comes up from, or
+    // goes down to, zero
+    for (const auto& info : stageInfo)
+    {
+        const auto on = (size_t) info.on, mix = (size_t) info.mix;
+        const bool wasOn = morph.start[on] > 0.5f, willBeOn = morph.end[on] > 0.5f;
+
+        if (wasOn == willBeOn)
+            continue;
+
+        if (! wasOn)
+            morph.start[mix] = 0.0f;
+        if (! willBeOn)
+            morph.end[mix] = 0.0f;
+
+        morph.start[on] = morph.end[on] = 1.0f;
+    }
+
+    morph.length = (juce::int64) (morphMs.load (std::memory_order_relaxed) * 0.001 * sr.load (std::memory_order_relaxed));
+    morph.position = morph.nextStep = 0;
+    morph.request = presetRequests.load (std::memory_order_relaxed);
+    morph.active = true;
+    morph.reached = false;
+}
+
+// Continuous values glide, on the knob's own scale for skewed ranges (cutoffs, times);
+// switches and choices change halfway.
+float UltimateAdlibsAudioProcessor::morphValue (Param param, float from, float to, float t) noexcept
+{
+    const auto& s = specOf (param);
+
+    if (s.kind != ParamKind::Float)
+        return t < 0.5f ? from : to;
+
+    if (s.skew == 1.0f)
+        return from + (to - from) * t;
+
+    const float range = s.maxValue - s.minValue;
+    const float a = std::pow ((from - s.minValue) / range, s.skew);
+    const float b = std::pow ((to - s.minValue) / range, s.skew);
+    return s.minValue + range * std::pow (a + (b - a) * t, 1.0f / s.skew);
+}
+
+void UltimateAdlibsAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    processChain (buffer);
+}
+
+void UltimateAdlibsAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer&)
+{
+    processChain (buffer);
+}
+
+// A host block longer than the prepared size is processed in prepared-size chunks, each
+// through a view of the host's channels, so nothing is ever resized on the audio thread.
+template <typename SampleType>
+void UltimateAdlibsAudioProcessor::processChain (juce::AudioBuffer<SampleType>& buffer)
+{
+    juce::ScopedNoDenormals noDenormals;
+
+    const int total = buffer.getNumSamples();
+    const int maxChunk = juce::jmax (1, (int) spec.maximumBlockSize);
+
+    if (total <= maxChunk)
+    {
+        processChunk (buffer);
+        return;
+    }
+
+    for (int start = 0; start < total; start += maxChunk)
+    {
+        juce::AudioBuffer<SampleType> chunk (buffer.getArrayOfWritePointers(), buffer.getNumChannels(),
+                                             start, juce::jmin (maxChunk, total - start));
+        processChunk (chunk);
+    }
+}
+
+template <typename SampleType>
+void UltimateAdlibsAudioProcessor::processChunk (juce::AudioBuffer<SampleType>& buffer)
+{
+    const int numSamples = buffer.getNumSamples();
+    const DspLoadMeter::BlockScope blockTimer (dspLoad, numSamples);
+
+    const int numIn  = getTotalNumInputChannels();
+    const int numOut = getTotalNumOutputChannels();
+
+    for (int ch = numIn; ch < numOut; ++ch)
+        buffer.clear (ch, 0, numSamples);
+
+    const int numCh = juce::jmin (numOut, buffer.getNumChannels(), (int) spec.numChannels);
+
+    if (numCh == 0)
+        return;
 
-            auto* l = tempBuffer.getWritePointer (0);
-            auto* r = (numCh > 1) ? tempBuffer.getWritePointer (1) : nullptr;
+    updateSnapshot (numSamples);
+    const auto& p = snapshot;
 
-            for (int i = 0; i < numSamples; ++i)
+    // Tempo only matters to a synced delay; a new tempo re-targets it like a parameter change
+    if (auto* playHead = getPlayHead())
+        if (const auto position = playHead->getPosition())
+            if (const auto bpm = position->getBpm(); bpm.hasValue() && *bpm > 0.0 && *bpm != hostBpm.load (std::memory_order_relaxed))
             {
-                const float dl = delayL.popSample (0, dSamp);
-                delayL.pushSample (0, l[i] + dl * fb);
-                l[i] = dl;
-
-                if (r)
-                {
-                    const float dr = delayR.popSample (0, dSamp);
-                    delayR.pushSample (0, r[i] + dr * fb);
-                    r[i] = dr;
-                }
+                hostBpm.store (*bpm, std::memory_order_relaxed);
+
+                if (p.choice (Param::DLY_SYNC) > 0)
+                    snapshot.changed |= maskOf (Param::DLY_SYNC);
             }
 
-            mixWetFromTemp (mix);
-        }
+    auto& c = chain<SampleType>();
+    updateDSP (c, p);
+
+    updatePlan (c, p, false);
+
+    if (numCh == 2 && ! monoInput)
+        updateDualMono (c, buffer, numSamples);
+
+    // Channels carrying distinct signals until the chain fans out
+    int width = (monoInput || dualMono) ? 1 : numCh;
+
+    // Passes over the buffers outside the stages, for the DSP load snapshot
+    BufferTraffic chainTraffic;
+
+    // Silence is judged once, on the chain input after the input gain
+    float inputPeak = 0.0f;
+    for (int ch = 0; ch < width; ++ch)
+        inputPeak = juce::jmax (inputPeak, (float) buffer.getMagnitude (ch, 0, numSamples));
+
+    chainTraffic.add<SampleType> (1, width, numSamples);
+
+    const bool inputSilent = inputPeak * dbToGain (p[Param::IN_GAIN]) < TailGate::silenceThreshold;
+
+    // A loaded IR can change length at any time
+    if (reverbAlgo == 2)
+        sleepTails[(size_t) StageId::Reverb] = sleepTailSamples (StageId::Reverb, p);
+
+    if (inputSilent && chainAsleep (c))
+    {
+        buffer.clear();
+        inLevels.processSilence (numSamples);
+        outLevels.processSilence (numSamples);
+
+        chainTraffic.add<SampleType> (1, numCh, numSamples);
+        dspLoad.addChainTraffic (chainTraffic);
+        return;
     }
 
-    // 6) REVERB
+    // Dry copy is only needed when the global mix blends it back in
+    const float globalMix = p.percent01 (Param::GLOBAL_MIX);
+    const bool needsDry = globalMix < MixPipeline::fullyWet;
+
+    if (needsDry)
+    {
+        for (int ch = 0; ch < numCh; ++ch)
+            c.dryBuffer.copyFrom (ch, 0, buffer, ch, 0, numSamples);
+
+        if (monoInput)
+            c.dryBuffer.copyFrom (1, 0, c.dryBuffer, 0, 0, numSamples);
+
+        chainTraffic.add<SampleType> (2, numCh, numSamples);
+    }
+    else
+    {
+        // Fully wet: the dry path still has to hold the last `latency` input samples for
+        // the moment the mix comes down
+        std::array<const SampleType*, maxBusChannels> dry {};
+
+        for (int ch = 0; ch < numCh; ++ch)
+            dry[(size_t) ch] = buffer.getReadPointer (monoInput ? 0 : ch);
+
+        c.dryLatency.feed (dry.data(), (size_t) numCh, (size_t) numSamples);
+    }
+
+    // IN meter (pre gain)
+    const float inPeak = inLevels.process (buffer, width, numSamples);
+
+    // Input gain
+    for (int ch = 0; ch < width; ++ch)
+        buffer.applyGain (ch, 0, numSamples, dbToGain (p[Param::IN_GAIN]));
+
+    chainTraffic.add<SampleType> (3, width, numSamples); // meter read, gain read and write
+
+    // Analyzer taps, only while an analyzer is on screen: the chain input here, and the
+    // wet chain output before the global mix below
+    const bool analyze = analyzerActive.load (std::memory_order_relaxed);
+
+    if (analyze)
     {
-        const bool on  = apvts.getRawParameterValue ("REV_ON")->load() > 0.5f;
-        const float mix = apvts.getRawParameterValue ("REV_MIX")->load() / 100.0f;
+        const DspLoadMeter::StageScope timer (dspLoad, DspLoadMeter::StageScope::AnalyzerTaps {});
+        preTap.push (buffer, width, numSamples);
+        chainTraffic.add<SampleType> (1, width, numSamples);
+    }
+
+    // Stages, in plan order. A stage runs while its input is live or its own tail is still
+    // ringing; the block it falls asleep its state is flushed. A sleeping stage leaves the
+    // buffer untouched, and its output counts as silent for the stages after it.
+    bool upstreamSilent = inputSilent;
 
-        if (on && mix > 0.0001f)
+    for (int i = 0; i < c.planSize; ++i)
+    {
+        const auto& step = c.plan[(size_t) i];
+
+        if (! gates[(size_t) step.stage].shouldRun (upstreamSilent, numSamples, sleepTails[(size_t) step.stage],
+                                                    [this, &step] { step.flush (*this); }))
+            continue;
+
+        upstreamSilent = false;
+
+        // While the signal is mono, a stage runs on channel 0 unless it widens the image or
+        // can't run narrow (no mirror: the chorus, prepared for every channel)
+        const bool fullWidth = step.widens || step.mirror == nullptr;
+        const int stepWidth = fullWidth ? numCh : width;
+
+        if (stepWidth > width)
         {
-            tempBuffer.makeCopyOf (buffer, true);
-            juce::dsp::AudioBlock<float> block (tempBuffer);
-            reverb.process (juce::dsp::ProcessContextReplacing<float> (block));
-            mixWetFromTemp (mix);
+            buffer.copyFrom (1, 0, buffer, 0, 0, numSamples);
+            chainTraffic.add<SampleType> (2, 1, numSamples);
         }
+
+        if (step.widens)
+            width = numCh;
+
+        if (auto& mono = ranMono[(size_t) step.stage]; stepWidth < numCh)
+            mono = true;
+        else if (std::exchange (mono, false) && step.mirror != nullptr)
+            step.mirror (*this);
+
+        BufferTraffic stageTraffic;
+        {
+            const DspLoadMeter::StageScope timer (dspLoad, step.stage);
+            step.process (*this, { buffer, stepWidth, numSamples, stageTraffic }, step.mix);
+        }
+        dspLoad.addTraffic (step.stage, stageTraffic);
+    }
+
+    if (analyze)
+    {
+        const DspLoadMeter::StageScope timer (dspLoad, DspLoadMeter::StageScope::AnalyzerTaps {});
+        postTap.push (buffer, width, numSamples);
+        chainTraffic.add<SampleType> (1, width, numSamples);
+    }
+
+    // Fan out whatever is still mono
+    if (width < numCh)
+    {
+        buffer.copyFrom (1, 0, buffer, 0, 0, numSamples);
+        chainTraffic.add<SampleType> (2, 1, numSamples);
     }
 
     // Global wet/dry
-    const float globalMix = apvts.getRawParameterValue ("GLOBAL_MIX")->load() / 100.0f;
-    if (globalMix < 0.9999f)
+    if (needsDry)
     {
-        const float gm = clamp01 (globalMix);
+        auto dryBlock = blockOf (c.dryBuffer, numCh, numSamples);
+        c.dryLatency.process (dryBlock);
+
         for (int ch = 0; ch < numCh; ++ch)
-        {
-            buffer.applyGain (ch, 0, numSamples, gm);
-            buffer.addFrom  (ch, 0, dryBuffer, ch, 0, numSamples, 1.0f - gm);
-        }
+            MixPipeline::crossfade (buffer.getWritePointer (ch), c.dryBuffer.getReadPointer (ch),
+                                    buffer.getReadPointer (ch), numSamples, (SampleType) globalMix);
+
+        chainTraffic.add<SampleType> (c.dryLatency.getDelay() > 0 ? 5 : 3, numCh, numSamples); // latency line, crossfade
     }
 
     // Output gain
-    buffer.applyGain (dbToGain (apvts.getRawParameterValue ("OUT_GAIN")->load()));
+    buffer.applyGain (dbToGain (p[Param::OUT_GAIN]));
 
     // OUT meter (post gain)
-    updateMeterAtomic (outMeter, computeRmsStereo (buffer, numCh));
+    const float outPeak = outLevels.process (buffer, numCh, numSamples);
+
+    chainTraffic.add<SampleType> (3, numCh, numSamples); // gain read and write, meter read
+    dspLoad.addChainTraffic (chainTraffic);
+
+    // An editor that stopped polling on silence is woken through timerCallback
+    if (juce::jmax (inPeak, outPeak) > meterFloor && metersAsleep.load (std::memory_order_relaxed)
+         && metersAsleep.exchange (false, std::memory_order_relaxed))
+        requestMessageUpdate();
 }
 
 juce::AudioProcessorEditor* UltimateAdlibsAudioProcessor::createEditor()
@@ -382,18 +1167,259 @@ juce::AudioProcessorEditor* UltimateAdlibsAudioProcessor::createEditor()
     return new UltimateAdlibsAudioProcessorEditor (*this);
 }
 
+// ===== State =====
+// Binary, little-endian, written straight from the parameters without building a
+// ValueTree or XML:
+//
+//   "UAST"  version (u32)
+//   chain order   numStages x u8 (StageId)
+//   morph time    f32 (ms)
+//   preset name   u16 length + UTF-8
+//   IR file       u16 length + UTF-8, empty for the synthetic room
+//   parameters    u16 count, count x ID (u8 length + ASCII), count x f32
+//
+// Values are matched to the table by ID, as in the preset bank, so a parameter added
+// since takes its default. Anything without the magic is read as the XML older versions
+// wrote.
+static void writeText (juce::MemoryOutputStream& out, const juce::String& text)
+{
+    const auto bytes = juce::jmin ((size_t) 0xffff, text.getNumBytesAsUTF8());
+    out.writeShort ((short) bytes);
+    out.write (text.toRawUTF8(), bytes);
+}
+
+static juce::String readText (juce::MemoryInputStream& in)
+{
+    const int bytes = (juce::uint16) in.readShort();
+
+    if (bytes == 0 || in.getNumBytesRemaining() < bytes)
+        return {};
+
+    const auto* text = static_cast<const char*> (in.getData()) + in.getPosition();
+    in.skipNextBytes (bytes);
+    return juce::String::fromUTF8 (text, bytes);
+}
+
 void UltimateAdlibsAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    auto state = apvts.copyState();
-    std::unique_ptr<juce::XmlElement> xml (state.createXml());
-    copyXmlToBinary (*xml, destData);
+    juce::MemoryOutputStream out (destData, false);
+    out.preallocate (512);
+
+    out.writeInt ((int) stateMagic);
+    out.writeInt ((int) stateVersion);
+
+    for (auto stage : getChainOrder())
+        out.writeByte ((char) stage);
+
+    out.writeFloat (morphMs.load (std::memory_order_relaxed));
+    writeText (out, apvts.state.getProperty (presetProperty).toString());
+    writeText (out, apvts.state.getProperty (irFileProperty).toString());
+
+    out.writeShort ((short) numParameters);
+
+    for (const auto& spec : paramSpecs)
+    {
+        const auto length = std::strlen (spec.id);
+        out.writeByte ((char) length);
+        out.write (spec.id, length);
+    }
+
+    for (int i = 0; i < numParameters; ++i)
+        out.writeFloat (params.get ((Param) i));
 }
 
 void UltimateAdlibsAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
+    if (restoreBinaryState (data, sizeInBytes))
+        return;
+
     std::unique_ptr<juce::XmlElement> xmlState (getXmlFromBinary (data, sizeInBytes));
     if (xmlState && xmlState->hasTagName (apvts.state.getType()))
-        apvts.replaceState (juce::ValueTree::fromXml (*xmlState));
+        restoreXmlState (*xmlState);
+}
+
+// False if the data isn't a binary state. One from a newer version, or cut short, is
+// recognised but left unread.
+bool UltimateAdlibsAudioProcessor::restoreBinaryState (const void* data, int sizeInBytes)
+{
+    juce::MemoryInputStream in (data, (size_t) juce::jmax (0, sizeInBytes), false);
+
+    if (sizeInBytes < 8 || (juce::uint32) in.readInt() != stateMagic)
+        return false;
+
+    if ((juce::uint32) in.readInt() > stateVersion)
+        return true;
+
+    ChainOrder order {};
+    for (auto& stage : order)
+        stage = (StageId) (juce::uint8) in.readByte();
+
+    const float morph = in.readFloat();
+    const auto presetName = readText (in);
+    const auto irPath = readText (in);
+
+    // Table index of each stored value; written by this table, the IDs are in its order
+    const int numStored = (juce::uint16) in.readShort();
+    std::vector<int> slots ((size_t) numStored, -1);
+
+    for (int i = 0; i < numStored; ++i)
+    {
+        const int length = (juce::uint8) in.readByte();
+
+        if (in.getNumBytesRemaining() < length)
+            return true;
+
+        const auto* id = static_cast<const char*> (in.getData()) + in.getPosition();
+        in.skipNextBytes (length);
+
+        auto matches = [id, length] (int slot)
+        {
+            return std::strlen (paramSpecs[(size_t) slot].id) == (size_t) length
+                && std::memcmp (paramSpecs[(size_t) slot].id, id, (size_t) length) == 0;
+        };
+
+        if (i < numParameters && matches (i))
+            slots[(size_t) i] = i;
+        else
+            for (int slot = 0; slot < numParameters && slots[(size_t) i] < 0; ++slot)
+                if (matches (slot))
+                    slots[(size_t) i] = slot;
+    }
+
+    if (in.getNumBytesRemaining() < (juce::int64) numStored * 4)
+        return true;
+
+    auto values = PresetBank::defaultValues();
+
+    for (auto slot : slots)
+    {
+        const float v = in.readFloat();
+
+        if (slot >= 0 && std::isfinite (v))
+            values[(size_t) slot] = v;
+    }
+
+    // Whatever a morph was heading for, the restored parameters win
+    presetRequest.store (nullptr, std::memory_order_relaxed);
+    presetCancel.store (true, std::memory_order_relaxed);
+
+    // Order first, as for XML; one that isn't a permutation falls back to the original
+    setChainOrder (order);
+    if (getChainOrder() != order)
+        setChainOrder (defaultChainOrder);
+
+    for (int i = 0; i < numParameters; ++i)
+        params.set ((Param) i, values[(size_t) i]);
+
+    setPresetMorphMs (morph);
+    apvts.state.setProperty (presetProperty, presetName, nullptr);
+    presets.setCurrent (presetName);
+
+    // Host undo snapshots restore the same IR over and over: only a new path is loaded
+    if (irPath != apvts.state.getProperty (irFileProperty).toString())
+        if (irPath.isEmpty() || ! loadImpulseResponse (juce::File (irPath)))
+            clearImpulseResponse();
+
+    return true;
+}
+
+void UltimateAdlibsAudioProcessor::restoreXmlState (const juce::XmlElement& xml)
+{
+    const auto newState = juce::ValueTree::fromXml (xml);
+
+    // Older sessions have no order: they get the original one. Stored before the state
+    // swap so that listeners see the new order.
+    auto order = defaultChainOrder;
+    chainOrderFromString (newState.getProperty (chainOrderProperty).toString(), order);
+    packedOrder.store (packOrder (order), std::memory_order_relaxed);
+
+    // Whatever a morph was heading for, the restored parameters win
+    presetRequest.store (nullptr, std::memory_order_relaxed);
+    presetCancel.store (true, std::memory_order_relaxed);
+
+    apvts.replaceState (newState);
+
+    morphMs.store ((float) apvts.state.getProperty (presetMorphProperty, defaultMorphMs), std::memory_order_relaxed);
+    presets.setCurrent (apvts.state.getProperty (presetProperty).toString());
+
+    const auto irPath = apvts.state.getProperty (irFileProperty).toString();
+    if (irPath.isEmpty() || ! convolution.loadImpulseResponse (juce::File (irPath)))
+        convolution.clearImpulseResponse();
+}
+
+// ===== Presets =====
+int UltimateAdlibsAudioProcessor::getNumPrograms()    { return presets.size(); }
+int UltimateAdlibsAudioProcessor::getCurrentProgram() { return presets.getCurrent(); }
+
+const juce::String UltimateAdlibsAudioProcessor::getProgramName (int index)
+{
+    const auto* preset = presets.get (index);
+    return preset != nullptr ? preset->name : juce::String();
+}
+
+void UltimateAdlibsAudioProcessor::changeProgramName (int index, const juce::String& newName)
+{
+    if (presets.rename (index, newName) && index == presets.getCurrent())
+        apvts.state.setProperty (presetProperty, presets.get (index)->name, nullptr);
+}
+
+void UltimateAdlibsAudioProcessor::setCurrentProgram (int index)
+{
+    const auto* preset = presets.get (index);
+
+    if (preset == nullptr)
+        return;
+
+    presets.setCurrent (index);
+    apvts.state.setProperty (presetProperty, preset->name, nullptr);
+
+    // The chain starts towards the preset at its next block...
+    const auto request = presetRequests.fetch_add (1, std::memory_order_relaxed) + 1;
+    presetRequest.store (&preset->values, std::memory_order_release);
+
+    // ...and takes the parameters back once they hold it
+    for (int i = 0; i < numParameters; ++i)
+        params.set ((Param) i, preset->values[(size_t) i]);
+
+    presetCommits.store (request, std::memory_order_release);
+}
+
+int UltimateAdlibsAudioProcessor::saveUserPreset (const juce::String& name)
+{
+    PresetValues values {};
+    for (int i = 0; i < numParameters; ++i)
+        values[(size_t) i] = params.get ((Param) i);
+
+    const auto index = presets.addUserPreset (name, values);
+    presets.setCurrent (index);
+    apvts.state.setProperty (presetProperty, presets.get (index)->name, nullptr);
+    return index;
+}
+
+void UltimateAdlibsAudioProcessor::setPresetMorphMs (float ms)
+{
+    morphMs.store (juce::jmax (0.0f, ms), std::memory_order_relaxed);
+    apvts.state.setProperty (presetMorphProperty, juce::jmax (0.0f, ms), nullptr);
+}
+
+void UltimateAdlibsAudioProcessor::changeListenerCallback (juce::ChangeBroadcaster*)
+{
+    updateHostDisplay (ChangeDetails().withProgramChanged (true));
+}
+
+bool UltimateAdlibsAudioProcessor::loadImpulseResponse (const juce::File& file)
+{
+    if (! convolution.loadImpulseResponse (file))
+        return false;
+
+    apvts.state.setProperty (irFileProperty, file.getFullPathName(), nullptr);
+    return true;
+}
+
+void UltimateAdlibsAudioProcessor::clearImpulseResponse()
+{
+    convolution.clearImpulseResponse();
+    apvts.state.removeProperty (irFileProperty, nullptr);
 }
 
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
@@ -1,21 +1,58 @@
 #pragma once
 #include <JuceHeader.h>
+#include <array>
 #include <atomic>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include "Parameters.h"
+#include "SvfFilterEngine.h"
+#include "DistortionEngine.h"
+#include "FlangerEngine.h"
+#include "DelayEngine.h"
+#include "FdnReverb.h"
+#include "ConvolutionReverb.h"
+#include "DspLoadMeter.h"
+#include "TailGate.h"
+#include "LevelMeter.h"
+#include "AnalyzerFifo.h"
+#include "PresetBank.h"
+#include "GroupWorkerPool.h"
 
-class UltimateAdlibsAudioProcessor : public juce::AudioProcessor
+class UltimateAdlibsAudioProcessor : public juce::AudioProcessor,
+                                      private juce::Timer,
+                                      private juce::ChangeListener
 {
 public:
     UltimateAdlibsAudioProcessor();
     ~UltimateAdlibsAudioProcessor() override = default;
 
     void prepareToPlay (double sampleRate, int samplesPerBlock) override;
-    void releaseResources() override {}
+    void releaseResources() override;
 
    #ifndef JucePlugin_PreferredChannelConfigurations
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
    #endif
 
-    void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    // Both precisions run the same templated chain natively; the host picks one before
+    // prepareToPlay() and only that chain is prepared.
+    bool supportsDoublePrecisionProcessing() const override { return true; }
+    void processBlock (juce::AudioBuffer<float>&,  juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+
+    // Any layout up to maxBusChannels (5.1, 7.1.4, 9.1.6...) with matching input and output,
+    // or a mono source spread to stereo.
+    static constexpr int maxBusChannels = 16;
+    static_assert (maxMeterChannels >= maxBusChannels, "the meters cover every bus channel");
+
+    // Offline renders make the convolution tail wait for its worker instead of dropping
+    // blocks, and run the channel groups in parallel.
+    void setNonRealtime (bool isNonRealtime) noexcept override;
+
+    // Caps the threads an offline render adds to run channel groups in parallel (by
+    // default one fewer than the CPUs); 0 runs them all on the audio thread. For a
+    // caller that already runs several processors at once.
+    void setMaxGroupWorkers (int numWorkers);
 
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override { return true; }
@@ -24,14 +61,16 @@ public:
     bool acceptsMidi() const override { return false; }
     bool producesMidi() const override { return false; }
     bool isMidiEffect() const override { return false; }
-    double getTailLengthSeconds() const override { return 2.0; }
+    double getTailLengthSeconds() const override;
 
-    int getNumPrograms() override { return 1; }
-    int getCurrentProgram() override { return 0; }
-    void setCurrentProgram (int) override {}
-    const juce::String getProgramName (int) override { return {}; }
-    void changeProgramName (int, const juce::String&) override {}
+    // Programs are the presets in the bank (see Presets below)
+    int getNumPrograms() override;
+    int getCurrentProgram() override;
+    void setCurrentProgram (int) override;
+    const juce::String getProgramName (int) override;
+    void changeProgramName (int, const juce::String&) override; // user presets only
 
+    // Compact binary state (see PluginProcessor.cpp); XML from older versions still loads.
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
@@ -39,56 +78,332 @@ public:
     APVTS apvts;
     static APVTS::ParameterLayout createParameterLayout();
 
-    // ===== Meters (linear RMS 0..~1) =====
-    float getInputMeter()  const noexcept { return inMeter.load (std::memory_order_relaxed); }
-    float getOutputMeter() const noexcept { return outMeter.load (std::memory_order_relaxed); }
+    // ===== Meters (any thread) =====
+    LevelSnapshot getInputLevels()  const noexcept { return inLevels.getSnapshot(); }
+    LevelSnapshot getOutputLevels() const noexcept { return outLevels.getSnapshot(); }
+
+    static constexpr float meterFloor = 0.001f; // -60 dB, the bottom of the VU scale
+
+    // Message thread. An editor whose meters have all come to rest below the floor stops
+    // polling and calls sleepMeters(); onMetersWake is called once a block goes above
+    // the floor again.
+    std::function<void()> onMetersWake;
+    void sleepMeters() noexcept { metersAsleep.store (true, std::memory_order_relaxed); }
+
+    // ===== Analyzer taps =====
+    // While active, every block pushes the chain input (pre) and the wet chain output
+    // (post) as mono into wait-free FIFOs; a single reader drains them off the audio thread.
+    void setAnalyzerActive (bool shouldBeActive) noexcept { analyzerActive.store (shouldBeActive, std::memory_order_relaxed); }
+    AnalyzerFifo& getAnalyzerTap (bool post) noexcept { return post ? postTap : preTap; }
+
+    // ===== Presets (message thread) =====
+    // Selecting a preset hands the audio thread a pointer to its values, which the chain
+    // morphs to over the morph time (0: at the next block); the parameters are then set to
+    // the preset so the host and editor follow. The current preset's name and the morph
+    // time are kept in the state tree.
+    PresetBank& getPresetBank() noexcept { return presets; }
+    int saveUserPreset (const juce::String& name); // the current settings; returns the new index
+
+    void setPresetMorphMs (float ms);
+    float getPresetMorphMs() const noexcept { return morphMs.load (std::memory_order_relaxed); }
+
+    static constexpr float defaultMorphMs = 30.0f;
+    static inline const juce::Identifier presetProperty { "preset" };
+    static inline const juce::Identifier presetMorphProperty { "presetMorphMs" };
+
+    // ===== Convolution IR (message thread) =====
+    // The file path is kept in the state tree; an empty path selects the synthetic room.
+    bool loadImpulseResponse (const juce::File& file);
+    void clearImpulseResponse();
+    juce::String getImpulseResponseName() const { return convolution.getImpulseResponseName(); }
+
+    // ===== Chain order (message thread) =====
+    // Stages in processing order, kept in the state tree as a list of stage names.
+    using ChainOrder = std::array<StageId, (size_t) numStages>;
+    static constexpr ChainOrder defaultChainOrder { StageId::Filter, StageId::Dist,  StageId::Chorus,
+                                                    StageId::Flanger, StageId::Delay, StageId::Reverb };
+    static inline const juce::Identifier chainOrderProperty { "chainOrder" };
+
+    ChainOrder getChainOrder() const noexcept { return unpackOrder (packedOrder.load (std::memory_order_relaxed)); }
+    void setChainOrder (const ChainOrder&); // ignored unless it is a permutation of the stages
+
+    // ===== DSP load (per stage, see DspLoadMeter) =====
+    DspLoadSnapshot getDspLoad() const noexcept { return dspLoad.getSnapshot(); }
+    void resetDspLoad() noexcept                { dspLoad.resetTotals(); }
 
 private:
+    ParameterCache params { apvts };
+    ParameterSnapshot snapshot;
+
+    // ===== Preset morph =====
+    // The audio thread takes the newest request at the start of a block and runs the
+    // snapshot from its current values to the preset's (see updateSnapshot). A morph ends
+    // once the preset is reached and the message thread has committed it to the
+    // parameters, whose values are ignored until then.
+    PresetBank presets;
+    std::atomic<const PresetValues*> presetRequest { nullptr };
+    std::atomic<juce::uint32> presetRequests { 0 }, presetCommits { 0 };
+    std::atomic<bool> presetCancel { false }; // a restored state replaces any morph
+    std::atomic<float> morphMs { defaultMorphMs };
+
+    static constexpr double morphStepSeconds = 0.005; // values move, and coefficients follow, at most this often
+
+    struct PresetMorph
+    {
+        PresetValues start {}, end {}; // interpolated between
+        PresetValues target {};        // exact values at the end
+        PresetValues held {};          // current step
+        juce::int64 length = 0, position = 0, nextStep = 0;
+        juce::uint32 request = 0;
+        bool active = false, reached = false;
+    };
+
+    PresetMorph morph;
+
+    void updateSnapshot (int numSamples) noexcept;
+    void startMorph (const PresetValues& target) noexcept;
+    static float morphValue (Param, float from, float to, float t) noexcept;
+
+    void changeListenerCallback (juce::ChangeBroadcaster*) override;
+
     juce::dsp::ProcessSpec spec {};
-    float sr = 44100.0f;
+    std::atomic<float> sr { 44100.0f }; // atomic, like hostBpm: getTailLengthSeconds() reads it
+
+    // ===== Execution plan =====
+    // The stages that run this block, in chain order, with their mix and process function
+    // bound. Rebuilt on the audio thread only when the order or an on/mix value changes;
+    // processBlock walks it without looking at a parameter. Distortion is always in the
+    // plan: switched off, it runs as the latency delay.
+    template <typename SampleType>
+    struct StageIo
+    {
+        juce::AudioBuffer<SampleType>& buffer;
+        int numCh, numSamples;
+        BufferTraffic& traffic; // the stage adds the passes it makes over `buffer` and its scratch
+    };
+
+    template <typename SampleType>
+    using StageFn = void (*) (UltimateAdlibsAudioProcessor&, const StageIo<SampleType>&, float mix);
+    using FlushFn = void (*) (UltimateAdlibsAudioProcessor&);
+
+    // What a stage is, independent of precision
+    struct StageInfo
+    {
+        StageId stage;
+        Param on, mix;
+        bool widens; // identical channels in, different channels out
+    };
+
+    // How it runs at one precision
+    template <typename SampleType>
+    struct StageOps
+    {
+        StageFn<SampleType> process, bypass; // bypass null: a stage that is off is left out
+        FlushFn flush;                       // clears the stage's state when it falls asleep
+        FlushFn mirror;                      // copies channel 0's state to channel 1; null if the engine can't
+    };
+
+    template <typename SampleType>
+    struct PlanStep
+    {
+        StageId stage;
+        float mix;
+        bool widens;
+        StageFn<SampleType> process;
+        FlushFn flush, mirror;
+    };
+
+    static const std::array<StageInfo, (size_t) numStages> stageInfo;
+
+    template <typename SampleType> static const std::array<StageOps<SampleType>, (size_t) numStages>& stageOps();
+    template <typename SampleType> static const std::array<StageOps<SampleType>, 3>& reverbOps(); // by REV_ALGO
+
+    // ===== Channel groups =====
+    // The bus is split into groups of one or two channels: each left/right pair of the
+    // layout (L/R, Ls/Rs, Ltf/Rtf...) and every other channel on its own (C, LFE...).
+    // Every group has its own engines, so each channel keeps its own filter, delay and
+    // flanger state and the stereo effects (chorus, reverbs) always see a pair. Groups
+    // never exchange signal, so offline they run in parallel on groupWorkers; only the
+    // convolution engine takes the whole bus (its tail already has a worker of its own).
+    struct GroupChannels
+    {
+        std::array<int, 2> index {}; // bus channels; the second is unused when size is 1
+        int size = 1;
+    };
 
-    // Buffers
-    juce::AudioBuffer<float> dryBuffer;
-    juce::AudioBuffer<float> tempBuffer;
+    static std::vector<GroupChannels> channelGroupsOf (const juce::AudioChannelSet&, int numChannels);
 
-    // ===== Filters (JUCE 8 friendly) =====
-    using IIRFilter = juce::dsp::IIR::Filter<float>;
-    using IIRCoeffs = juce::dsp::IIR::Coefficients<float>;
-    using IIRStereo = juce::dsp::ProcessorDuplicator<IIRFilter, IIRCoeffs>;
+    template <typename SampleType>
+    struct ChannelGroup
+    {
+        GroupChannels channels;
+        juce::AudioBuffer<SampleType> tempBuffer;
 
-    IIRStereo hpf;
-    IIRStereo lpf;
+        SvfFilterEngine<SampleType> filters;
+        DistortionEngine<SampleType> distortion;
+        juce::dsp::Chorus<SampleType> chorus;
+        FlangerEngine<SampleType> flanger;
+        DelayEngine<SampleType> delay;
+        FdnReverb<SampleType> fdnReverb;
 
-    // ===== Distortion =====
-    juce::dsp::WaveShaper<float> waveshaper;
+        // Freeverb is float-only: the double chain runs it on float copies of the block
+        // (floatIo / floatWet, sized only for double precision)
+        juce::dsp::Reverb reverb;
+        juce::AudioBuffer<float> floatIo, floatWet;
 
-    // ===== Chorus =====
-    juce::dsp::Chorus<float> chorus;
+        BufferTraffic traffic; // of the stage running now; forEachGroup() collects it
 
-    // ===== Flanger =====
-    juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::Linear> flangerDL { 8192 };
-    juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::Linear> flangerDR { 8192 };
-    float flangerPhase = 0.0f;
+        void prepare (const juce::dsp::ProcessSpec& busSpec, const GroupChannels&);
+    };
+
+    std::vector<GroupChannels> channelGroups; // of the prepared layout
+    GroupWorkerPool groupWorkers;
+    int maxGroupWorkers = juce::SystemStats::getNumCpus() - 1;
+
+    // Starts or stops the workers to match isNonRealtime(), off the audio thread
+    void updateGroupWorkers();
+
+    // Runs fn (group, io) for each group on its channels of io, in parallel when offline.
+    template <typename SampleType, typename Fn>
+    void forEachGroup (const StageIo<SampleType>&, Fn&&);
+
+    // ===== Chain =====
+    // Everything that carries signal, at one sample precision. The float and double chains
+    // are the same code; only the one matching isUsingDoublePrecision() is prepared.
+    template <typename SampleType>
+    struct Chain
+    {
+        juce::AudioBuffer<SampleType> dryBuffer;
+        juce::AudioBuffer<SampleType> tempBuffer; // whole bus, for the convolution engine
+
+        std::vector<std::unique_ptr<ChannelGroup<SampleType>>> groups;
+        CompensationDelay<SampleType> dryLatency; // aligns the global dry path with the oversampler
+
+        std::array<PlanStep<SampleType>, (size_t) numStages> plan {};
+        int planSize = 0;
+        juce::uint32 planOrder = 0; // packed order the plan was built for, 0 = none yet
+
+        void prepare (const juce::dsp::ProcessSpec&, const std::vector<GroupChannels>&);
+
+        ChannelGroup<SampleType>& first() noexcept { return *groups.front(); }
+    };
+
+    Chain<float>  floatChain;
+    Chain<double> doubleChain;
+
+    template <typename SampleType>
+    Chain<SampleType>& chain() noexcept
+    {
+        if constexpr (std::is_same_v<SampleType, double>)
+            return doubleChain;
+        else
+            return floatChain;
+    }
+
+    // ===== Message-thread updates =====
+    // The audio thread never posts a message: that takes the message queue's lock and can
+    // allocate. It raises messageUpdatePending instead, and a timer that runs while the
+    // processor is prepared does the work on the message thread.
+    static constexpr int messageUpdateHz = 30;
+    std::atomic<bool> messageUpdatePending { false };
+
+    void requestMessageUpdate() noexcept { messageUpdatePending.store (true, std::memory_order_release); }
+    void timerCallback() override;
+
+    // ===== Latency =====
+    // The distortion oversampler's latency. The audio thread only stores it; the host is
+    // told on the message thread (timerCallback), or directly by prepareToPlay().
+    // The convolution engine is switched on and off the same way.
+    std::atomic<int> chainLatency { 0 };
+    std::atomic<bool> convolutionWanted { false };
 
     // ===== Delay =====
-    juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::Linear> delayL { 262144 };
-    juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::Linear> delayR { 262144 };
+    std::atomic<double> hostBpm { 120.0 }; // last tempo reported by the play head
 
     // ===== Reverb =====
-    juce::dsp::Reverb reverb;
+    // The convolution engine is float-only like Freeverb: the double chain runs it on float
+    // copies of the whole bus (floatIo / floatWet, sized only for double precision).
     juce::dsp::Reverb::Parameters revParams;
+    ConvolutionReverb convolution;
+    int reverbAlgo = 0; // REV_ALGO index: 0 classic (Freeverb), 1 FDN, 2 convolution
+    juce::AudioBuffer<float> floatIo, floatWet;
+
+    // Runs a float-only block processor through the given scratch
+    template <typename SampleType, typename ProcessFn>
+    static void runFloatStage (const StageIo<SampleType>&, float mix, juce::AudioBuffer<SampleType>& wetScratch,
+                               juce::AudioBuffer<float>& floatIoScratch, juce::AudioBuffer<float>& floatWetScratch,
+                               ProcessFn&&);
 
     // ===== Meter state =====
-    std::atomic<float> inMeter  { 0.0f };
-    std::atomic<float> outMeter { 0.0f };
-    float meterHold = 0.92f; // simple decay per block
+    LevelMeter inLevels, outLevels; // IN before the input gain, OUT after the output gain
+    std::atomic<bool> metersAsleep { false };
 
-    void updateDSP();
+    AnalyzerFifo preTap, postTap;
+    std::atomic<bool> analyzerActive { false };
 
-    static float dbToGain (float db) { return juce::Decibels::decibelsToGain (db); }
-    static float clamp01 (float x)   { return juce::jlimit (0.0f, 1.0f, x); }
+    DspLoadMeter dspLoad;
+
+    std::atomic<juce::uint32> packedOrder { packOrder (defaultChainOrder) };
+
+    template <typename SampleType>
+    void updatePlan (Chain<SampleType>&, const ParameterSnapshot&, bool force);
+
+    static constexpr juce::uint32 packOrder (const ChainOrder& order) noexcept
+    {
+        juce::uint32 packed = 0;
+        for (size_t i = 0; i < order.size(); ++i)
+            packed |= (juce::uint32) ((int) order[i] + 1) << (4 * i);
+        return packed;
+    }
+
+    static constexpr ChainOrder unpackOrder (juce::uint32 packed) noexcept
+    {
+        ChainOrder order {};
+        for (size_t i = 0; i < order.size(); ++i)
+            order[i] = (StageId) ((int) ((packed >> (4 * i)) & 15u) - 1);
+        return order;
+    }
+
+    // ===== Mono processing =====
+    // With a mono input (mono-in/stereo-out layout), or a stereo input whose channels are
+    // identical (dual mono), the chain runs on channel 0 up to the first stage that widens
+    // the image and fans out there, or at the end. A stage that ran on one channel copies
+    // its left state to the right before it next runs on both. Stereo buses only: a
+    // stereo bus is a single channel group.
+    bool monoInput = false;
+    bool dualMono = false;
+    juce::int64 dualMonoSamples = 0; // input frames with identical channels so far
+    std::array<bool, (size_t) numStages> ranMono {};
+
+    template <typename SampleType>
+    void updateDualMono (const Chain<SampleType>&, const juce::AudioBuffer<SampleType>&, int numSamples) noexcept;
 
-    void updateMeterAtomic (std::atomic<float>& dst, float newValue);
+    // ===== Stage sleeping (see TailGate) =====
+    std::array<TailGate, (size_t) numStages> gates;
+    std::array<juce::int64, (size_t) numStages> sleepTails {}; // samples to -120 dB, per stage
+
+    static inline const juce::Identifier irFileProperty { "irFile" };
+
+    // ===== State =====
+    static constexpr juce::uint32 stateMagic = 0x54534155; // "UAST"
+    static constexpr juce::uint32 stateVersion = 1;
+
+    bool restoreBinaryState (const void* data, int sizeInBytes);
+    void restoreXmlState (const juce::XmlElement&);
+
+    template <typename SampleType>
+    void updateDSP (Chain<SampleType>&, const ParameterSnapshot&);
+    template <typename SampleType>
+    void processChain (juce::AudioBuffer<SampleType>&);
+    template <typename SampleType>
+    void processChunk (juce::AudioBuffer<SampleType>&);
+    float delayTimeMs (const ParameterSnapshot&) const noexcept;
+    double stageTailSeconds (StageId, const ParameterSnapshot&, double decayDb) const noexcept;
+    juce::int64 sleepTailSamples (StageId, const ParameterSnapshot&) const noexcept;
+    template <typename SampleType>
+    bool chainAsleep (const Chain<SampleType>&) const noexcept;
+
+    static float dbToGain (float db) { return juce::Decibels::decibelsToGain (db); }
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (UltimateAdlibsAudioProcessor)
 };
@@ -0,0 +1,429 @@
+#pragma once
+#include <JuceHeader.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+#include "Parameters.h"
+
+// Every parameter's value, in table order
+using PresetValues = std::array<float, numParameters>;
+
+// ===== Preset library =====
+// Factory presets (compiled in) followed by the user's, each decoded once into a flat
+// PresetValues. There is one library per process, shared by every plugin instance's
+// PresetBank through juce::SharedResourcePointer, so a preset saved in one instance shows
+// up in all the others. A preset's values never change and a preset never leaves the
+// library, so a processor can hand the audio thread a pointer to them and switch in O(1).
+//
+// User presets live in one binary file, read through a memory map on the library's
+// loader thread when the library is created. Layout, little-endian:
+//
+//   "UAPB"  version (u32)  numParams (u16)  numPresets (u16)
+//   numParams  x  parameter ID  (u8 length + ASCII)
+//   numPresets x  name (u8 length + UTF-8), numParams x value (f32)
+//
+// Values are matched to the parameter table by ID, so a bank written before a parameter
+// was added or removed still loads; a parameter the file doesn't have takes its default.
+//
+// Adding or renaming a preset takes effect in memory at once and queues the edit on the
+// loader, which reads the file again, applies the edit to what it finds there and
+// writes it back: a change made by another process (a second host) since is kept, and
+// nothing waits for the first read. Everything but the loader jobs runs on the message
+// thread; listeners hear about a new or renamed preset and the user presets arriving.
+class PresetLibrary  : public juce::ChangeBroadcaster,
+                       private juce::AsyncUpdater
+{
+public:
+    struct Preset
+    {
+        juce::String name;
+        PresetValues values;
+        bool factory;
+    };
+
+    static constexpr juce::uint32 magic = 0x42504155; // "UAPB"
+    static constexpr juce::uint32 version = 1;
+    static constexpr int maxNameLength = 63;          // characters; fits the u8 byte count
+
+    PresetLibrary() : PresetLibrary (defaultUserFile()) {}
+
+    explicit PresetLibrary (const juce::File& userBankFile)
+        : userFile (userBankFile)
+    {
+        presets = factoryPresets();
+
+        loader.addJob ([this]
+        {
+            auto decoded = readBank (userFile);
+            {
+                const juce::ScopedLock sl (loadedLock);
+                loaded = std::move (decoded);
+            }
+
+            loadFinished.signal();
+            triggerAsyncUpdate();
+        });
+    }
+
+    ~PresetLibrary() override
+    {
+        loader.removeAllJobs (true, 5000);
+    }
+
+    static juce::File defaultUserFile()
+    {
+        return juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+                   .getChildFile ("UltimateAdlibs").getChildFile ("UserPresets.uapb");
+    }
+
+    // ===== Lookup =====
+    int size() const noexcept { return (int) presets.size(); }
+
+    // Null when out of range
+    const Preset* get (int index) const noexcept
+    {
+        return juce::isPositiveAndBelow (index, size()) ? presets[(size_t) index].get() : nullptr;
+    }
+
+    int indexOf (const juce::String& name) const noexcept
+    {
+        for (size_t i = 0; i < presets.size(); ++i)
+            if (presets[i]->name == name)
+                return (int) i;
+
+        return -1;
+    }
+
+    // True once the user presets are in; takes them in if the loader has just finished.
+    bool userPresetsLoaded()
+    {
+        if (! collected && loadFinished.wait (0))
+            collectLoaded();
+
+        return collected;
+    }
+
+    // ===== User presets =====
+    // Appends a preset and queues it for the file; returns its index. Presets read from
+    // the file later are appended after it.
+    int addUserPreset (const juce::String& name, const PresetValues& values)
+    {
+        auto preset = std::make_unique<Preset> (Preset { name.substring (0, maxNameLength), values, false });
+        queueEdit (preset->name, preset->name, &values);
+
+        presets.push_back (std::move (preset));
+        sendChangeMessage();
+        return size() - 1;
+    }
+
+    // Factory presets keep their names.
+    bool rename (int index, const juce::String& newName)
+    {
+        if (get (index) == nullptr || presets[(size_t) index]->factory || newName.trim().isEmpty())
+            return false;
+
+        auto& name = presets[(size_t) index]->name;
+        const auto oldName = std::exchange (name, newName.trim().substring (0, maxNameLength));
+        queueEdit (oldName, name, nullptr);
+
+        sendChangeMessage();
+        return true;
+    }
+
+    // ===== Bank file =====
+    static juce::MemoryBlock encode (const std::vector<const Preset*>& bank)
+    {
+        juce::MemoryBlock data;
+
+        {
+            juce::MemoryOutputStream out (data, false);
+            out.writeInt ((int) magic);
+            out.writeInt ((int) version);
+            out.writeShort ((short) numParameters);
+            out.writeShort ((short) juce::jmin ((size_t) 0xffff, bank.size()));
+
+            for (const auto& spec : paramSpecs)
+                writeText (out, spec.id);
+
+            for (size_t i = 0; i < bank.size() && i < 0xffff; ++i)
+            {
+                writeText (out, bank[i]->name);
+
+                for (auto v : bank[i]->values)
+                    out.writeFloat (v);
+            }
+        }
+
+        return data;
+    }
+
+    // Stops at the first truncated preset; a file that isn't a bank gives nothing.
+    static std::vector<std::unique_ptr<Preset>> decode (const void* data, size_t size)
+    {
+        std::vector<std::unique_ptr<Preset>> bank;
+        juce::MemoryInputStream in (data, size, false);
+
+        if (size < 12 || (juce::uint32) in.readInt() != magic || (juce::uint32) in.readInt() > version)
+            return bank;
+
+        const int numStored  = (juce::uint16) in.readShort();
+        const int numPresets = (juce::uint16) in.readShort();
+
+        // Table index of each stored value, -1 for a parameter that no longer exists
+        std::vector<int> slots ((size_t) numStored, -1);
+
+        for (auto& slot : slots)
+        {
+            const auto id = readText (in);
+
+            for (int i = 0; i < numParameters; ++i)
+                if (id == paramSpecs[(size_t) i].id)
+                    slot = i;
+        }
+
+        for (int i = 0; i < numPresets; ++i)
+        {
+            auto name = readText (in);
+
+            if (name.isEmpty() || in.getNumBytesRemaining() < (juce::int64) numStored * 4)
+                break;
+
+            auto preset = std::make_unique<Preset> (Preset { name, defaultValues(), false });
+
+            for (auto slot : slots)
+            {
+                const float v = in.readFloat();
+
+                if (slot >= 0 && std::isfinite (v))
+                    preset->values[(size_t) slot] = juce::jlimit (paramSpecs[(size_t) slot].minValue, paramSpecs[(size_t) slot].maxValue, v);
+            }
+
+            bank.push_back (std::move (preset));
+        }
+
+        return bank;
+    }
+
+    static PresetValues defaultValues() noexcept
+    {
+        PresetValues values {};
+
+        for (size_t i = 0; i < values.size(); ++i)
+            values[i] = paramSpecs[i].defaultValue;
+
+        return values;
+    }
+
+private:
+    std::vector<std::unique_ptr<Preset>> presets;
+
+    const juce::File userFile;
+    juce::ThreadPool loader { 1 };
+    juce::WaitableEvent loadFinished { true }; // manual reset: stays signalled
+    bool collected = false;
+
+    // Handed over by the loader job
+    juce::CriticalSection loadedLock;
+    std::vector<std::unique_ptr<Preset>> loaded;
+
+    static std::vector<std::unique_ptr<Preset>> factoryPresets()
+    {
+        std::vector<std::unique_ptr<Preset>> bank;
+
+        auto add = [&bank] (const char* name, std::initializer_list<std::pair<Param, float>> changes)
+        {
+            auto values = defaultValues();
+
+            for (const auto& [param, value] : changes)
+                values[(size_t) param] = value;
+
+            bank.push_back (std::make_unique<Preset> (Preset { name, values, true }));
+        };
+
+        add ("Default", {});
+        add ("Wide Throw",   { { Param::HPF_HZ, 250.0f }, { Param::CHO_MIX, 35.0f }, { Param::DLY_SYNC, 9.0f },
+                               { Param::DLY_FB, 0.45f }, { Param::DLY_MIX, 35.0f }, { Param::REV_SIZE, 0.7f },
+                               { Param::REV_MIX, 30.0f } });
+        add ("Tight Double", { { Param::DIST_MIX, 15.0f }, { Param::CHO_DEPTH, 0.15f }, { Param::CHO_MIX, 40.0f },
+                               { Param::FLA_ON, 0.0f }, { Param::DLY_TIME, 35.0f }, { Param::DLY_FB, 0.05f },
+                               { Param::DLY_MIX, 18.0f }, { Param::REV_ON, 0.0f } });
+        add ("Telephone",    { { Param::HPF_HZ, 450.0f }, { Param::LPF_HZ, 3200.0f }, { Param::DIST_DRIVE, 14.0f },
+                               { Param::DIST_QUALITY, 2.0f }, { Param::DIST_MIX, 60.0f }, { Param::CHO_ON, 0.0f },
+                               { Param::FLA_ON, 0.0f }, { Param::REV_MIX, 10.0f } });
+        add ("Dub Echo",     { { Param::LPF_HZ, 6000.0f }, { Param::FLA_ON, 0.0f }, { Param::DLY_SYNC, 7.0f },
+                               { Param::DLY_FB, 0.7f }, { Param::DLY_MIX, 40.0f }, { Param::REV_ALGO, 1.0f },
+                               { Param::REV_SIZE, 0.6f }, { Param::REV_MIX, 25.0f } });
+        add ("Jet Sweep",    { { Param::CHO_ON, 0.0f }, { Param::FLA_RATE, 0.12f }, { Param::FLA_DEPTH, 0.9f },
+                               { Param::FLA_FB, 0.7f }, { Param::FLA_MIX, 55.0f } });
+
+        return bank;
+    }
+
+    static std::vector<std::unique_ptr<Preset>> readBank (const juce::File& file)
+    {
+        if (! file.existsAsFile())
+            return {};
+
+        const juce::MemoryMappedFile mapped (file, juce::MemoryMappedFile::readOnly);
+
+        if (mapped.getData() == nullptr)
+            return {};
+
+        return decode (mapped.getData(), mapped.getSize());
+    }
+
+    static void writeText (juce::MemoryOutputStream& out, const juce::String& text)
+    {
+        const auto bytes = juce::jmin ((size_t) 255, text.getNumBytesAsUTF8());
+        out.writeByte ((char) bytes);
+        out.write (text.toRawUTF8(), bytes);
+    }
+
+    static juce::String readText (juce::MemoryInputStream& in)
+    {
+        std::array<char, 255> bytes;
+        const int n = (juce::uint8) in.readByte();
+
+        if (in.read (bytes.data(), n) != n)
+            return {};
+
+        return juce::String::fromUTF8 (bytes.data(), n);
+    }
+
+    // Appends the user presets the loader has read (message thread, once it has finished).
+    void collectLoaded()
+    {
+        if (collected)
+            return;
+
+        collected = true;
+        cancelPendingUpdate();
+
+        std::vector<std::unique_ptr<Preset>> user;
+        {
+            const juce::ScopedLock sl (loadedLock);
+            user = std::move (loaded);
+        }
+
+        presets.insert (presets.end(), std::make_move_iterator (user.begin()), std::make_move_iterator (user.end()));
+    }
+
+    // Read, edit, write on the loader: an add when `values` is set, else a rename of the
+    // first user preset called `oldName`.
+    void queueEdit (const juce::String& oldName, const juce::String& newName, const PresetValues* values)
+    {
+        std::optional<PresetValues> added;
+        if (values != nullptr)
+            added = *values;
+
+        loader.addJob ([file = userFile, oldName, newName, added]
+        {
+            auto bank = readBank (file);
+
+            if (added.has_value())
+            {
+                bank.push_back (std::make_unique<Preset> (Preset { newName, *added, false }));
+            }
+            else
+            {
+                const auto it = std::find_if (bank.begin(), bank.end(), [&oldName] (const auto& p) { return p->name == oldName; });
+
+                if (it == bank.end())
+                    return;
+
+                (*it)->name = newName;
+            }
+
+            std::vector<const Preset*> user;
+            for (const auto& p : bank)
+                user.push_back (p.get());
+
+            const auto data = encode (user);
+
+            if (! file.getParentDirectory().createDirectory())
+                return;
+
+            juce::TemporaryFile temp (file);
+            if (temp.getFile().replaceWithData (data.getData(), data.getSize()))
+                temp.overwriteTargetFileWithTemporary();
+        });
+    }
+
+    void handleAsyncUpdate() override
+    {
+        collectLoaded();
+        sendChangeMessage();
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PresetLibrary)
+};
+
+// ===== Preset bank =====
+// One plugin instance's view of the process-wide PresetLibrary: the presets, and which
+// of them is current here. Passes the library's changes on to its own listeners, along
+// with a new current preset.
+class PresetBank  : public juce::ChangeBroadcaster,
+                    private juce::ChangeListener
+{
+public:
+    using Preset = PresetLibrary::Preset;
+
+    PresetBank()  { library->addChangeListener (this); }
+    ~PresetBank() override { library->removeChangeListener (this); }
+
+    static PresetValues defaultValues() noexcept { return PresetLibrary::defaultValues(); }
+
+    // ===== Lookup =====
+    int size() const noexcept                             { return library->size(); }
+    const Preset* get (int index) const noexcept          { return library->get (index); }
+    int indexOf (const juce::String& name) const noexcept { return library->indexOf (name); }
+
+    int getCurrent() const noexcept { return current; }
+
+    void setCurrent (int index)
+    {
+        if (get (index) == nullptr || index == current)
+            return;
+
+        current = index;
+        pendingName = {};
+        sendChangeMessage();
+    }
+
+    // For a restored session: a user preset that hasn't been read yet becomes current
+    // once it arrives.
+    void setCurrent (const juce::String& name)
+    {
+        const bool loaded = library->userPresetsLoaded();
+
+        if (const auto index = indexOf (name); index >= 0)
+            setCurrent (index);
+        else if (! loaded)
+            pendingName = name;
+    }
+
+    // ===== User presets =====
+    int addUserPreset (const juce::String& name, const PresetValues& values) { return library->addUserPreset (name, values); }
+    bool rename (int index, const juce::String& newName)                     { return library->rename (index, newName); }
+
+private:
+    juce::SharedResourcePointer<PresetLibrary> library;
+    int current = 0;
+    juce::String pendingName; // restored current preset, not read yet
+
+    void changeListenerCallback (juce::ChangeBroadcaster*) override
+    {
+        if (pendingName.isNotEmpty() && library->userPresetsLoaded())
+            if (const auto index = indexOf (std::exchange (pendingName, juce::String())); index >= 0)
+                current = index;
+
+        sendChangeMessage();
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PresetBank)
+};
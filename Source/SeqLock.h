@@ -0,0 +1,69 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+// ===== Sequence lock =====
+// Single-writer publication of a small trivially copyable struct. The writer never
+// waits; readers retry if a write overlapped their copy. The payload is stored as
+// relaxed atomic words so a torn read is detected rather than undefined.
+template <typename T>
+class SeqLock
+{
+public:
+    static_assert (std::is_trivially_copyable<T>::value, "SeqLock payload must be trivially copyable");
+
+    SeqLock() noexcept { store (T {}); }
+
+    // Writer side (one thread only, typically the audio thread).
+    void store (const T& value) noexcept
+    {
+        Words src {};
+        std::memcpy (src.data(), &value, sizeof (T));
+
+        const auto s = sequence.load (std::memory_order_relaxed);
+        sequence.store (s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence (std::memory_order_release);
+
+        for (size_t i = 0; i < numWords; ++i)
+            words[i].store (src[i], std::memory_order_relaxed);
+
+        sequence.store (s + 2, std::memory_order_release);
+    }
+
+    // Reader side, any thread.
+    T load() const noexcept
+    {
+        Words dst;
+
+        for (;;)
+        {
+            const auto before = sequence.load (std::memory_order_acquire);
+
+            if ((before & 1) == 0)
+            {
+                for (size_t i = 0; i < numWords; ++i)
+                    dst[i] = words[i].load (std::memory_order_relaxed);
+
+                std::atomic_thread_fence (std::memory_order_acquire);
+
+                if (sequence.load (std::memory_order_relaxed) == before)
+                    break;
+            }
+        }
+
+        T value;
+        std::memcpy (static_cast<void*> (&value), dst.data(), sizeof (T));
+        return value;
+    }
+
+private:
+    using Word = juce::uint32;
+    static constexpr size_t numWords = (sizeof (T) + sizeof (Word) - 1) / sizeof (Word);
+    using Words = std::array<Word, numWords>;
+
+    std::atomic<juce::uint32> sequence { 0 };
+    std::array<std::atomic<Word>, numWords> words {};
+};
@@ -0,0 +1,233 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <vector>
+#include "PluginProcessor.h"
+
+// ===== Spectrum and scope analyzer =====
+// Pre (chain input) and post (wet chain output) spectra, plus a scope of the post signal.
+// Everything but the sample copy into the processor's analyzer FIFOs happens here, on the
+// message thread: the editor's MeterScheduler polls it once per frame, so it follows the
+// display rate and stops with the display. A poll drains both FIFOs into the latest
+// fftSize samples; once a hop of new samples has arrived it runs a Hann-windowed FFT,
+// smooths the magnitudes (instant rise, timed fall) and redraws. The taps are switched on
+// only while the analyzer is on screen.
+class SpectrumAnalyzer  : public juce::Component
+{
+public:
+    static constexpr int fftOrder = 11;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int hopSize = fftSize / 2;
+    static constexpr int scopeSamples = 512;
+    static constexpr float floorDb = -90.0f;
+    static constexpr float fallDbPerSecond = 40.0f;
+    static constexpr float minHz = 20.0f, maxHz = 20000.0f;
+
+    explicit SpectrumAnalyzer (UltimateAdlibsAudioProcessor& p)
+        : processor (p), fft (fftOrder), window ((size_t) fftSize, juce::dsp::WindowingFunction<float>::hann, false)
+    {
+        setInterceptsMouseClicks (false, false);
+
+        for (auto* t : { &pre, &post })
+        {
+            t->fftData.resize ((size_t) fftSize * 2);
+            t->smoothedDb.fill (floorDb);
+        }
+
+        drained.resize ((size_t) AnalyzerFifo::capacity);
+    }
+
+    ~SpectrumAnalyzer() override
+    {
+        processor.setAnalyzerActive (false);
+    }
+
+    void paint (juce::Graphics& g) override
+    {
+        auto r = getLocalBounds().toFloat();
+
+        g.setColour (juce::Colour (0xFF101010));
+        g.fillRoundedRectangle (r, 14.0f);
+        g.setColour (juce::Colour (0xFF242424));
+        g.drawRoundedRectangle (r, 14.0f, 1.5f);
+
+        // Octave grid
+        g.setColour (juce::Colours::white.withAlpha (0.06f));
+        for (float hz = 31.25f; hz < maxHz; hz *= 2.0f)
+        {
+            const auto x = xForHz (hz);
+            g.drawVerticalLine (juce::roundToInt (x), spectrumArea.getY(), spectrumArea.getBottom());
+        }
+
+        g.setColour (juce::Colours::white.withAlpha (0.35f));
+        g.strokePath (pre.path, juce::PathStrokeType (1.0f));
+
+        g.setColour (juce::Colour (0xFFFFD36A));
+        g.strokePath (post.path, juce::PathStrokeType (1.5f));
+
+        g.setColour (juce::Colour (0xFF3DFF7A).withAlpha (0.8f));
+        g.strokePath (scopePath, juce::PathStrokeType (1.0f));
+
+        g.setFont (juce::Font (11.0f));
+        g.setColour (juce::Colours::white.withAlpha (0.45f));
+        g.drawText ("PRE / POST", spectrumArea.toNearestInt().removeFromTop (14), juce::Justification::centredLeft);
+        g.drawText ("SCOPE", scopeArea.toNearestInt().removeFromTop (14), juce::Justification::centredLeft);
+    }
+
+    void resized() override
+    {
+        auto r = getLocalBounds().toFloat().reduced (12.0f, 8.0f);
+        scopeArea = r.removeFromRight (r.getWidth() * 0.25f);
+        r.removeFromRight (12.0f);
+        spectrumArea = r;
+        rebuildPaths();
+    }
+
+    // Called by the MeterScheduler every frame. Returns true while there is something
+    // to show (new samples, or a spectrum still falling to the floor).
+    bool poll()
+    {
+        const bool showing = isShowing();
+        processor.setAnalyzerActive (showing);
+
+        if (! showing)
+            return false;
+
+        const auto now = juce::Time::getMillisecondCounterHiRes();
+        const auto fall = lastPollMs > 0.0 ? (float) ((now - lastPollMs) * 0.001) * fallDbPerSecond : 0.0f;
+        lastPollMs = now;
+
+        bool changed = false;
+
+        for (auto* t : { &pre, &post })
+            changed = update (*t, processor.getAnalyzerTap (t == &post), fall) || changed;
+
+        if (changed)
+        {
+            rebuildPaths();
+            repaint();
+        }
+
+        return changed;
+    }
+
+private:
+    struct Trace
+    {
+        std::array<float, (size_t) fftSize> history {}; // latest samples, oldest first
+        int fresh = 0;                                  // samples since the last FFT
+        std::vector<float> fftData;
+        std::array<float, (size_t) fftSize / 2> smoothedDb {};
+        juce::Path path;
+    };
+
+    UltimateAdlibsAudioProcessor& processor;
+    juce::dsp::FFT fft;
+    juce::dsp::WindowingFunction<float> window;
+    Trace pre, post;
+    std::vector<float> drained;
+    juce::Path scopePath;
+    juce::Rectangle<float> spectrumArea, scopeArea;
+    double lastPollMs = 0.0;
+
+    bool update (Trace& t, AnalyzerFifo& fifo, float fall)
+    {
+        // Keep only the newest fftSize samples of whatever arrived
+        const int n = fifo.pull (drained.data(), (int) drained.size());
+        const int keep = juce::jmin (n, fftSize);
+
+        if (keep > 0)
+        {
+            std::copy (t.history.begin() + keep, t.history.end(), t.history.begin());
+            std::copy_n (drained.data() + (n - keep), keep, t.history.end() - keep);
+            t.fresh += n;
+        }
+
+        bool changed = false;
+
+        for (auto& db : t.smoothedDb)
+        {
+            if (db > floorDb)
+            {
+                db = juce::jmax (floorDb, db - fall);
+                changed = true;
+            }
+        }
+
+        if (t.fresh < hopSize)
+            return changed || n > 0;
+
+        t.fresh = 0;
+        std::copy (t.history.begin(), t.history.end(), t.fftData.begin());
+        window.multiplyWithWindowingTable (t.fftData.data(), (size_t) fftSize);
+        fft.performFrequencyOnlyForwardTransform (t.fftData.data());
+
+        // A full-scale sine reads 0 dB: the Hann window halves the coherent gain
+        constexpr float scale = 4.0f / (float) fftSize;
+
+        for (size_t bin = 0; bin < t.smoothedDb.size(); ++bin)
+            t.smoothedDb[bin] = juce::jmax (t.smoothedDb[bin], juce::Decibels::gainToDecibels (t.fftData[bin] * scale, floorDb));
+
+        return true;
+    }
+
+    float xForHz (float hz) const
+    {
+        return spectrumArea.getX() + spectrumArea.getWidth() * std::log (hz / minHz) / std::log (maxHz / minHz);
+    }
+
+    void rebuildPaths()
+    {
+        const double sampleRate = processor.getSampleRate() > 0.0 ? processor.getSampleRate() : 44100.0;
+
+        for (auto* t : { &pre, &post })
+        {
+            t->path.clear();
+            t->path.preallocateSpace (3 * (int) spectrumArea.getWidth() + 12);
+
+            // One point per pixel column, interpolated between bins
+            for (int x = 0; x <= (int) spectrumArea.getWidth(); ++x)
+            {
+                const auto hz = minHz * std::pow (maxHz / minHz, (float) x / spectrumArea.getWidth());
+                const auto bin = juce::jlimit (0.0f, (float) t->smoothedDb.size() - 2.0f, (float) (hz * fftSize / sampleRate));
+                const auto i = (size_t) bin;
+                const auto db = juce::jmap (bin - (float) i, t->smoothedDb[i], t->smoothedDb[i + 1]);
+                const auto y = juce::jmap (db, floorDb, 0.0f, spectrumArea.getBottom(), spectrumArea.getY());
+                const auto px = spectrumArea.getX() + (float) x;
+
+                if (x == 0)
+                    t->path.startNewSubPath (px, y);
+                else
+                    t->path.lineTo (px, y);
+            }
+        }
+
+        // Scope: the newest post samples, from a rising zero crossing so the trace holds still
+        scopePath.clear();
+        scopePath.preallocateSpace (3 * scopeSamples + 12);
+
+        int start = fftSize - scopeSamples;
+        for (int i = fftSize - scopeSamples - 1; i > fftSize - 2 * scopeSamples; --i)
+        {
+            if (post.history[(size_t) i - 1] < 0.0f && post.history[(size_t) i] >= 0.0f)
+            {
+                start = i;
+                break;
+            }
+        }
+
+        for (int i = 0; i < scopeSamples; ++i)
+        {
+            const auto x = scopeArea.getX() + scopeArea.getWidth() * (float) i / (float) (scopeSamples - 1);
+            const auto v = juce::jlimit (-1.0f, 1.0f, post.history[(size_t) (start + i)]);
+            const auto y = scopeArea.getCentreY() - v * scopeArea.getHeight() * 0.45f;
+
+            if (i == 0)
+                scopePath.startNewSubPath (x, y);
+            else
+                scopePath.lineTo (x, y);
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrumAnalyzer)
+};
@@ -0,0 +1,301 @@
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+
+// ===== HPF -> LPF filter engine =====
+// Topology-preserving state-variable filters (Zavalishin / Simper form), one 12 dB/oct
+// Butterworth section each, so the response matches the RBJ biquads this replaces.
+// Coefficients are plain members recomputed only while a cutoff is moving: nothing is
+// allocated after prepare(). Cutoff changes are smoothed in the log domain and applied
+// every subBlockSize samples; the TPT structure stays stable under that modulation,
+// which a direct-form biquad does not guarantee.
+//
+// Channels are packed into the lanes of a juce::dsp::SIMDRegister (L/R share one
+// register) and both sections run in the same pass. A single channel uses the scalar
+// kernel, which is also kept as the reference implementation (setScalarReference).
+template <typename SampleType>
+class SvfFilterEngine
+{
+public:
+    using Vec = juce::dsp::SIMDRegister<SampleType>;
+    static constexpr size_t lanes = Vec::SIMDNumElements;
+    static constexpr int subBlockSize = 16;
+
+    void prepare (const juce::dsp::ProcessSpec& spec)
+    {
+        sampleRate = spec.sampleRate;
+        numChannels = spec.numChannels;
+
+        groups.assign ((numChannels + lanes - 1) / lanes, GroupState {});
+        frames.assign (spec.maximumBlockSize, Vec::expand ((SampleType) 0));
+
+        const double subBlocksPerSecond = sampleRate / subBlockSize;
+        hpfHz.reset (subBlocksPerSecond, smoothingSeconds);
+        lpfHz.reset (subBlocksPerSecond, smoothingSeconds);
+
+        snapOnNextUpdate = true;
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        for (auto& g : groups)
+            g = {};
+    }
+
+    // Sets the cutoff targets. The first call after prepare() jumps straight to them.
+    void setCutoffs (SampleType hpfCutoff, SampleType lpfCutoff) noexcept
+    {
+        hpfCutoff = clampCutoff (hpfCutoff);
+        lpfCutoff = clampCutoff (lpfCutoff);
+
+        if (snapOnNextUpdate)
+        {
+            hpfHz.setCurrentAndTargetValue (hpfCutoff);
+            lpfHz.setCurrentAndTargetValue (lpfCutoff);
+            updateCoefficients (hpfCutoff, lpfCutoff);
+            snapOnNextUpdate = false;
+            return;
+        }
+
+        hpfHz.setTargetValue (hpfCutoff);
+        lpfHz.setTargetValue (lpfCutoff);
+    }
+
+    bool isSmoothing() const noexcept { return hpfHz.isSmoothing() || lpfHz.isSmoothing(); }
+
+    // Gives channel 1 the filter state of channel 0 (after a stretch of mono processing).
+    void copyLeftToRight() noexcept
+    {
+        if (numChannels < 2)
+            return;
+
+        auto& g = groups[0];
+        for (auto* v : { &g.hp1, &g.hp2, &g.lp1, &g.lp2 })
+            v->set (1, v->get (0));
+    }
+
+    // Forces the scalar kernel on every channel (benchmarks and reference renders).
+    void setScalarReference (bool shouldUseScalar) noexcept { scalarReference = shouldUseScalar; }
+
+    template <typename ProcessContext>
+    void process (const ProcessContext& context) noexcept
+    {
+        const auto& inputBlock = context.getInputBlock();
+        auto& outputBlock      = context.getOutputBlock();
+        const auto numSamples  = outputBlock.getNumSamples();
+
+        jassert (inputBlock.getNumChannels() == outputBlock.getNumChannels());
+        jassert (inputBlock.getNumSamples() == numSamples);
+
+        // The interleave scratch holds one prepared block: anything longer goes through in
+        // pieces of that size
+        const auto chunkSize = frames.size();
+
+        for (size_t offset = 0; offset < numSamples && chunkSize > 0; offset += chunkSize)
+        {
+            const auto len = juce::jmin (chunkSize, numSamples - offset);
+            auto in = inputBlock.getSubBlock (offset, len);
+            auto out = outputBlock.getSubBlock (offset, len);
+            processChunk (in, out, (int) len);
+        }
+    }
+
+private:
+    struct Section { SampleType a1 = 0, a2 = 0, a3 = 0; };
+    struct GroupState { Vec hp1 = Vec::expand (0), hp2 = Vec::expand (0), lp1 = Vec::expand (0), lp2 = Vec::expand (0); };
+
+    static constexpr SampleType k = (SampleType) 1.4142135623730951; // 1 / Q, Butterworth
+    static constexpr double smoothingSeconds = 0.02;
+
+    double sampleRate = 44100.0;
+    size_t numChannels = 0;
+    Section hp, lp;
+    std::vector<GroupState> groups;
+    std::vector<Vec> frames; // interleaved scratch, one register per sample frame
+
+    juce::SmoothedValue<SampleType, juce::ValueSmoothingTypes::Multiplicative> hpfHz { (SampleType) 120 }, lpfHz { (SampleType) 16000 };
+    bool snapOnNextUpdate = true, scalarReference = false;
+
+    // At most frames.size() samples
+    template <typename InBlock, typename OutBlock>
+    void processChunk (const InBlock& inputBlock, OutBlock& outputBlock, int numSamples) noexcept
+    {
+        const auto channels = juce::jmin (outputBlock.getNumChannels(), numChannels);
+        const bool vectorise = channels > 1 && ! scalarReference;
+
+        for (size_t first = 0; first < channels; first += (vectorise ? lanes : 1))
+        {
+            const auto count = vectorise ? juce::jmin (lanes, channels - first) : (size_t) 1;
+
+            if (vectorise)
+                interleave (inputBlock, first, count, numSamples);
+
+            forEachSubBlock (numSamples, [&] (int start, int len)
+            {
+                if (vectorise)
+                    processFrames (start, len, groups[first / lanes]);
+                else
+                    processScalar (inputBlock.getChannelPointer (first) + start,
+                                   outputBlock.getChannelPointer (first) + start, len, first);
+            });
+
+            if (vectorise)
+                deinterleave (outputBlock, first, count, numSamples);
+        }
+
+        advanceSmoothing (numSamples);
+    }
+
+    SampleType clampCutoff (SampleType hz) const noexcept
+    {
+        return juce::jlimit ((SampleType) 10, (SampleType) (sampleRate * 0.49), hz);
+    }
+
+    Section makeSection (SampleType hz) const noexcept
+    {
+        const auto g = (SampleType) std::tan (juce::MathConstants<double>::pi * (double) hz / sampleRate);
+
+        Section s;
+        s.a1 = (SampleType) 1 / ((SampleType) 1 + g * (g + k));
+        s.a2 = g * s.a1;
+        s.a3 = g * s.a2;
+        return s;
+    }
+
+    void updateCoefficients (SampleType hpfCutoff, SampleType lpfCutoff) noexcept
+    {
+        hp = makeSection (hpfCutoff);
+        lp = makeSection (lpfCutoff);
+    }
+
+    // Walks the block in sub-blocks, stepping the cutoff ramp at each boundary. The ramp
+    // is replayed identically for each channel group and committed by advanceSmoothing().
+    template <typename Fn>
+    void forEachSubBlock (int numSamples, Fn&& fn) noexcept
+    {
+        if (! isSmoothing())
+        {
+            fn (0, numSamples);
+            return;
+        }
+
+        auto hpRamp = hpfHz;
+        auto lpRamp = lpfHz;
+
+        for (int start = 0; start < numSamples; start += subBlockSize)
+        {
+            if (hpRamp.isSmoothing() || lpRamp.isSmoothing())
+                updateCoefficients (hpRamp.getNextValue(), lpRamp.getNextValue());
+
+            fn (start, juce::jmin (subBlockSize, numSamples - start));
+        }
+    }
+
+    void advanceSmoothing (int numSamples) noexcept
+    {
+        if (! isSmoothing())
+            return;
+
+        for (int start = 0; start < numSamples; start += subBlockSize)
+        {
+            hpfHz.getNextValue();
+            lpfHz.getNextValue();
+        }
+
+        updateCoefficients (hpfHz.getCurrentValue(), lpfHz.getCurrentValue());
+    }
+
+    template <typename Block>
+    void interleave (const Block& block, size_t first, size_t count, int numSamples) noexcept
+    {
+        auto* raw = reinterpret_cast<SampleType*> (frames.data());
+
+        for (size_t lane = 0; lane < count; ++lane)
+        {
+            const auto* src = block.getChannelPointer (first + lane);
+            for (int i = 0; i < numSamples; ++i)
+                raw[(size_t) i * lanes + lane] = src[i];
+        }
+    }
+
+    template <typename Block>
+    void deinterleave (Block& block, size_t first, size_t count, int numSamples) const noexcept
+    {
+        const auto* raw = reinterpret_cast<const SampleType*> (frames.data());
+
+        for (size_t lane = 0; lane < count; ++lane)
+        {
+            auto* dst = block.getChannelPointer (first + lane);
+            for (int i = 0; i < numSamples; ++i)
+                dst[i] = raw[(size_t) i * lanes + lane];
+        }
+    }
+
+    void processFrames (int start, int len, GroupState& group) noexcept
+    {
+        const auto kv  = Vec::expand (k), two = Vec::expand ((SampleType) 2);
+        const auto ha1 = Vec::expand (hp.a1), ha2 = Vec::expand (hp.a2), ha3 = Vec::expand (hp.a3);
+        const auto la1 = Vec::expand (lp.a1), la2 = Vec::expand (lp.a2), la3 = Vec::expand (lp.a3);
+
+        auto s = group;
+        auto* frame = frames.data() + start;
+
+        for (int i = 0; i < len; ++i)
+        {
+            const auto x = frame[i];
+
+            auto v3 = x - s.hp2;
+            auto v1 = ha1 * s.hp1 + ha2 * v3;
+            auto v2 = s.hp2 + ha2 * s.hp1 + ha3 * v3;
+            s.hp1 = two * v1 - s.hp1;
+            s.hp2 = two * v2 - s.hp2;
+
+            const auto high = x - kv * v1 - v2;
+
+            v3 = high - s.lp2;
+            v1 = la1 * s.lp1 + la2 * v3;
+            v2 = s.lp2 + la2 * s.lp1 + la3 * v3;
+            s.lp1 = two * v1 - s.lp1;
+            s.lp2 = two * v2 - s.lp2;
+
+            frame[i] = v2;
+        }
+
+        group = s;
+    }
+
+    // Scalar reference: same arithmetic, state read from and written back to its lane.
+    void processScalar (const SampleType* in, SampleType* out, int numSamples, size_t channel) noexcept
+    {
+        auto& group = groups[channel / lanes];
+        const auto lane = channel % lanes;
+
+        SampleType hp1 = group.hp1.get (lane), hp2 = group.hp2.get (lane);
+        SampleType lp1 = group.lp1.get (lane), lp2 = group.lp2.get (lane);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto x = in[i];
+
+            auto v3 = x - hp2;
+            auto v1 = hp.a1 * hp1 + hp.a2 * v3;
+            auto v2 = hp2 + hp.a2 * hp1 + hp.a3 * v3;
+            hp1 = (SampleType) 2 * v1 - hp1;
+            hp2 = (SampleType) 2 * v2 - hp2;
+
+            const auto high = x - k * v1 - v2;
+
+            v3 = high - lp2;
+            v1 = lp.a1 * lp1 + lp.a2 * v3;
+            v2 = lp2 + lp.a2 * lp1 + lp.a3 * v3;
+            lp1 = (SampleType) 2 * v1 - lp1;
+            lp2 = (SampleType) 2 * v2 - lp2;
+
+            out[i] = v2;
+        }
+
+        group.hp1.set (lane, hp1); group.hp2.set (lane, hp2);
+        group.lp1.set (lane, lp1); group.lp2.set (lane, lp2);
+    }
+};
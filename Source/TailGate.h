@@ -0,0 +1,77 @@
+#pragma once
+#include <JuceHeader.h>
+#include <cmath>
+
+// ===== Stage sleeping =====
+// A stage whose input has been silent for longer than its tail produces nothing audible,
+// so it can be skipped. Each stage keeps one TailGate: the processor tells it whether
+// the stage's input was silent this block and how long the stage rings (from its current
+// parameters), and the gate says whether the stage still has to run. The block the stage
+// falls asleep, flush() clears its state so that it wakes up from zeros, not from a
+// half-decayed buffer full of denormals.
+//
+// Silence is measured once, on the chain input: a stage's input is silent when the chain
+// input is and every running stage before it is asleep.
+class TailGate
+{
+public:
+    // -120 dB: inaudible even after +48 dB of input and output gain
+    static constexpr float silenceThreshold = 1.0e-6f;
+    static constexpr double sleepDecayDb = 120.0;
+
+    template <typename FlushFn>
+    bool shouldRun (bool inputSilent, int numSamples, juce::int64 tailSamples, FlushFn&& flush) noexcept
+    {
+        if (! inputSilent)
+        {
+            silentSamples = 0;
+            asleep = false;
+            return true;
+        }
+
+        if (asleep)
+            return false;
+
+        // Run until the whole tail has been rendered, then sleep
+        if (silentSamples < tailSamples)
+        {
+            silentSamples += numSamples;
+            return true;
+        }
+
+        asleep = true;
+        flush();
+        return false;
+    }
+
+    bool isAsleep() const noexcept { return asleep; }
+
+    void reset() noexcept
+    {
+        silentSamples = 0;
+        asleep = false;
+    }
+
+    // Time for a recirculating delay of `loopSeconds` with loop gain |feedback| to fall
+    // by decayDb, plus the first pass.
+    static double feedbackTailSeconds (double loopSeconds, double feedback, double decayDb) noexcept
+    {
+        const auto g = std::abs (feedback);
+
+        if (g < 1.0e-3)
+            return loopSeconds;
+
+        const auto passes = decayDb / (-20.0 * std::log10 (juce::jmin (g, 0.9999)));
+        return loopSeconds * (1.0 + passes);
+    }
+
+    // Time for an exponential decay with the given RT60 to fall by decayDb.
+    static double rt60TailSeconds (double rt60, double decayDb) noexcept
+    {
+        return rt60 * decayDb / 60.0;
+    }
+
+private:
+    juce::int64 silentSamples = 0;
+    bool asleep = false;
+};
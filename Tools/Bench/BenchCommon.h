@@ -0,0 +1,86 @@
+#pragma once
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "CycleCounter.h"
+#include <chrono>
+#include <iostream>
+
+// Shared helpers for UltimateAdlibsBench.
+namespace Bench
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Wall time and counter ticks (see CycleCounter) for one unit of work.
+    struct Timing
+    {
+        double ns = 0.0;
+        double cycles = 0.0;
+
+        Timing operator- (const Timing& other) const noexcept { return { ns - other.ns, cycles - other.cycles }; }
+        Timing operator/ (double d) const noexcept            { return { ns / d, cycles / d }; }
+    };
+
+    // Calls fn once to warm up, then `iterations` times; returns the average per call.
+    template <typename Fn>
+    Timing timePerCall (int iterations, Fn&& fn)
+    {
+        fn();
+
+        const auto startCycles = CycleCounter::now();
+        const auto start = Clock::now();
+
+        for (int i = 0; i < iterations; ++i)
+            fn();
+
+        const auto end = Clock::now();
+        const auto endCycles = CycleCounter::now();
+
+        return Timing { (double) std::chrono::duration_cast<std::chrono::nanoseconds> (end - start).count(),
+                        (double) (endCycles - startCycles) } / (double) iterations;
+    }
+
+    inline juce::String formatPerSample (const Timing& perBlock, int blockSize)
+    {
+        const auto t = perBlock / (double) blockSize;
+        return juce::String (t.ns, 3) + " ns/sample, " + juce::String (t.cycles, 1) + " cycles/sample";
+    }
+
+    template <typename SampleType>
+    void fillWithNoise (juce::AudioBuffer<SampleType>& buffer, juce::Random& rng)
+    {
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                buffer.setSample (ch, i, (SampleType) (rng.nextFloat() * 2.0f - 1.0f));
+    }
+
+    inline void setParameter (UltimateAdlibsAudioProcessor& processor, Param id, float value)
+    {
+        auto* param = processor.apvts.getParameter (paramId (id));
+        param->setValueNotifyingHost (param->convertTo0to1 (value));
+    }
+
+    // The usual layout for a channel count: 6 is 5.1 and 12 is 7.1.4.
+    inline juce::AudioChannelSet channelSetFor (int numChannels)
+    {
+        return numChannels == 12 ? juce::AudioChannelSet::create7point1point4()
+                                 : juce::AudioChannelSet::canonicalChannelSet (numChannels);
+    }
+
+    // Main input and output channel counts; call before prepareToPlay.
+    inline bool setChannelLayout (UltimateAdlibsAudioProcessor& processor, int numInputs, int numOutputs)
+    {
+        juce::AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add (channelSetFor (numInputs));
+        layout.outputBuses.add (channelSetFor (numOutputs));
+
+        processor.releaseResources();
+        return processor.setBusesLayout (layout);
+    }
+
+    int runKernelBenchmarks (int blockSize, int iterations);
+    int runChainSuite (const juce::ArgumentList& args);
+    int checkAudioThreadAllocations (int blockSize, int numBlocks);
+    int runIdleBenchmark (int blockSize, int numInstances);
+    int runPaintBenchmark (int iterations);
+    int runStateBenchmark (int numInstances, int iterations);
+}
@@ -0,0 +1,455 @@
+#include "BenchCommon.h"
+#include "AllocationTracer.h"
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <vector>
+
+// Whole-processor benchmarks: processBlock swept over stage combinations, sample rates,
+// block sizes, channel layouts and sample precisions, plus the audio-thread allocation
+// check.
+
+namespace Bench
+{
+namespace
+{
+    constexpr Param stageToggles[] = { Param::FILT_ON, Param::DIST_ON, Param::CHO_ON,
+                                       Param::FLA_ON,  Param::DLY_ON,  Param::REV_ON };
+
+    struct StageConfig
+    {
+        const char* name;
+        ParamMask enabled;
+        bool analyzer = false;
+    };
+
+    // "none" is the fixed cost of the chain (gains, meters, snapshot) and "analyzer" that
+    // plus the analyzer taps; every other config is a single stage on its own, then
+    // everything on.
+    const StageConfig stageConfigs[] =
+    {
+        { "none",    0 },
+        { "analyzer", 0, true },
+        { "filter",  maskOf (Param::FILT_ON) },
+        { "dist",    maskOf (Param::DIST_ON) },
+        { "chorus",  maskOf (Param::CHO_ON) },
+        { "flanger", maskOf (Param::FLA_ON) },
+        { "delay",   maskOf (Param::DLY_ON) },
+        { "reverb",  maskOf (Param::REV_ON) },
+        { "all",     maskOf (Param::FILT_ON, Param::DIST_ON, Param::CHO_ON, Param::FLA_ON, Param::DLY_ON, Param::REV_ON) },
+    };
+
+    // "dual-mono" is the stereo layout fed identical channels; with "mono-stereo" it shows
+    // the work saved by running the chain on one channel up to the fan-out. The offline
+    // 7.1.4 case renders as a host bouncing would, with the channel groups in parallel.
+    struct Layout
+    {
+        const char* name;
+        int numInputs, numOutputs;
+        bool dualMono;
+        bool offline = false;
+    };
+
+    constexpr Layout monoLayout          { "mono",          1,  1,  false };
+    constexpr Layout stereoLayout        { "stereo",        2,  2,  false };
+    constexpr Layout monoStereoLayout    { "mono-stereo",   1,  2,  false };
+    constexpr Layout dualMonoLayout      { "dual-mono",     2,  2,  true };
+    constexpr Layout surroundLayout      { "5.1",           6,  6,  false };
+    constexpr Layout immersiveLayout     { "7.1.4",         12, 12, false };
+    constexpr Layout immersiveOffline    { "7.1.4-offline", 12, 12, false, true };
+
+    // Double-precision cases carry a "/double" suffix, so float case names stay comparable
+    // with baselines recorded before the double chain existed.
+    using Precision = juce::AudioProcessor::ProcessingPrecision;
+
+    const char* precisionName (Precision precision) noexcept
+    {
+        return precision == juce::AudioProcessor::doublePrecision ? "double" : "float";
+    }
+
+    struct CaseResult
+    {
+        juce::String name, config, layout, precision;
+        double sampleRate = 0.0;
+        int blockSize = 0, numChannels = 0;
+        Timing perSample;
+        DspLoadSnapshot load;
+    };
+
+    void applyStageConfig (UltimateAdlibsAudioProcessor& processor, ParamMask enabled)
+    {
+        for (auto toggle : stageToggles)
+            setParameter (processor, toggle, (enabled & maskOf (toggle)) != 0 ? 1.0f : 0.0f);
+    }
+
+    // Median of `repeats` runs, each processing `seconds / repeats` of noise. Only the
+    // processBlock call itself is inside the timed region. `load` receives the processor's
+    // own per-stage counters, accumulated over all runs.
+    template <typename SampleType>
+    Timing measureCase (UltimateAdlibsAudioProcessor& processor, double sampleRate, int blockSize,
+                        const Layout& layout, double seconds, int repeats, bool analyzer, DspLoadSnapshot& load)
+    {
+        processor.setAnalyzerActive (analyzer);
+        std::vector<float> drained (analyzer ? (size_t) AnalyzerFifo::capacity : 0);
+
+        processor.setProcessingPrecision (std::is_same_v<SampleType, double> ? juce::AudioProcessor::doublePrecision
+                                                                            : juce::AudioProcessor::singlePrecision);
+        processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+        processor.setNonRealtime (layout.offline);
+        processor.prepareToPlay (sampleRate, blockSize);
+
+        juce::Random rng (7);
+        juce::AudioBuffer<SampleType> source (layout.numInputs, blockSize * 16), buffer (layout.numOutputs, blockSize);
+        juce::MidiBuffer midi;
+        fillWithNoise (source, rng);
+
+        if (layout.dualMono)
+            source.copyFrom (1, 0, source, 0, 0, source.getNumSamples());
+
+        const int blocksPerRun = juce::jmax (1, (int) (seconds * sampleRate / repeats) / blockSize);
+        int sourceBlock = 0;
+
+        auto runBlocks = [&] (int numBlocks)
+        {
+            Timing total;
+
+            for (int b = 0; b < numBlocks; ++b)
+            {
+                for (int ch = 0; ch < layout.numInputs; ++ch)
+                    buffer.copyFrom (ch, 0, source, ch, sourceBlock * blockSize, blockSize);
+
+                sourceBlock = (sourceBlock + 1) % 16;
+
+                const auto c0 = CycleCounter::now();
+                const auto t0 = Clock::now();
+                processor.processBlock (buffer, midi);
+                const auto t1 = Clock::now();
+                const auto c1 = CycleCounter::now();
+
+                total.ns     += (double) std::chrono::duration_cast<std::chrono::nanoseconds> (t1 - t0).count();
+                total.cycles += (double) (c1 - c0);
+
+                // The editor's side of the taps, outside the timed region
+                if (analyzer)
+                    for (bool post : { false, true })
+                        processor.getAnalyzerTap (post).pull (drained.data(), (int) drained.size());
+            }
+
+            return total / ((double) numBlocks * blockSize);
+        };
+
+        // Warm-up: caches, denormal-free state. Dual mono only starts once the stage tails
+        // have seen identical channels; the reported tail (to -60 dB) doubled covers that.
+        const double warmUpSeconds = layout.dualMono ? 2.0 * processor.getTailLengthSeconds() + 0.1 : 0.0;
+        runBlocks (juce::jmax (juce::jmax (1, blocksPerRun / 4), (int) (warmUpSeconds * sampleRate) / blockSize));
+        processor.resetDspLoad();
+
+        std::vector<Timing> runs;
+        for (int r = 0; r < repeats; ++r)
+            runs.push_back (runBlocks (blocksPerRun));
+
+        std::sort (runs.begin(), runs.end(), [] (const Timing& a, const Timing& b) { return a.ns < b.ns; });
+        load = processor.getDspLoad();
+        processor.setAnalyzerActive (false);
+        processor.releaseResources();
+        processor.setNonRealtime (false);
+        return runs[runs.size() / 2];
+    }
+
+    juce::var resultsToJson (const std::vector<CaseResult>& results)
+    {
+        juce::Array<juce::var> cases;
+
+        for (const auto& r : results)
+        {
+            auto* c = new juce::DynamicObject();
+            c->setProperty ("name", r.name);
+            c->setProperty ("config", r.config);
+            c->setProperty ("sampleRate", r.sampleRate);
+            c->setProperty ("blockSize", r.blockSize);
+            c->setProperty ("channels", r.numChannels);
+            c->setProperty ("layout", r.layout);
+            c->setProperty ("precision", r.precision);
+            c->setProperty ("nsPerSample", r.perSample.ns);
+            c->setProperty ("cyclesPerSample", r.perSample.cycles);
+
+            if (DspLoadMeter::enabled)
+            {
+                auto* stages = new juce::DynamicObject();
+
+                for (int s = 0; s < numStages; ++s)
+                    if (r.load.stages[(size_t) s].totalTicks > 0)
+                        stages->setProperty (stageName ((StageId) s), r.load.nsPerSample (r.load.stages[(size_t) s]));
+
+                if (r.load.analyzer.totalTicks > 0)
+                    stages->setProperty ("analyzer", r.load.nsPerSample (r.load.analyzer));
+
+                c->setProperty ("stageNsPerSample", juce::var (stages));
+            }
+
+            cases.add (juce::var (c));
+        }
+
+        auto* root = new juce::DynamicObject();
+        root->setProperty ("version", 1);
+        root->setProperty ("cpu", juce::SystemStats::getCpuModel());
+        root->setProperty ("cases", cases);
+        return juce::var (root);
+    }
+
+    std::map<juce::String, double> loadBaseline (const juce::File& file)
+    {
+        std::map<juce::String, double> nsByCase;
+        const auto json = juce::JSON::parse (file);
+
+        if (auto* cases = json["cases"].getArray())
+            for (const auto& c : *cases)
+                nsByCase[c["name"].toString()] = (double) c["nsPerSample"];
+
+        return nsByCase;
+    }
+}
+
+// ===== Chain suite =====
+//   --quick               48 kHz stereo float, three block sizes
+//   --seconds=<s>         audio per case (default 1, split over 5 runs)
+//   --filter=<text>       only cases whose name contains <text>
+//   --json=<file>         write results
+//   --baseline=<file>     compare against an earlier --json run
+//   --tolerance=<pct>     with --baseline: exit 3 if any case is slower by more than <pct>
+int runChainSuite (const juce::ArgumentList& args)
+{
+    const bool quick = args.containsOption ("--quick");
+
+    const std::vector<double> sampleRates = quick ? std::vector<double> { 48000.0 }
+                                                  : std::vector<double> { 44100.0, 48000.0, 96000.0, 192000.0 };
+    const std::vector<int> blockSizes = quick ? std::vector<int> { 64, 512, 4096 }
+                                              : std::vector<int> { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+    const std::vector<Layout> layouts = quick ? std::vector<Layout> { stereoLayout }
+                                              : std::vector<Layout> { monoLayout, stereoLayout, monoStereoLayout, dualMonoLayout,
+                                                                      surroundLayout, immersiveLayout, immersiveOffline };
+    const std::vector<Precision> precisions = quick ? std::vector<Precision> { juce::AudioProcessor::singlePrecision }
+                                                    : std::vector<Precision> { juce::AudioProcessor::singlePrecision,
+                                                                               juce::AudioProcessor::doublePrecision };
+
+    const double seconds = args.containsOption ("--seconds") ? args.getValueForOption ("--seconds").getDoubleValue()
+                                                             : (quick ? 0.25 : 1.0);
+    const auto filter = args.getValueForOption ("--filter");
+
+    std::map<juce::String, double> baseline;
+    if (args.containsOption ("--baseline"))
+        baseline = loadBaseline (args.getFileForOption ("--baseline"));
+
+    const double tolerance = args.getValueForOption ("--tolerance").getDoubleValue();
+    const bool checkTolerance = args.containsOption ("--tolerance") && ! baseline.empty();
+
+    UltimateAdlibsAudioProcessor processor;
+    std::vector<CaseResult> results;
+    int regressions = 0;
+
+    std::cout << juce::String ("case").paddedRight (' ', 40) << "ns/sample  cycles/sample"
+              << (baseline.empty() ? "" : "   baseline    change") << "\n";
+
+    for (const auto& layout : layouts)
+    {
+        if (! setChannelLayout (processor, layout.numInputs, layout.numOutputs))
+            continue;
+
+        for (const auto& config : stageConfigs)
+        {
+            applyStageConfig (processor, config.enabled);
+
+            for (double sampleRate : sampleRates)
+            {
+                for (int blockSize : blockSizes)
+                {
+                    for (auto precision : precisions)
+                    {
+                        CaseResult r;
+                        r.config = config.name;
+                        r.sampleRate = sampleRate;
+                        r.blockSize = blockSize;
+                        r.layout = layout.name;
+                        r.precision = precisionName (precision);
+                        r.numChannels = layout.numOutputs;
+                        r.name = r.config + "/" + juce::String ((int) sampleRate) + "/" + juce::String (blockSize)
+                               + "/" + r.layout + (precision == juce::AudioProcessor::doublePrecision ? "/double" : "");
+
+                        if (filter.isNotEmpty() && ! r.name.contains (filter))
+                            continue;
+
+                        r.perSample = precision == juce::AudioProcessor::doublePrecision
+                                        ? measureCase<double> (processor, sampleRate, blockSize, layout, seconds, 5, config.analyzer, r.load)
+                                        : measureCase<float>  (processor, sampleRate, blockSize, layout, seconds, 5, config.analyzer, r.load);
+                        results.push_back (r);
+
+                        std::cout << r.name.paddedRight (' ', 40)
+                                  << juce::String (r.perSample.ns, 3).paddedLeft (' ', 9)
+                                  << juce::String (r.perSample.cycles, 1).paddedLeft (' ', 15);
+
+                        const auto base = baseline.find (r.name);
+                        if (base != baseline.end() && base->second > 0.0)
+                        {
+                            const double change = 100.0 * (r.perSample.ns - base->second) / base->second;
+                            std::cout << juce::String (base->second, 3).paddedLeft (' ', 11)
+                                      << (juce::String (change >= 0.0 ? "+" : "") + juce::String (change, 1) + "%").paddedLeft (' ', 10);
+
+                            if (checkTolerance && change > tolerance)
+                            {
+                                std::cout << "  REGRESSION";
+                                ++regressions;
+                            }
+                        }
+
+                        std::cout << std::endl;
+                    }
+                }
+            }
+        }
+    }
+
+    if (args.containsOption ("--json"))
+    {
+        const auto file = juce::File::getCurrentWorkingDirectory().getChildFile (args.getValueForOption ("--json"));
+
+        if (! file.replaceWithText (juce::JSON::toString (resultsToJson (results))))
+        {
+            std::cerr << "cannot write " << file.getFullPathName() << "\n";
+            return 1;
+        }
+    }
+
+    return regressions == 0 ? 0 : 3;
+}
+
+// ===== Sparse sessions =====
+// `numInstances` processors with every stage on, as on a session of mostly empty tracks:
+// one second of noise, then silence. Reports the cost per instance and sample while
+// playing, while the tails ring out, and once every stage has gone to sleep.
+int runIdleBenchmark (int blockSize, int numInstances)
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int numChannels = 2;
+
+    std::vector<std::unique_ptr<UltimateAdlibsAudioProcessor>> instances;
+
+    for (int i = 0; i < numInstances; ++i)
+    {
+        auto& processor = *instances.emplace_back (std::make_unique<UltimateAdlibsAudioProcessor>());
+        applyStageConfig (processor, stageConfigs[std::size (stageConfigs) - 1].enabled);
+        processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+        processor.prepareToPlay (sampleRate, blockSize);
+    }
+
+    juce::Random rng (7);
+    juce::AudioBuffer<float> source (numChannels, blockSize), buffer (numChannels, blockSize);
+    juce::MidiBuffer midi;
+    fillWithNoise (source, rng);
+
+    auto run = [&] (double seconds, bool playing)
+    {
+        const int numBlocks = juce::jmax (1, (int) (seconds * sampleRate) / blockSize);
+        double ns = 0.0;
+
+        for (int b = 0; b < numBlocks; ++b)
+        {
+            for (auto& processor : instances)
+            {
+                if (playing)
+                    buffer.makeCopyOf (source, true);
+                else
+                    buffer.clear();
+
+                const auto t0 = Clock::now();
+                processor->processBlock (buffer, midi);
+                ns += (double) std::chrono::duration_cast<std::chrono::nanoseconds> (Clock::now() - t0).count();
+            }
+        }
+
+        return ns / ((double) numBlocks * blockSize * numInstances);
+    };
+
+    // The reported tail is to -60 dB; stages sleep at -120 dB, twice as late
+    const double settle = 2.0 * instances.front()->getTailLengthSeconds() + 0.5;
+
+    const double playing = run (1.0, true);
+    const double ringing = run (settle, false);
+    const double idle = run (1.0, false);
+
+    std::cout << numInstances << " instances, all stages on, 48 kHz / " << blockSize << ", "
+              << juce::String (settle, 2) << " s to settle\n"
+              << "  playing  " << juce::String (playing, 3).paddedLeft (' ', 9) << " ns/sample per instance\n"
+              << "  tails    " << juce::String (ringing, 3).paddedLeft (' ', 9) << " ns/sample per instance\n"
+              << "  silent   " << juce::String (idle, 3).paddedLeft (' ', 9) << " ns/sample per instance\n";
+
+    return 0;
+}
+
+// ===== Audio-thread allocations and locks =====
+namespace
+{
+    struct AudioThreadCounts
+    {
+        int allocations = 0, locks = 0;
+    };
+
+    // Host blocks of random length, up to twice the prepared size so the chunked path
+    // runs too, under random automation of every parameter and preset morphs.
+    template <typename SampleType>
+    AudioThreadCounts countAudioThreadEvents (int blockSize, int numBlocks)
+    {
+        UltimateAdlibsAudioProcessor processor;
+        processor.setProcessingPrecision (std::is_same_v<SampleType, double> ? juce::AudioProcessor::doublePrecision
+                                                                            : juce::AudioProcessor::singlePrecision);
+        processor.prepareToPlay (48000.0, blockSize);
+        processor.setAnalyzerActive (true); // the taps must not allocate either
+        processor.setPresetMorphMs (200.0f); // nor must a preset morph, which spans many blocks
+
+        juce::AudioBuffer<SampleType> buffer (2, blockSize * 2);
+        juce::MidiBuffer midi;
+        juce::Random rng (42);
+
+        AllocationTracer::resetCounters();
+
+        for (int b = 0; b < numBlocks; ++b)
+        {
+            // A few parameters move every block, as a host playing back automation would
+            for (int n = rng.nextInt (4); --n >= 0;)
+                processor.apvts.getParameter (paramId ((Param) rng.nextInt (numParameters)))->setValueNotifyingHost (rng.nextFloat());
+
+            if (b % 100 == 50)
+                processor.setCurrentProgram ((b / 100) % processor.getNumPrograms());
+
+            juce::AudioBuffer<SampleType> block (buffer.getArrayOfWritePointers(), 2, 1 + rng.nextInt (blockSize * 2));
+            fillWithNoise (block, rng);
+
+            AllocationTracer::ScopedAudioThread audioThread;
+            processor.processBlock (block, midi);
+        }
+
+        return { AllocationTracer::getNumAllocations(), AllocationTracer::getNumLocks() };
+    }
+}
+
+// Both precisions; either one allocating or blocking on a lock fails the check.
+int checkAudioThreadAllocations (int blockSize, int numBlocks)
+{
+    int total = 0;
+
+    for (auto precision : { juce::AudioProcessor::singlePrecision, juce::AudioProcessor::doublePrecision })
+    {
+        const auto counts = precision == juce::AudioProcessor::doublePrecision
+                              ? countAudioThreadEvents<double> (blockSize, numBlocks)
+                              : countAudioThreadEvents<float>  (blockSize, numBlocks);
+
+        std::cout << "Audio thread over " << numBlocks << " blocks of 1.." << blockSize * 2
+                  << " (" << precisionName (precision) << "): " << counts.allocations << " allocations"
+                  << (AllocationTracer::tracesMalloc() ? "" : " (operator new only)") << ", " << counts.locks << " locks"
+                  << (AllocationTracer::tracesLocks() ? "" : " (not traced)") << "\n";
+
+        total += counts.allocations + counts.locks;
+    }
+
+    return total == 0 ? 0 : 2;
+}
+}
@@ -0,0 +1,577 @@
+#include "BenchCommon.h"
+#include "MixPipeline.h"
+#include "DistortionEngine.h"
+#include "FlangerEngine.h"
+#include "FdnReverb.h"
+#include "ConvolutionReverb.h"
+#include "LevelMeter.h"
+#include <thread>
+
+// Stage-level kernels measured in isolation, each against the code it replaced.
+
+namespace Bench
+{
+namespace
+{
+    // ===== Mix pipeline traffic =====
+    // Buffer bytes moved per block by the processor itself, all six stages on, as it
+    // counts them while it runs (BufferTraffic, read back from the DSP load snapshot): per
+    // stage, and for the chain's own passes around them. Next to the stage total, the
+    // mixing it replaced (copy to temp, process, applyGain + addFrom per stage). That code
+    // is no longer in the tree, so its column is an analytic model, not a measurement:
+    // sweeps counted by hand from what each of those calls touched.
+
+    // Old per-stage sweeps over every channel: temp.makeCopyOf (2), the stage in temp (2,
+    // 4 for the filters' two passes), applyGain (2) and addFrom (3) back into the buffer
+    int legacyStageSweeps (StageId stage) noexcept
+    {
+        return stage == StageId::Filter ? 11 : 9;
+    }
+
+    // On and mix parameters, in StageId order
+    constexpr std::pair<Param, Param> stageSwitches[] = { { Param::FILT_ON, Param::FILT_MIX }, { Param::DIST_ON, Param::DIST_MIX },
+                                                          { Param::CHO_ON,  Param::CHO_MIX },  { Param::FLA_ON,  Param::FLA_MIX },
+                                                          { Param::DLY_ON,  Param::DLY_MIX },  { Param::REV_ON,  Param::REV_MIX } };
+
+    void benchmarkMixTraffic (int blockSize, int iterations)
+    {
+        if (! DspLoadMeter::enabled)
+        {
+            std::cout << "Mix pipeline traffic: not counted in lean builds (ULTIMATEADLIBS_DSP_LOAD=0)\n";
+            return;
+        }
+
+        constexpr int numCh = 2;
+        constexpr double sampleRate = 48000.0;
+        const int numBlocks = juce::jlimit (50, 2000, iterations / 10);
+
+        std::cout << "Mix pipeline traffic, stereo, " << blockSize << " samples, all six stages on (bytes per block)\n"
+                  << "  mix  " << juce::String ("stage").paddedRight (' ', 9) << "   measured   old model\n";
+
+        for (float mix : { 0.3f, 1.0f })
+        {
+            UltimateAdlibsAudioProcessor processor;
+
+            for (const auto& [on, stageMix] : stageSwitches)
+            {
+                setParameter (processor, on, 1.0f);
+                setParameter (processor, stageMix, mix * 100.0f);
+            }
+
+            setParameter (processor, Param::GLOBAL_MIX, 100.0f);
+            processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+            processor.prepareToPlay (sampleRate, blockSize);
+
+            juce::AudioBuffer<float> buffer (numCh, blockSize);
+            juce::MidiBuffer midi;
+            juce::Random rng (1234);
+
+            auto runBlocks = [&] (int n)
+            {
+                for (int b = 0; b < n; ++b)
+                {
+                    fillWithNoise (buffer, rng);
+                    processor.processBlock (buffer, midi);
+                }
+            };
+
+            // The reset lands at the end of the next block, which is dropped with it
+            runBlocks (20);
+            processor.resetDspLoad();
+            runBlocks (1 + numBlocks);
+
+            const auto load = processor.getDspLoad();
+            auto perBlock = [&] (const StageLoad& l) { return load.bytesPerSample (l) * blockSize; };
+
+            double stagesMeasured = 0.0, stagesModel = 0.0;
+
+            for (int s = 0; s < numStages; ++s)
+            {
+                const auto measured = perBlock (load.stages[(size_t) s]);
+                const auto model = (double) legacyStageSweeps ((StageId) s) * numCh * blockSize * sizeof (float);
+                stagesMeasured += measured;
+                stagesModel += model;
+
+                std::cout << juce::String (mix, 2).paddedLeft (' ', 5) << "  " << juce::String (stageName ((StageId) s)).paddedRight (' ', 9)
+                          << juce::String (measured, 0).paddedLeft (' ', 11) << juce::String (model, 0).paddedLeft (' ', 12) << "\n";
+            }
+
+            std::cout << juce::String (mix, 2).paddedLeft (' ', 5) << "  " << juce::String ("stages").paddedRight (' ', 9)
+                      << juce::String (stagesMeasured, 0).paddedLeft (' ', 11) << juce::String (stagesModel, 0).paddedLeft (' ', 12) << "\n"
+                      << juce::String (mix, 2).paddedLeft (' ', 5) << "  " << juce::String ("block").paddedRight (' ', 9)
+                      << juce::String (perBlock (load.block), 0).paddedLeft (' ', 11) << "  (stages + chain passes)\n";
+
+            processor.releaseResources();
+        }
+    }
+
+    // ===== Filter kernel =====
+    // SIMD stereo SVF against its scalar reference and against the IIR biquad pair it
+    // replaced (ProcessorDuplicator, HPF and LPF as two passes).
+    void benchmarkFilterKernel (int blockSize, int iterations)
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int numCh = 2;
+        const juce::dsp::ProcessSpec spec { sampleRate, (juce::uint32) blockSize, (juce::uint32) numCh };
+
+        SvfFilterEngine<float> simd, scalar;
+        scalar.setScalarReference (true);
+
+        using IIRStereo = juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>, juce::dsp::IIR::Coefficients<float>>;
+        IIRStereo hpf, lpf;
+        hpf.state = juce::dsp::IIR::Coefficients<float>::makeHighPass (sampleRate, 120.0f);
+        lpf.state = juce::dsp::IIR::Coefficients<float>::makeLowPass  (sampleRate, 16000.0f);
+
+        for (auto* f : { &simd, &scalar })
+        {
+            f->prepare (spec);
+            f->setCutoffs (120.0f, 16000.0f);
+        }
+
+        hpf.prepare (spec);
+        lpf.prepare (spec);
+
+        juce::AudioBuffer<float> input (numCh, blockSize), a (numCh, blockSize), b (numCh, blockSize), c (numCh, blockSize);
+        juce::Random rng (99);
+
+        for (int ch = 0; ch < numCh; ++ch)
+            for (int i = 0; i < blockSize; ++i)
+                input.setSample (ch, i, rng.nextFloat() * 2.0f - 1.0f);
+
+        auto runSimd   = [&] { a.makeCopyOf (input, true); juce::dsp::AudioBlock<float> blk (a); simd.process (juce::dsp::ProcessContextReplacing<float> (blk)); };
+        auto runScalar = [&] { b.makeCopyOf (input, true); juce::dsp::AudioBlock<float> blk (b); scalar.process (juce::dsp::ProcessContextReplacing<float> (blk)); };
+        auto runIIR    = [&] { c.makeCopyOf (input, true); juce::dsp::AudioBlock<float> blk (c); juce::dsp::ProcessContextReplacing<float> ctx (blk); hpf.process (ctx); lpf.process (ctx); };
+
+        float maxDiffScalar = 0.0f, maxDiffIIR = 0.0f;
+
+        for (int block = 0; block < 200; ++block)
+        {
+            runSimd(); runScalar(); runIIR();
+
+            for (int ch = 0; ch < numCh; ++ch)
+                for (int i = 0; i < blockSize; ++i)
+                {
+                    maxDiffScalar = juce::jmax (maxDiffScalar, std::abs (a.getSample (ch, i) - b.getSample (ch, i)));
+                    maxDiffIIR    = juce::jmax (maxDiffIIR,    std::abs (a.getSample (ch, i) - c.getSample (ch, i)));
+                }
+        }
+
+        const auto copy = timePerCall (iterations, [&] { a.makeCopyOf (input, true); });
+
+        std::cout << "Filter stage (HPF 120 Hz -> LPF 16 kHz), stereo, " << blockSize << " samples\n"
+                  << "  SIMD SVF     " << formatPerSample (timePerCall (iterations, runSimd)   - copy, blockSize) << "\n"
+                  << "  scalar SVF   " << formatPerSample (timePerCall (iterations, runScalar) - copy, blockSize)
+                  << "  (max diff vs SIMD " << maxDiffScalar << ")\n"
+                  << "  IIR biquads  " << formatPerSample (timePerCall (iterations, runIIR)    - copy, blockSize)
+                  << "  (max diff vs SIMD " << maxDiffIIR << ")\n";
+    }
+
+    // ===== Flanger kernel =====
+    // FlangerEngine against the loop it replaced: per-sample std::sin + jmap and two
+    // juce::dsp::DelayLine objects with popSample/pushSample.
+    struct LegacyFlanger
+    {
+        juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::Linear> dl { 8192 }, dr { 8192 };
+        float phase = 0.0f;
+
+        void process (float* l, float* r, int n, float sr, float rate, float depth, float fb, float mix)
+        {
+            constexpr float twoPi = juce::MathConstants<float>::twoPi;
+            const float phaseInc = (twoPi * rate) / sr;
+
+            for (int i = 0; i < n; ++i)
+            {
+                const float lfo = 0.5f * (1.0f + std::sin (phase));
+                const float dSamp = (juce::jmap (lfo * depth, 0.2f, 8.0f) / 1000.0f) * sr;
+
+                const float a = dl.popSample (0, dSamp);
+                dl.pushSample (0, l[i] + a * fb);
+                l[i] += mix * a;
+
+                const float b = dr.popSample (0, dSamp);
+                dr.pushSample (0, r[i] + b * fb);
+                r[i] += mix * b;
+
+                phase += phaseInc;
+                if (phase >= twoPi) phase -= twoPi;
+            }
+        }
+    };
+
+    void benchmarkFlangerKernel (int blockSize, int iterations)
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr float rate = 0.35f, depth = 0.6f, fb = 0.2f, mix = 0.5f;
+        const juce::dsp::ProcessSpec monoSpec { sampleRate, (juce::uint32) blockSize, 1 };
+        const juce::dsp::ProcessSpec stereoSpec { sampleRate, (juce::uint32) blockSize, 2 };
+
+        LegacyFlanger legacy;
+        legacy.dl.prepare (monoSpec);
+        legacy.dr.prepare (monoSpec);
+
+        FlangerEngine<float> engine;
+        engine.prepare (stereoSpec);
+        engine.setRate (rate);
+        engine.setDepth (depth);
+        engine.setFeedback (fb);
+
+        juce::AudioBuffer<float> input (2, blockSize), a (2, blockSize), b (2, blockSize);
+        juce::Random rng (5);
+        fillWithNoise (input, rng);
+
+        auto runLegacy = [&] { a.makeCopyOf (input, true); legacy.process (a.getWritePointer (0), a.getWritePointer (1), blockSize, (float) sampleRate, rate, depth, fb, mix); };
+        auto runEngine = [&] { b.makeCopyOf (input, true); engine.process (b.getWritePointer (0), b.getWritePointer (1), blockSize, mix); };
+
+        // Both LFOs start at phase 0. The legacy float phase accumulator drifts, so a few
+        // 1e-2 of difference after one second is expected; the rotation tracks the exact LFO.
+        float maxDiff = 0.0f;
+
+        for (int block = 0; block < (int) sampleRate / blockSize; ++block)
+        {
+            runLegacy(); runEngine();
+
+            for (int ch = 0; ch < 2; ++ch)
+                for (int i = 0; i < blockSize; ++i)
+                    maxDiff = juce::jmax (maxDiff, std::abs (a.getSample (ch, i) - b.getSample (ch, i)));
+        }
+
+        const auto copy = timePerCall (iterations, [&] { a.makeCopyOf (input, true); });
+        const auto legacyTime = timePerCall (iterations, runLegacy) - copy;
+        const auto engineTime = timePerCall (iterations, runEngine) - copy;
+
+        std::cout << "Flanger stage, stereo, " << blockSize << " samples\n"
+                  << "  FlangerEngine  " << formatPerSample (engineTime, blockSize)
+                  << "  (" << juce::String (legacyTime.ns / juce::jmax (1.0, engineTime.ns), 1) << "x faster)\n"
+                  << "  DelayLine pair " << formatPerSample (legacyTime, blockSize)
+                  << "  (max diff vs engine " << maxDiff << ")\n";
+    }
+
+    // ===== Distortion kernel =====
+    // DistortionEngine at each quality against the WaveShaper it replaced (std::function
+    // around std::tanh, 1x). The budget is 4x oversampling for no more than the old 1x.
+    void benchmarkDistortionKernel (int blockSize, int iterations)
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr float drive = 2.0f, mix = 0.3f;
+        const juce::dsp::ProcessSpec spec { sampleRate, (juce::uint32) blockSize, 2 };
+
+        juce::dsp::WaveShaper<float> waveshaper;
+        waveshaper.functionToUse = [] (float x) { return std::tanh (x); };
+
+        DistortionEngine<float> engine;
+        engine.prepare (spec);
+        engine.setDrive (drive);
+
+        juce::AudioBuffer<float> input (2, blockSize), a (2, blockSize);
+        juce::Random rng (11);
+        fillWithNoise (input, rng);
+
+        auto runLegacy = [&]
+        {
+            a.makeCopyOf (input, true);
+
+            for (int ch = 0; ch < 2; ++ch)
+            {
+                auto* x = a.getWritePointer (ch);
+                for (int i = 0; i < blockSize; ++i)
+                    x[i] = MixPipeline::crossfade (x[i], waveshaper.processSample (x[i] * drive), mix);
+            }
+        };
+
+        const auto copy = timePerCall (iterations, [&] { a.makeCopyOf (input, true); });
+        const auto legacyTime = timePerCall (iterations, runLegacy) - copy;
+
+        std::cout << "Distortion stage, stereo, " << blockSize << " samples\n"
+                  << "  WaveShaper 1x   " << formatPerSample (legacyTime, blockSize) << "\n";
+
+        double ratio4x = 0.0;
+
+        for (int q = 0; q < DistortionEngine<float>::numQualities; ++q)
+        {
+            engine.setQuality (q);
+
+            const auto t = timePerCall (iterations, [&]
+            {
+                a.makeCopyOf (input, true);
+                juce::dsp::AudioBlock<float> block (a);
+                engine.process (block, mix);
+            }) - copy;
+
+            const double ratio = t.ns / juce::jmax (1.0, legacyTime.ns);
+
+            if (q == 2)
+                ratio4x = ratio;
+
+            std::cout << "  engine " << (1 << q) << "x       " << formatPerSample (t, blockSize)
+                      << "  (" << engine.getLatencySamples() << " samples latency, "
+                      << juce::String (ratio, 2) << "x the WaveShaper cost)\n";
+        }
+
+        std::cout << "  4x budget       " << juce::String (ratio4x, 2) << "x the old 1x path, target 1.00x: "
+                  << (ratio4x <= 1.0 ? "met" : "MISSED") << "\n";
+    }
+
+    // ===== Level meter =====
+    // LevelMeter (per-channel peak, RMS, true-peak and short-term loudness) against the
+    // scalar double-precision RMS loop it replaced (computeRmsStereo), which gave one mixed
+    // value per block. The budget caps what the extra readings may cost over that loop.
+    constexpr double meterBudget = 16.0;
+
+    float legacyRms (const juce::AudioBuffer<float>& b)
+    {
+        double sum = 0.0;
+
+        for (int ch = 0; ch < b.getNumChannels(); ++ch)
+        {
+            const auto* x = b.getReadPointer (ch);
+            for (int i = 0; i < b.getNumSamples(); ++i)
+                sum += (double) x[i] * (double) x[i];
+        }
+
+        return (float) std::sqrt (sum / (double) (b.getNumChannels() * b.getNumSamples()));
+    }
+
+    // Returns false when the meter is over budget
+    bool benchmarkMeterKernel (int blockSize, int iterations)
+    {
+        constexpr double sampleRate = 48000.0;
+
+        juce::AudioBuffer<float> input (2, blockSize);
+        juce::Random rng (17);
+        fillWithNoise (input, rng);
+
+        LevelMeter meter;
+        meter.prepare (sampleRate, 2);
+
+        float sink = 0.0f;
+        const auto legacyTime = timePerCall (iterations, [&] { sink += legacyRms (input); });
+        const auto meterTime  = timePerCall (iterations, [&] { meter.process (input, 2, blockSize); });
+        juce::ignoreUnused (sink);
+
+        const auto levels = meter.getSnapshot();
+        const auto ratio = meterTime.ns / juce::jmax (1.0, legacyTime.ns);
+
+        std::cout << "Level meter, stereo, " << blockSize << " samples\n"
+                  << "  scalar RMS      " << formatPerSample (legacyTime, blockSize) << "\n"
+                  << "  LevelMeter      " << formatPerSample (meterTime, blockSize)
+                  << "  (noise reads " << juce::String (levels.shortTermLufs, 1) << " LUFS, true peak "
+                  << juce::String (juce::Decibels::gainToDecibels (levels.loudestTruePeak()), 1) << " dBFS)\n"
+                  << "  meter budget    " << juce::String (ratio, 2) << "x the scalar RMS, at most "
+                  << juce::String (meterBudget, 2) << "x: " << (ratio <= meterBudget ? "met" : "MISSED") << "\n";
+
+        return ratio <= meterBudget;
+    }
+
+    // ===== Reverb kernel =====
+    // FdnReverb against juce::dsp::Reverb (Freeverb) with the processor's settings, wet
+    // only. Cost alone says little about a reverb, so both impulse responses are also
+    // scored with the normalised echo density of Abel & Huang: the share of samples in a
+    // 20 ms window lying beyond one standard deviation, over the 0.3173 a Gaussian gives.
+    // 1.0 means noise-like; a sparse early response scores well below it.
+    double echoDensity (const float* ir, int centre, int window)
+    {
+        double energy = 0.0;
+        for (int i = centre - window / 2; i < centre + window / 2; ++i)
+            energy += (double) ir[i] * ir[i];
+
+        const auto sd = std::sqrt (energy / window);
+        int outside = 0;
+
+        for (int i = centre - window / 2; i < centre + window / 2; ++i)
+            if (std::abs (ir[i]) > sd)
+                ++outside;
+
+        return (double) outside / window / 0.3173;
+    }
+
+    void benchmarkReverbKernel (int blockSize, int iterations)
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr float damping = 0.5f;
+        const juce::dsp::ProcessSpec spec { sampleRate, (juce::uint32) blockSize, 2 };
+        const int irLength = (int) sampleRate / 2;
+
+        juce::AudioBuffer<float> input (2, blockSize), a (2, blockSize);
+        juce::Random rng (17);
+        fillWithNoise (input, rng);
+
+        const auto copy = timePerCall (iterations, [&] { a.makeCopyOf (input, true); });
+
+        std::cout << "Reverb stage, stereo, " << blockSize << " samples (echo density at 100 / 300 ms)\n";
+
+        for (float size : { 0.35f, 0.7f, 1.0f })
+        {
+            juce::dsp::Reverb freeverb;
+            freeverb.prepare (spec);
+
+            juce::dsp::Reverb::Parameters params;
+            params.roomSize = size;
+            params.damping = damping;
+            params.width = 1.0f;
+            params.wetLevel = 1.0f;
+            params.dryLevel = 0.0f;
+            freeverb.setParameters (params);
+
+            FdnReverb<float> fdn;
+            fdn.prepare (spec);
+            fdn.setParameters (size, damping);
+
+            auto runFreeverb = [&] { a.makeCopyOf (input, true); juce::dsp::AudioBlock<float> block (a); freeverb.process (juce::dsp::ProcessContextReplacing<float> (block)); };
+            auto runFdn      = [&] { a.makeCopyOf (input, true); juce::dsp::AudioBlock<float> block (a); fdn.process (juce::dsp::ProcessContextReplacing<float> (block)); };
+
+            const auto freeverbTime = timePerCall (iterations, runFreeverb) - copy;
+            const auto fdnTime      = timePerCall (iterations, runFdn) - copy;
+
+            // Impulse responses, block by block from a clean state
+            auto impulseResponse = [&] (auto& reverb)
+            {
+                reverb.reset();
+                juce::AudioBuffer<float> ir (2, irLength);
+                ir.clear();
+                ir.setSample (0, 0, 1.0f);
+                ir.setSample (1, 0, 1.0f);
+
+                for (int start = 0; start < irLength; start += blockSize)
+                {
+                    auto block = juce::dsp::AudioBlock<float> (ir).getSubBlock ((size_t) start, (size_t) juce::jmin (blockSize, irLength - start));
+                    reverb.process (juce::dsp::ProcessContextReplacing<float> (block));
+                }
+
+                return ir;
+            };
+
+            const auto freeverbIR = impulseResponse (freeverb);
+            const auto fdnIR      = impulseResponse (fdn);
+            const int window = (int) (0.02 * sampleRate);
+
+            auto densities = [&] (const juce::AudioBuffer<float>& ir)
+            {
+                return juce::String (echoDensity (ir.getReadPointer (0), (int) (0.1 * sampleRate), window), 2) + " / "
+                     + juce::String (echoDensity (ir.getReadPointer (0), (int) (0.3 * sampleRate), window), 2);
+            };
+
+            std::cout << "  size " << juce::String (size, 2) << "\n"
+                      << "    FdnReverb  " << formatPerSample (fdnTime, blockSize) << "  density " << densities (fdnIR)
+                      << "  (" << juce::String (freeverbTime.cycles / juce::jmax (1.0, fdnTime.cycles), 2) << "x faster)\n"
+                      << "    Freeverb   " << formatPerSample (freeverbTime, blockSize) << "  density " << densities (freeverbIR) << "\n";
+        }
+    }
+
+    // ===== Convolution kernel =====
+    // ConvolutionReverb against juce::dsp::Convolution (non-uniform, 64-sample head), both
+    // fed a 4 s stereo IR at 64-sample blocks. Blocks are paced at the real-time rate so
+    // the tail worker runs as it would in a host; only the audio-thread call is timed.
+    // The budget is the block period: the worst block has to stay well inside it.
+    struct PacedRun
+    {
+        Timing mean;
+        double worstMicros = 0.0;
+    };
+
+    template <typename Processor>
+    PacedRun runPaced (Processor& processor, juce::AudioBuffer<float>& buffer, double sampleRate, double seconds)
+    {
+        const auto blockSize = buffer.getNumSamples();
+        const auto numBlocks = (int) (seconds * sampleRate / blockSize);
+        const auto period = std::chrono::duration<double> (blockSize / sampleRate);
+        const auto tps = CycleCounter::ticksPerSecond();
+
+        juce::Random rng (23);
+        PacedRun run;
+        double ticks = 0.0;
+        auto deadline = Clock::now();
+
+        for (int b = 0; b < numBlocks; ++b)
+        {
+            fillWithNoise (buffer, rng);
+            juce::dsp::AudioBlock<float> block (buffer);
+
+            const auto start = CycleCounter::now();
+            const auto t0 = Clock::now();
+            processor.process (juce::dsp::ProcessContextReplacing<float> (block));
+            const auto t1 = Clock::now();
+            const auto end = CycleCounter::now();
+
+            ticks += (double) (end - start);
+            run.worstMicros = juce::jmax (run.worstMicros, std::chrono::duration<double, std::micro> (t1 - t0).count());
+
+            deadline += std::chrono::duration_cast<Clock::duration> (period);
+            std::this_thread::sleep_until (deadline);
+        }
+
+        const auto samples = (double) numBlocks * blockSize;
+        run.mean = { ticks / tps * 1.0e9 / samples, ticks / samples };
+        return run;
+    }
+
+    void benchmarkConvolutionKernel()
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 64;
+        constexpr double irSeconds = 4.0, runSeconds = 3.0;
+        const juce::dsp::ProcessSpec spec { sampleRate, (juce::uint32) blockSize, 2 };
+
+        auto ir = ConvolutionReverb::makeRoomImpulse (0.85f, 0.5f, sampleRate);
+        ir.setSize (2, (int) (irSeconds * sampleRate), true);
+
+        juce::AudioBuffer<float> buffer (2, blockSize);
+        const auto budgetMicros = 1.0e6 * blockSize / sampleRate;
+
+        // Both engines install IRs from a background thread: wait until they have one
+        auto waitForIr = [&] (auto& processor, auto&& loaded)
+        {
+            for (int i = 0; i < 500 && ! loaded(); ++i)
+            {
+                juce::dsp::AudioBlock<float> block (buffer);
+                processor.process (juce::dsp::ProcessContextReplacing<float> (block));
+                juce::Thread::sleep (10);
+            }
+        };
+
+        ConvolutionReverb engine;
+        engine.prepare (spec, true);
+        engine.loadImpulseResponse (juce::AudioBuffer<float> (ir), sampleRate, "bench");
+        waitForIr (engine, [&] { return engine.getCurrentIrLength() == ir.getNumSamples(); });
+        const auto lateBefore = engine.getLateBlocks();
+        const auto engineRun = runPaced (engine, buffer, sampleRate, runSeconds);
+
+        juce::dsp::Convolution reference { juce::dsp::Convolution::NonUniform { blockSize } };
+        reference.prepare (spec);
+        reference.loadImpulseResponse (juce::AudioBuffer<float> (ir), sampleRate, juce::dsp::Convolution::Stereo::yes,
+                                       juce::dsp::Convolution::Trim::no, juce::dsp::Convolution::Normalise::yes);
+        waitForIr (reference, [&] { return reference.getCurrentIRSize() > 0; });
+        const auto referenceRun = runPaced (reference, buffer, sampleRate, runSeconds);
+
+        auto report = [&] (const char* name, const PacedRun& run)
+        {
+            std::cout << name << formatPerSample (run.mean, 1) << ", worst block " << juce::String (run.worstMicros, 1)
+                      << " us (" << juce::String (100.0 * run.worstMicros / budgetMicros, 1) << "% of budget)";
+        };
+
+        std::cout << "Convolution stage, stereo, " << irSeconds << " s IR, " << blockSize << "-sample blocks, audio thread only\n";
+        report ("  ConvolutionReverb      ", engineRun);
+        std::cout << ", " << (engine.getLateBlocks() - lateBefore) << " late tail blocks\n";
+        report ("  juce::dsp::Convolution ", referenceRun);
+        std::cout << "\n";
+    }
+}
+
+int runKernelBenchmarks (int blockSize, int iterations)
+{
+    benchmarkMixTraffic (blockSize, iterations);
+    std::cout << "\n";
+    benchmarkFilterKernel (blockSize, iterations);
+    std::cout << "\n";
+    benchmarkDistortionKernel (blockSize, iterations);
+    std::cout << "\n";
+    benchmarkFlangerKernel (blockSize, iterations);
+    std::cout << "\n";
+    benchmarkReverbKernel (blockSize, iterations);
+    std::cout << "\n";
+    const bool meterWithinBudget = benchmarkMeterKernel (blockSize, iterations);
+    std::cout << "\n";
+    benchmarkConvolutionKernel();
+
+    return meterWithinBudget ? 0 : 4;
+}
+}
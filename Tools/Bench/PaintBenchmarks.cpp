@@ -0,0 +1,43 @@
+#include "BenchCommon.h"
+#include "PluginEditor.h"
+
+// Editor repaint cost: the whole editor painted into an image, as a host repaint of a
+// fully invalidated window would, with the cached background and knob filmstrips against
+// drawing everything from scratch.
+
+namespace Bench
+{
+int runPaintBenchmark (int iterations)
+{
+    UltimateAdlibsAudioProcessor processor;
+    UltimateAdlibsAudioProcessorEditor editor (processor);
+
+    std::cout << "Editor repaint, " << editor.getWidth() << "x" << editor.getHeight() << ", "
+              << iterations << " full repaints\n";
+
+    for (const float scale : { 1.0f, 2.0f })
+    {
+        juce::Image target (juce::Image::ARGB, juce::roundToInt ((float) editor.getWidth() * scale),
+                            juce::roundToInt ((float) editor.getHeight() * scale), true);
+
+        auto paintOnce = [&]
+        {
+            juce::Graphics g (target);
+            g.addTransform (juce::AffineTransform::scale (scale));
+            editor.paintEntireComponent (g, true);
+        };
+
+        editor.setRenderCaching (false);
+        const auto plain = timePerCall (iterations, paintOnce);
+
+        editor.setRenderCaching (true);
+        const auto cached = timePerCall (iterations, paintOnce); // the warm-up call fills the caches
+
+        std::cout << "  " << juce::String (scale, 0) << "x  from scratch " << juce::String (plain.ns * 1.0e-6, 3)
+                  << " ms, cached " << juce::String (cached.ns * 1.0e-6, 3) << " ms ("
+                  << juce::String (plain.ns / juce::jmax (1.0, cached.ns), 2) << "x faster)\n";
+    }
+
+    return 0;
+}
+}
@@ -0,0 +1,116 @@
+#include "BenchCommon.h"
+
+// Plugin state save and restore for a session of instances, as a host saving the project
+// or taking an undo snapshot would: the binary state against the XML one it replaced
+// (apvts.copyState() -> createXml() -> copyXmlToBinary), per instance. Every instance
+// gets its own random settings; a binary state that doesn't save back identical after a
+// restore fails the run.
+
+namespace Bench
+{
+namespace
+{
+    void writeLegacyState (UltimateAdlibsAudioProcessor& processor, juce::MemoryBlock& dest)
+    {
+        auto state = processor.apvts.copyState();
+        std::unique_ptr<juce::XmlElement> xml (state.createXml());
+        juce::AudioProcessor::copyXmlToBinary (*xml, dest);
+    }
+
+    double averageSize (const std::vector<juce::MemoryBlock>& blobs)
+    {
+        double total = 0.0;
+        for (const auto& blob : blobs)
+            total += (double) blob.getSize();
+
+        return total / (double) blobs.size();
+    }
+}
+
+int runStateBenchmark (int numInstances, int iterations)
+{
+    std::vector<std::unique_ptr<UltimateAdlibsAudioProcessor>> session;
+    juce::Random rng (7);
+
+    for (int n = 0; n < numInstances; ++n)
+    {
+        session.push_back (std::make_unique<UltimateAdlibsAudioProcessor>());
+
+        for (int i = 0; i < numParameters; ++i)
+            session.back()->apvts.getParameter (paramId ((Param) i))->setValueNotifyingHost (rng.nextFloat());
+
+        auto order = UltimateAdlibsAudioProcessor::defaultChainOrder;
+        std::swap (order[(size_t) rng.nextInt (numStages)], order[(size_t) rng.nextInt (numStages)]);
+        session.back()->setChainOrder (order);
+    }
+
+    std::vector<juce::MemoryBlock> binary ((size_t) numInstances), legacy ((size_t) numInstances);
+
+    auto forEachInstance = [&] (auto&& fn)
+    {
+        return [&session, fn]
+        {
+            for (size_t i = 0; i < session.size(); ++i)
+                fn (*session[i], i);
+        };
+    };
+
+    const auto saveBinary = timePerCall (iterations, forEachInstance ([&] (auto& p, size_t i) { p.getStateInformation (binary[i]); }));
+    const auto saveLegacy = timePerCall (iterations, forEachInstance ([&] (auto& p, size_t i) { writeLegacyState (p, legacy[i]); }));
+
+    // Each pass restores every instance from another one's state, so that values move as
+    // they would loading a project (an unchanged value costs nothing to restore)
+    size_t shift = 0;
+
+    auto restoreFrom = [&session, &shift] (const std::vector<juce::MemoryBlock>& blobs)
+    {
+        return [&session, &shift, &blobs]
+        {
+            ++shift;
+
+            for (size_t i = 0; i < session.size(); ++i)
+            {
+                const auto& blob = blobs[(i + shift) % blobs.size()];
+                session[i]->setStateInformation (blob.getData(), (int) blob.getSize());
+            }
+        };
+    };
+
+    const auto restoreBinary = timePerCall (iterations, restoreFrom (binary));
+    const auto restoreLegacy = timePerCall (iterations, restoreFrom (legacy));
+
+    // Restored, a binary state must save back as it was written
+    int mismatches = 0;
+
+    for (size_t i = 0; i < session.size(); ++i)
+    {
+        juce::MemoryBlock again;
+        session[i]->setStateInformation (binary[i].getData(), (int) binary[i].getSize());
+        session[i]->getStateInformation (again);
+        mismatches += again == binary[i] ? 0 : 1;
+    }
+
+    auto row = [numInstances] (const char* name, const Timing& binaryTime, const Timing& legacyTime)
+    {
+        const auto b = binaryTime / (double) numInstances;
+        const auto l = legacyTime / (double) numInstances;
+
+        std::cout << "  " << juce::String (name).paddedRight (' ', 8)
+                  << juce::String (b.ns * 1.0e-3, 2).paddedLeft (' ', 9) << " us"
+                  << juce::String (l.ns * 1.0e-3, 2).paddedLeft (' ', 10) << " us"
+                  << juce::String (l.ns / juce::jmax (1.0, b.ns), 1).paddedLeft (' ', 8) << "x\n";
+    };
+
+    std::cout << numInstances << " instances, " << iterations << " passes, per instance\n"
+              << "            binary       XML  speed-up\n";
+    row ("save", saveBinary, saveLegacy);
+    row ("restore", restoreBinary, restoreLegacy);
+    std::cout << "  size    " << juce::String (averageSize (binary), 0).paddedLeft (' ', 9) << "  B"
+              << juce::String (averageSize (legacy), 0).paddedLeft (' ', 10) << "  B\n";
+
+    if (mismatches > 0)
+        std::cout << "  " << mismatches << " instance(s) did not round-trip\n";
+
+    return mismatches == 0 ? 0 : 1;
+}
+}
@@ -0,0 +1,151 @@
+#include "AllocationTracer.h"
+#include <cstdlib>
+#include <new>
+
+#if defined (__linux__) && defined (__GLIBC__)
+ #define ULTIMATEADLIBS_TRACE_MALLOC 1
+ #define ULTIMATEADLIBS_TRACE_LOCKS 1
+ #include <dlfcn.h>
+ #include <pthread.h>
+#else
+ #define ULTIMATEADLIBS_TRACE_MALLOC 0
+ #define ULTIMATEADLIBS_TRACE_LOCKS 0
+#endif
+
+namespace
+{
+    // Constant-initialised so reading it can never allocate, even from inside malloc
+    thread_local int audioScopeDepth = 0;
+    std::atomic<int> numAllocations { 0 };
+    std::atomic<int> numLocks { 0 };
+
+    inline void noteAllocation() noexcept
+    {
+        if (audioScopeDepth > 0)
+            numAllocations.fetch_add (1, std::memory_order_relaxed);
+    }
+
+    inline void noteLock() noexcept
+    {
+        if (audioScopeDepth > 0)
+            numLocks.fetch_add (1, std::memory_order_relaxed);
+    }
+}
+
+namespace AllocationTracer
+{
+    ScopedAudioThread::ScopedAudioThread() noexcept  { ++audioScopeDepth; }
+    ScopedAudioThread::~ScopedAudioThread() noexcept { --audioScopeDepth; }
+
+    int getNumAllocations() noexcept { return numAllocations.load(); }
+    int getNumLocks() noexcept       { return numLocks.load(); }
+    void resetCounters() noexcept    { numAllocations.store (0); numLocks.store (0); }
+    bool tracesMalloc() noexcept     { return ULTIMATEADLIBS_TRACE_MALLOC != 0; }
+    bool tracesLocks() noexcept      { return ULTIMATEADLIBS_TRACE_LOCKS != 0; }
+}
+
+// ===== malloc family (glibc) =====
+#if ULTIMATEADLIBS_TRACE_MALLOC
+extern "C"
+{
+    void* __libc_malloc (size_t);
+    void* __libc_calloc (size_t, size_t);
+    void* __libc_realloc (void*, size_t);
+    void* __libc_memalign (size_t, size_t);
+    void  __libc_free (void*);
+
+    void* malloc (size_t size)              { noteAllocation(); return __libc_malloc (size); }
+    void* calloc (size_t n, size_t size)    { noteAllocation(); return __libc_calloc (n, size); }
+    void* realloc (void* p, size_t size)    { noteAllocation(); return __libc_realloc (p, size); }
+    void* memalign (size_t align, size_t n) { noteAllocation(); return __libc_memalign (align, n); }
+    void* aligned_alloc (size_t align, size_t n) { noteAllocation(); return __libc_memalign (align, n); }
+    void  free (void* p)                    { __libc_free (p); }
+
+    int posix_memalign (void** out, size_t align, size_t n)
+    {
+        noteAllocation();
+        *out = __libc_memalign (align, n);
+        return *out != nullptr ? 0 : 12; // ENOMEM
+    }
+}
+#endif
+
+// ===== Blocking locks (glibc) =====
+// Each hook counts, then forwards to the next definition (libc's), looked up on first
+// use. Condition waits aren't hooked: they need their mutex locked first.
+#if ULTIMATEADLIBS_TRACE_LOCKS
+namespace
+{
+    template <typename Fn>
+    Fn nextDefinition (std::atomic<Fn>& cached, const char* name) noexcept
+    {
+        auto fn = cached.load (std::memory_order_acquire);
+
+        if (fn == nullptr)
+        {
+            fn = reinterpret_cast<Fn> (dlsym (RTLD_NEXT, name));
+            cached.store (fn, std::memory_order_release);
+        }
+
+        return fn;
+    }
+}
+
+extern "C"
+{
+    int pthread_mutex_lock (pthread_mutex_t* m) noexcept
+    {
+        static std::atomic<int (*) (pthread_mutex_t*)> next { nullptr };
+        noteLock();
+        return nextDefinition (next, "pthread_mutex_lock") (m);
+    }
+
+    int pthread_mutex_timedlock (pthread_mutex_t* m, const timespec* timeout) noexcept
+    {
+        static std::atomic<int (*) (pthread_mutex_t*, const timespec*)> next { nullptr };
+        noteLock();
+        return nextDefinition (next, "pthread_mutex_timedlock") (m, timeout);
+    }
+
+    int pthread_rwlock_rdlock (pthread_rwlock_t* l) noexcept
+    {
+        static std::atomic<int (*) (pthread_rwlock_t*)> next { nullptr };
+        noteLock();
+        return nextDefinition (next, "pthread_rwlock_rdlock") (l);
+    }
+
+    int pthread_rwlock_wrlock (pthread_rwlock_t* l) noexcept
+    {
+        static std::atomic<int (*) (pthread_rwlock_t*)> next { nullptr };
+        noteLock();
+        return nextDefinition (next, "pthread_rwlock_wrlock") (l);
+    }
+}
+#endif
+
+// ===== operator new family =====
+// With malloc hooked, new is counted there; the replacements below only count on
+// platforms where malloc is not interposed.
+namespace
+{
+    void* allocate (std::size_t size)
+    {
+       #if ! ULTIMATEADLIBS_TRACE_MALLOC
+        noteAllocation();
+       #endif
+
+        if (void* p = std::malloc (size != 0 ? size : 1))
+            return p;
+
+        throw std::bad_alloc();
+    }
+}
+
+void* operator new (std::size_t size)                                   { return allocate (size); }
+void* operator new[] (std::size_t size)                                 { return allocate (size); }
+void* operator new (std::size_t size, const std::nothrow_t&) noexcept   { try { return allocate (size); } catch (...) { return nullptr; } }
+void* operator new[] (std::size_t size, const std::nothrow_t&) noexcept { try { return allocate (size); } catch (...) { return nullptr; } }
+void operator delete (void* p) noexcept                                 { std::free (p); }
+void operator delete[] (void* p) noexcept                               { std::free (p); }
+void operator delete (void* p, std::size_t) noexcept                    { std::free (p); }
+void operator delete[] (void* p, std::size_t) noexcept                  { std::free (p); }
@@ -0,0 +1,31 @@
+#pragma once
+#include <atomic>
+
+// ===== Audio-thread allocation tracer (tools only) =====
+// Counts heap allocations, and blocking lock acquisitions, made by any thread while it
+// is inside a ScopedAudioThread. AllocationTracer.cpp replaces the global operator new
+// family and, on glibc, malloc itself, so juce::HeapBlock and friends are caught too;
+// on glibc it also interposes the pthread mutex and rwlock calls that std::mutex,
+// juce::CriticalSection and juce::ReadWriteLock end up in. Try-locks never block and
+// are not counted. Link it into a tool, never into the plugin.
+namespace AllocationTracer
+{
+    struct ScopedAudioThread
+    {
+        ScopedAudioThread() noexcept;
+        ~ScopedAudioThread() noexcept;
+
+        ScopedAudioThread (const ScopedAudioThread&) = delete;
+        ScopedAudioThread& operator= (const ScopedAudioThread&) = delete;
+    };
+
+    int getNumAllocations() noexcept;
+    int getNumLocks() noexcept;
+    void resetCounters() noexcept;
+
+    // False where only operator new is hooked (malloc calls go unseen).
+    bool tracesMalloc() noexcept;
+
+    // False where locks aren't hooked at all (getNumLocks() stays 0).
+    bool tracesLocks() noexcept;
+}
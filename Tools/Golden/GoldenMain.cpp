@@ -0,0 +1,713 @@
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+// Golden-render regression suite: fixed input signals rendered offline through each stage
+// on its own and through every factory preset, at several sample rates, and compared with
+// stored reference renders ("goldens").
+//
+//   UltimateAdlibsGolden --record --dir=<dir> [--filter=<text>]
+//   UltimateAdlibsGolden --verify --dir=<dir> [--filter=<text>] [--json=<file>]
+//   UltimateAdlibsGolden --reference [--filter=<text>]
+//
+// --record renders every case at the reference block size and writes it as a 32-bit float
+// WAV, <dir>/<case>/<signal>_<rate>.wav. --verify renders each case again at every block
+// size and null-tests it against its golden: the peak of the difference (dBFS) must stay
+// under the case's tolerance, and the residual level relative to the golden is reported
+// alongside. The odd block sizes check at the same time that the chain doesn't depend on
+// how the host splits the audio. --reference needs no goldens: it checks each optimized
+// kernel against a plain scalar implementation of the same arithmetic, and the float
+// chain against the double one.
+//
+// Goldens are only meaningful on the machine and build that recorded them (a compiler or
+// CPU change moves the last bits), so CI records them from the base revision of a change
+// and verifies the change against them. Exit code 1 when a case fails or has no golden.
+
+namespace
+{
+    // ===== Input signals =====
+    constexpr double signalSeconds = 0.5;
+    constexpr double maxTailSeconds = 1.0;
+    constexpr int recordBlockSize = 512;
+
+    const std::vector<double> sampleRates { 44100.0, 48000.0, 96000.0 };
+    const std::vector<int> blockSizes { 32, 441, recordBlockSize, 1000 };
+
+    enum class Signal { impulse, sweep, noise, burst, silence };
+
+    const std::vector<Signal> allSignals { Signal::impulse, Signal::sweep, Signal::noise, Signal::burst, Signal::silence };
+
+    const char* signalName (Signal s)
+    {
+        switch (s)
+        {
+            case Signal::impulse: return "impulse";
+            case Signal::sweep:   return "sweep";
+            case Signal::noise:   return "noise";
+            case Signal::burst:   return "burst";
+            case Signal::silence: return "silence";
+        }
+
+        return "";
+    }
+
+    // Stereo. The impulse and the sweep are the same on both channels (and so run the
+    // dual-mono path); the noise is different on each. The burst is 100 ms of noise
+    // followed by silence, for the tails and the stage sleeping. Seeds are fixed.
+    juce::AudioBuffer<float> makeSignal (Signal s, double sampleRate, int length)
+    {
+        juce::AudioBuffer<float> buffer (2, length);
+        buffer.clear();
+
+        switch (s)
+        {
+            case Signal::impulse:
+                for (int ch = 0; ch < 2; ++ch)
+                    buffer.setSample (ch, 0, 1.0f);
+                break;
+
+            case Signal::sweep:
+            {
+                // Exponential sine sweep, 20 Hz up to 20 kHz (or just under Nyquist), -6 dBFS
+                const double f0 = 20.0, f1 = juce::jmin (20000.0, 0.45 * sampleRate);
+                const double seconds = length / sampleRate;
+                const double k = std::log (f1 / f0);
+
+                for (int i = 0; i < length; ++i)
+                {
+                    const double t = i / sampleRate;
+                    const double phase = juce::MathConstants<double>::twoPi * f0 * seconds / k * (std::exp (t * k / seconds) - 1.0);
+                    const auto v = (float) (0.5 * std::sin (phase));
+
+                    for (int ch = 0; ch < 2; ++ch)
+                        buffer.setSample (ch, i, v);
+                }
+                break;
+            }
+
+            case Signal::noise:
+            case Signal::burst:
+            {
+                const int n = s == Signal::noise ? length : juce::jmin (length, (int) (0.1 * sampleRate));
+
+                for (int ch = 0; ch < 2; ++ch)
+                {
+                    juce::Random rng (1234 + ch);
+
+                    for (int i = 0; i < n; ++i)
+                        buffer.setSample (ch, i, 0.25f * (rng.nextFloat() * 2.0f - 1.0f));
+                }
+                break;
+            }
+
+            case Signal::silence:
+                break;
+        }
+
+        return buffer;
+    }
+
+    // ===== Cases =====
+    // Each stage alone, fully wet, then each factory preset as it ships. Tolerances are
+    // peak differences in dBFS; the recursive stages (reverbs) and the chain as a whole
+    // get more room than the straight-line ones.
+    struct Case
+    {
+        juce::String name;
+        std::function<void (UltimateAdlibsAudioProcessor&)> setup;
+        double toleranceDb;
+    };
+
+    void setParameter (UltimateAdlibsAudioProcessor& processor, Param id, float value)
+    {
+        auto* param = processor.apvts.getParameter (paramId (id));
+        param->setValueNotifyingHost (param->convertTo0to1 (value));
+    }
+
+    Case soloCase (const char* name, Param on, Param mix, double toleranceDb, std::function<void (UltimateAdlibsAudioProcessor&)> extra = {})
+    {
+        return { name, [on, mix, extra] (UltimateAdlibsAudioProcessor& p)
+                 {
+                     for (auto stage : { Param::FILT_ON, Param::DIST_ON, Param::CHO_ON, Param::FLA_ON, Param::DLY_ON, Param::REV_ON })
+                         setParameter (p, stage, stage == on ? 1.0f : 0.0f);
+
+                     setParameter (p, mix, 100.0f);
+
+                     if (extra)
+                         extra (p);
+                 },
+                 toleranceDb };
+    }
+
+    std::vector<Case> makeCases()
+    {
+        std::vector<Case> cases;
+
+        cases.push_back ({ "bypass", [] (UltimateAdlibsAudioProcessor& p)
+                           {
+                               for (auto stage : { Param::FILT_ON, Param::DIST_ON, Param::CHO_ON, Param::FLA_ON, Param::DLY_ON, Param::REV_ON })
+                                   setParameter (p, stage, 0.0f);
+                           },
+                           -140.0 });
+
+        cases.push_back (soloCase ("filter",  Param::FILT_ON, Param::FILT_MIX, -110.0));
+        cases.push_back (soloCase ("dist",    Param::DIST_ON, Param::DIST_MIX, -100.0));
+        cases.push_back (soloCase ("dist-4x", Param::DIST_ON, Param::DIST_MIX, -100.0,
+                                   [] (auto& p) { setParameter (p, Param::DIST_QUALITY, 2.0f); }));
+        cases.push_back (soloCase ("chorus",  Param::CHO_ON,  Param::CHO_MIX,  -100.0));
+        cases.push_back (soloCase ("flanger", Param::FLA_ON,  Param::FLA_MIX,  -100.0));
+        cases.push_back (soloCase ("delay",   Param::DLY_ON,  Param::DLY_MIX,  -110.0));
+        cases.push_back (soloCase ("reverb-classic", Param::REV_ON, Param::REV_MIX, -100.0,
+                                   [] (auto& p) { setParameter (p, Param::REV_ALGO, 0.0f); }));
+        cases.push_back (soloCase ("reverb-fdn", Param::REV_ON, Param::REV_MIX, -90.0,
+                                   [] (auto& p) { setParameter (p, Param::REV_ALGO, 1.0f); }));
+        cases.push_back (soloCase ("reverb-conv", Param::REV_ON, Param::REV_MIX, -90.0,
+                                   [] (auto& p) { setParameter (p, Param::REV_ALGO, 2.0f); }));
+
+        // Factory presets come first in the bank; the user's own are left out
+        UltimateAdlibsAudioProcessor processor;
+        auto& bank = processor.getPresetBank();
+
+        for (int i = 0; bank.get (i) != nullptr && bank.get (i)->factory; ++i)
+        {
+            cases.push_back ({ "preset-" + bank.get (i)->name.toLowerCase().replaceCharacter (' ', '-'),
+                               [i] (UltimateAdlibsAudioProcessor& p) { p.setCurrentProgram (i); },
+                               -80.0 });
+        }
+
+        return cases;
+    }
+
+    // ===== Rendering =====
+    // A fresh processor per render, offline, so that nothing carries over between cases
+    // and the convolution IR is always built before the first block. The output is not
+    // trimmed by the latency: a latency change is a regression too. The tail is capped so
+    // that long reverbs don't dominate the run time.
+    template <typename SampleType>
+    juce::AudioBuffer<float> render (const Case& c, Signal signal, double sampleRate, int blockSize)
+    {
+        UltimateAdlibsAudioProcessor processor;
+        processor.setPresetMorphMs (0.0f);
+        c.setup (processor);
+
+        processor.setNonRealtime (true);
+        processor.setProcessingPrecision (std::is_same_v<SampleType, double> ? juce::AudioProcessor::doublePrecision
+                                                                              : juce::AudioProcessor::singlePrecision);
+        processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+        processor.prepareToPlay (sampleRate, blockSize);
+
+        const int inputLength = (int) (signalSeconds * sampleRate);
+        const int tailLength  = (int) std::ceil (juce::jmin (maxTailSeconds, processor.getTailLengthSeconds()) * sampleRate);
+        const int length      = inputLength + tailLength + processor.getLatencySamples();
+
+        const auto input = makeSignal (signal, sampleRate, inputLength);
+        juce::AudioBuffer<float> output (2, length);
+        juce::AudioBuffer<SampleType> block (2, blockSize);
+        juce::MidiBuffer midi;
+
+        for (int pos = 0; pos < length; pos += blockSize)
+        {
+            const int n = juce::jmin (blockSize, length - pos);
+            juce::AudioBuffer<SampleType> view (block.getArrayOfWritePointers(), 2, n);
+
+            for (int ch = 0; ch < 2; ++ch)
+                for (int i = 0; i < n; ++i)
+                    view.setSample (ch, i, pos + i < inputLength ? (SampleType) input.getSample (ch, pos + i) : (SampleType) 0);
+
+            processor.processBlock (view, midi);
+
+            for (int ch = 0; ch < 2; ++ch)
+                for (int i = 0; i < n; ++i)
+                    output.setSample (ch, pos + i, (float) view.getSample (ch, i));
+        }
+
+        processor.releaseResources();
+        return output;
+    }
+
+    // ===== Null test =====
+    struct NullTest
+    {
+        bool lengthMatches = true;
+        double peakDb = -999.0;     // peak of the difference, dBFS
+        double residualDb = -999.0; // RMS of the difference relative to the golden's RMS
+        int firstDifference = -1;   // sample index, -1 when bit-identical
+
+        bool passes (double toleranceDb) const noexcept { return lengthMatches && peakDb <= toleranceDb; }
+    };
+
+    NullTest nullTest (const juce::AudioBuffer<float>& result, const juce::AudioBuffer<float>& golden)
+    {
+        NullTest t;
+
+        if (result.getNumChannels() != golden.getNumChannels() || result.getNumSamples() != golden.getNumSamples())
+        {
+            t.lengthMatches = false;
+            return t;
+        }
+
+        double peak = 0.0, diffEnergy = 0.0, goldenEnergy = 0.0;
+
+        for (int ch = 0; ch < golden.getNumChannels(); ++ch)
+        {
+            const auto* a = result.getReadPointer (ch);
+            const auto* b = golden.getReadPointer (ch);
+
+            for (int i = 0; i < golden.getNumSamples(); ++i)
+            {
+                const double d = (double) a[i] - (double) b[i];
+
+                if (d != 0.0 && (t.firstDifference < 0 || i < t.firstDifference))
+                    t.firstDifference = i;
+
+                peak = juce::jmax (peak, std::abs (d));
+                diffEnergy += d * d;
+                goldenEnergy += (double) b[i] * (double) b[i];
+            }
+        }
+
+        t.peakDb = juce::Decibels::gainToDecibels (peak, -999.0);
+
+        if (diffEnergy > 0.0)
+            t.residualDb = goldenEnergy > 0.0 ? 10.0 * std::log10 (diffEnergy / goldenEnergy) : 0.0;
+
+        return t;
+    }
+
+    juce::String formatDb (double db)
+    {
+        return db <= -999.0 ? juce::String ("-inf") : juce::String (db, 1);
+    }
+
+    // ===== Golden files =====
+    juce::File goldenFile (const juce::File& dir, const Case& c, Signal s, double sampleRate)
+    {
+        return dir.getChildFile (c.name).getChildFile (juce::String (signalName (s)) + "_" + juce::String ((int) sampleRate) + ".wav");
+    }
+
+    bool writeGolden (const juce::File& file, const juce::AudioBuffer<float>& audio, double sampleRate)
+    {
+        if (! file.getParentDirectory().createDirectory())
+            return false;
+
+        file.deleteFile();
+        std::unique_ptr<juce::OutputStream> stream (file.createOutputStream());
+
+        if (stream == nullptr)
+            return false;
+
+        // 32 bits: JUCE writes IEEE float, so the golden holds the render exactly
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer (wav.createWriterFor (stream.get(), sampleRate,
+                                                                            (unsigned int) audio.getNumChannels(), 32, {}, 0));
+        if (writer == nullptr)
+            return false;
+
+        stream.release(); // owned by the writer now
+        return writer->writeFromAudioSampleBuffer (audio, 0, audio.getNumSamples());
+    }
+
+    bool readGolden (juce::AudioFormatManager& formats, const juce::File& file, double sampleRate, juce::AudioBuffer<float>& dest)
+    {
+        std::unique_ptr<juce::AudioFormatReader> reader (formats.createReaderFor (file));
+
+        if (reader == nullptr || reader->sampleRate != sampleRate)
+            return false;
+
+        dest.setSize ((int) reader->numChannels, (int) reader->lengthInSamples);
+        return reader->read (&dest, 0, dest.getNumSamples(), 0, true, true);
+    }
+
+    bool matchesFilter (const juce::String& name, const juce::String& filter)
+    {
+        return filter.isEmpty() || name.contains (filter);
+    }
+
+    // ===== Modes =====
+    int record (const juce::File& dir, const juce::String& filter)
+    {
+        int written = 0, failed = 0;
+
+        for (const auto& c : makeCases())
+        {
+            if (! matchesFilter (c.name, filter))
+                continue;
+
+            for (const auto sampleRate : sampleRates)
+            {
+                for (const auto s : allSignals)
+                {
+                    const auto file = goldenFile (dir, c, s, sampleRate);
+
+                    if (writeGolden (file, render<float> (c, s, sampleRate, recordBlockSize), sampleRate))
+                    {
+                        ++written;
+                    }
+                    else
+                    {
+                        std::cerr << "cannot write " << file.getFullPathName() << "\n";
+                        ++failed;
+                    }
+                }
+            }
+
+            std::cout << c.name << "\n";
+        }
+
+        std::cout << written << " goldens written to " << dir.getFullPathName() << "\n";
+        return failed == 0 ? 0 : 1;
+    }
+
+    int verify (const juce::File& dir, const juce::String& filter, const juce::File& jsonFile)
+    {
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+
+        juce::Array<juce::var> results;
+        int passed = 0, failed = 0, missing = 0;
+
+        std::cout << "case/signal                        rate  block    peak dB  residual dB   tol dB\n";
+
+        for (const auto& c : makeCases())
+        {
+            if (! matchesFilter (c.name, filter))
+                continue;
+
+            for (const auto sampleRate : sampleRates)
+            {
+                for (const auto s : allSignals)
+                {
+                    const auto label = c.name + "/" + signalName (s);
+                    juce::AudioBuffer<float> golden;
+
+                    if (! readGolden (formats, goldenFile (dir, c, s, sampleRate), sampleRate, golden))
+                    {
+                        std::cout << label.paddedRight (' ', 32) << juce::String ((int) sampleRate).paddedLeft (' ', 7)
+                                  << "  no golden\n";
+                        ++missing;
+                        continue;
+                    }
+
+                    for (const auto blockSize : blockSizes)
+                    {
+                        const auto t = nullTest (render<float> (c, s, sampleRate, blockSize), golden);
+                        const bool ok = t.passes (c.toleranceDb);
+
+                        std::cout << label.paddedRight (' ', 32)
+                                  << juce::String ((int) sampleRate).paddedLeft (' ', 7)
+                                  << juce::String (blockSize).paddedLeft (' ', 7)
+                                  << (t.lengthMatches ? formatDb (t.peakDb) : juce::String ("length")).paddedLeft (' ', 11)
+                                  << formatDb (t.residualDb).paddedLeft (' ', 13)
+                                  << juce::String (c.toleranceDb, 0).paddedLeft (' ', 9)
+                                  << (ok ? "  PASS" : "  FAIL");
+
+                        if (t.firstDifference >= 0)
+                            std::cout << "  (first difference at sample " << t.firstDifference << ")";
+
+                        std::cout << "\n";
+
+                        auto* r = new juce::DynamicObject();
+                        r->setProperty ("case", c.name);
+                        r->setProperty ("signal", signalName (s));
+                        r->setProperty ("sampleRate", sampleRate);
+                        r->setProperty ("blockSize", blockSize);
+                        r->setProperty ("lengthMatches", t.lengthMatches);
+                        r->setProperty ("peakDb", t.peakDb);
+                        r->setProperty ("residualDb", t.residualDb);
+                        r->setProperty ("toleranceDb", c.toleranceDb);
+                        r->setProperty ("firstDifference", t.firstDifference);
+                        r->setProperty ("passed", ok);
+                        results.add (juce::var (r));
+
+                        if (ok) ++passed;
+                        else    ++failed;
+                    }
+                }
+            }
+        }
+
+        std::cout << passed << " passed, " << failed << " failed, " << missing << " without a golden\n";
+
+        if (jsonFile != juce::File())
+        {
+            auto* root = new juce::DynamicObject();
+            root->setProperty ("version", 1);
+            root->setProperty ("results", results);
+
+            if (! jsonFile.replaceWithText (juce::JSON::toString (juce::var (root))))
+                std::cerr << "cannot write " << jsonFile.getFullPathName() << "\n";
+        }
+
+        return failed == 0 && missing == 0 ? 0 : 1;
+    }
+
+    // ===== Scalar references =====
+    // Straight per-sample versions of the optimized kernels: one ring per channel, modulo
+    // indexing, the LFO from std::sin. They share the engines' arithmetic (same
+    // interpolation, same feedback write), so the only differences left are the ones the
+    // optimizations introduce.
+    struct ScalarRing
+    {
+        double sampleRate = 44100.0;
+        float feedback = 0.0f;
+        std::vector<std::vector<float>> rings; // one per channel
+        size_t size = 0, writePos = 0;
+
+        void prepare (double rate, int numChannels, double maxDelayMs)
+        {
+            sampleRate = rate;
+            size = (size_t) std::ceil (maxDelayMs * 0.001 * sampleRate) + 2;
+            rings.assign ((size_t) numChannels, std::vector<float> (size, 0.0f));
+            writePos = 0;
+        }
+
+        // Reads `delay` samples back with linear interpolation and writes x + fb * delayed
+        float readAndWrite (size_t channel, float x, float delay)
+        {
+            auto& ring = rings[channel];
+            const auto whole = (size_t) delay;
+            const auto frac  = delay - (float) whole;
+            const auto newer = ring[(writePos + size - whole) % size];
+            const auto older = ring[(writePos + size - whole - 1) % size];
+            const auto delayed = newer + frac * (older - newer);
+
+            ring[writePos] = x + feedback * delayed;
+            return delayed;
+        }
+    };
+
+    // y = x + mix * d
+    struct ScalarFlanger  : ScalarRing
+    {
+        double rateHz = 0.35, phase = 0.0;
+        float depth = 0.6f;
+
+        void process (float* const* channels, int numChannels, int numSamples, float mix)
+        {
+            using Engine = FlangerEngine<float>;
+            const double msToSamples = 0.001 * sampleRate;
+            const double base  = Engine::minDelayMs * msToSamples;
+            const double swing = 0.5 * depth * (Engine::maxDelayMs - Engine::minDelayMs) * msToSamples;
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const auto d = (float) (base + swing * (1.0 + std::sin (phase)));
+                phase += juce::MathConstants<double>::twoPi * rateHz / sampleRate;
+
+                for (int ch = 0; ch < numChannels; ++ch)
+                    channels[ch][i] += mix * readAndWrite ((size_t) ch, channels[ch][i], d);
+
+                writePos = (writePos + 1) % size;
+            }
+        }
+    };
+
+    // y = x + mix * (d - x), at a fixed delay
+    struct ScalarDelay  : ScalarRing
+    {
+        float delaySamples = 1.0f;
+
+        void process (float* const* channels, int numChannels, int numSamples, float mix)
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                for (int ch = 0; ch < numChannels; ++ch)
+                {
+                    const auto x = channels[ch][i];
+                    channels[ch][i] = x + mix * (readAndWrite ((size_t) ch, x, delaySamples) - x);
+                }
+
+                writePos = (writePos + 1) % size;
+            }
+        }
+    };
+
+    struct ReferenceCheck
+    {
+        juce::String name;
+        double toleranceDb;
+        std::function<NullTest (double sampleRate, int blockSize)> run;
+    };
+
+    // Runs an engine and its reference block by block over the same noise.
+    template <typename EngineFn, typename ReferenceFn>
+    NullTest compareKernels (double sampleRate, int blockSize, EngineFn&& engine, ReferenceFn&& reference)
+    {
+        const int length = (int) (signalSeconds * sampleRate);
+        const auto input = makeSignal (Signal::noise, sampleRate, length);
+        auto optimized = input, scalar = input;
+
+        for (int pos = 0; pos < length; pos += blockSize)
+        {
+            const int n = juce::jmin (blockSize, length - pos);
+            juce::AudioBuffer<float> a (optimized.getArrayOfWritePointers(), 2, pos, n);
+            juce::AudioBuffer<float> b (scalar.getArrayOfWritePointers(), 2, pos, n);
+            engine (a);
+            reference (b);
+        }
+
+        return nullTest (optimized, scalar);
+    }
+
+    std::vector<ReferenceCheck> makeReferenceChecks()
+    {
+        std::vector<ReferenceCheck> checks;
+
+        // SIMD lanes against the engine's own per-channel scalar kernel
+        checks.push_back ({ "svf simd/scalar", -120.0, [] (double sampleRate, int blockSize)
+        {
+            SvfFilterEngine<float> simd, scalar;
+            const juce::dsp::ProcessSpec spec { sampleRate, (juce::uint32) blockSize, 2 };
+
+            for (auto* f : { &simd, &scalar })
+            {
+                f->prepare (spec);
+                f->setCutoffs (120.0f, 9000.0f);
+            }
+
+            scalar.setScalarReference (true);
+
+            auto run = [] (SvfFilterEngine<float>& f)
+            {
+                return [&f] (juce::AudioBuffer<float>& b)
+                {
+                    juce::dsp::AudioBlock<float> block (b);
+                    f.process (juce::dsp::ProcessContextReplacing<float> (block));
+                };
+            };
+
+            return compareKernels (sampleRate, blockSize, run (simd), run (scalar));
+        } });
+
+        // Quadrature LFO and interleaved ring against std::sin and one ring per channel. The
+        // float delay times differ by a few ulps of a swing of hundreds of samples, which on
+        // noise is around -80 dB; an indexing mistake would be near 0 dB.
+        checks.push_back ({ "flanger/scalar", -60.0, [] (double sampleRate, int blockSize)
+        {
+            FlangerEngine<float> engine;
+            engine.prepare ({ sampleRate, (juce::uint32) blockSize, 2 });
+            engine.setRate (2.0f);
+            engine.setDepth (0.8f);
+            engine.setFeedback (0.5f);
+
+            ScalarFlanger reference;
+            reference.prepare (sampleRate, 2, FlangerEngine<float>::maxDelayMs);
+            reference.rateHz = 2.0;
+            reference.depth = 0.8f;
+            reference.feedback = 0.5f;
+
+            return compareKernels (sampleRate, blockSize,
+                                   [&] (auto& b) { engine.process (b.getWritePointer (0), b.getWritePointer (1), b.getNumSamples(), 0.7f); },
+                                   [&] (auto& b) { reference.process (b.getArrayOfWritePointers(), 2, b.getNumSamples(), 0.7f); });
+        } });
+
+        // Chunked steady-state reads against per-sample fractional reads. A delay shorter
+        // than the block makes the engine split each block into several chunks.
+        for (const float ms : { 0.5f, 3.3f, 220.0f })
+        {
+            checks.push_back ({ "delay " + juce::String (ms) + " ms/scalar", -120.0, [ms] (double sampleRate, int blockSize)
+            {
+                DelayEngine<float> engine;
+                engine.prepare ({ sampleRate, (juce::uint32) blockSize, 2 });
+                engine.setDelayMs (ms);
+                engine.setFeedback (0.6f);
+
+                ScalarDelay reference;
+                reference.prepare (sampleRate, 2, DelayEngine<float>::maxDelayMs);
+                reference.delaySamples = (float) juce::jlimit (1.0, DelayEngine<float>::maxDelayMs * 0.001 * sampleRate, (double) ms * 0.001 * sampleRate);
+                reference.feedback = 0.6f;
+
+                return compareKernels (sampleRate, blockSize,
+                                       [&] (auto& b) { engine.process (b.getWritePointer (0), b.getWritePointer (1), b.getNumSamples(), 0.5f); },
+                                       [&] (auto& b) { reference.process (b.getArrayOfWritePointers(), 2, b.getNumSamples(), 0.5f); });
+            } });
+        }
+
+        // Whole chain, float against double (the FDN and the oversampler have no other
+        // reference)
+        for (const auto& c : makeCases())
+        {
+            checks.push_back ({ c.name + " float/double", -80.0, [c] (double sampleRate, int blockSize)
+            {
+                return nullTest (render<float> (c, Signal::noise, sampleRate, blockSize),
+                                 render<double> (c, Signal::noise, sampleRate, blockSize));
+            } });
+        }
+
+        return checks;
+    }
+
+    int checkReferences (const juce::String& filter)
+    {
+        int passed = 0, failed = 0;
+
+        std::cout << "check                              rate  block    peak dB  residual dB   tol dB\n";
+
+        for (const auto& check : makeReferenceChecks())
+        {
+            if (! matchesFilter (check.name, filter))
+                continue;
+
+            for (const auto sampleRate : sampleRates)
+            {
+                for (const auto blockSize : { 32, recordBlockSize })
+                {
+                    const auto t = check.run (sampleRate, blockSize);
+                    const bool ok = t.passes (check.toleranceDb);
+
+                    std::cout << check.name.paddedRight (' ', 32)
+                              << juce::String ((int) sampleRate).paddedLeft (' ', 7)
+                              << juce::String (blockSize).paddedLeft (' ', 7)
+                              << formatDb (t.peakDb).paddedLeft (' ', 11)
+                              << formatDb (t.residualDb).paddedLeft (' ', 13)
+                              << juce::String (check.toleranceDb, 0).paddedLeft (' ', 9)
+                              << (ok ? "  PASS\n" : "  FAIL\n");
+
+                    if (ok) ++passed;
+                    else    ++failed;
+                }
+            }
+        }
+
+        std::cout << passed << " passed, " << failed << " failed\n";
+        return failed == 0 ? 0 : 1;
+    }
+
+    int printUsage()
+    {
+        std::cerr << "usage: UltimateAdlibsGolden --record --dir=<dir> [--filter=<text>]\n"
+                     "       UltimateAdlibsGolden --verify --dir=<dir> [--filter=<text>] [--json=<file>]\n"
+                     "       UltimateAdlibsGolden --reference [--filter=<text>]\n";
+        return 1;
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args (argc, argv);
+
+    const bool recording = args.containsOption ("--record");
+    const bool verifying = args.containsOption ("--verify");
+    const bool references = args.containsOption ("--reference");
+
+    if ((int) recording + (int) verifying + (int) references != 1 || ((recording || verifying) && ! args.containsOption ("--dir")))
+        return printUsage();
+
+    juce::ScopedJuceInitialiser_GUI juceInit;
+
+    const auto cwd = juce::File::getCurrentWorkingDirectory();
+    const auto filter = args.getValueForOption ("--filter");
+
+    if (references)
+        return checkReferences (filter);
+
+    const auto dir = cwd.getChildFile (args.getValueForOption ("--dir"));
+
+    if (recording)
+        return record (dir, filter);
+
+    return verify (dir, filter, args.containsOption ("--json") ? cwd.getChildFile (args.getValueForOption ("--json")) : juce::File());
+}
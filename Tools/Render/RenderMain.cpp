@@ -0,0 +1,403 @@
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include <map>
+#include <vector>
+
+// Headless offline renderer: runs the plugin chain over audio files with isNonRealtime
+// semantics, one processor instance per worker thread. Files are streamed through in
+// blocks, never loaded whole.
+//
+//   UltimateAdlibsRender --out=<dir> [--state=<file>] [--threads=<n>] [--block=<samples>]
+//                        [--format=wav|flac] [--no-tail] [--double] [--profile] <files or folders...>
+//
+// Files found under a folder keep their path below it in the output directory, so stems
+// with the same name in different song folders don't collide.
+//
+// --threads (default: one per CPU) is the whole budget: when fewer files than threads
+// are rendered, the spare threads run each file's channel groups in parallel.
+//
+// --state takes either a raw plugin state blob (as saved by a host) or the XML of the
+// parameter tree. --double runs the chain in double precision, as a host would that
+// asks for it. --profile prints the processor's per-stage DSP load for each file.
+
+namespace
+{
+    struct RenderSettings
+    {
+        juce::File outputDir;
+        juce::MemoryBlock state; // empty: plugin defaults
+        int blockSize = 1024;
+        bool renderTail = true;
+        bool flac = false;
+        bool doublePrecision = false;
+        bool profile = false;
+    };
+
+    struct RenderJob
+    {
+        juce::File input;
+        juce::String outputName; // relative to --out, without extension
+    };
+
+    struct RenderResult
+    {
+        bool ok = false;
+        juce::String error;
+        double audioSeconds = 0.0;
+        double wallSeconds = 0.0;
+        DspLoadSnapshot load;
+    };
+
+    // Streams the file through processBlock. Files are read and written as float, so in
+    // double precision each block is converted on the way in and out of the processor.
+    template <typename SampleType>
+    void renderBlocks (UltimateAdlibsAudioProcessor& processor, juce::AudioFormatReader& reader, juce::AudioFormatWriter& writer,
+                       int numChannels, int blockSize, juce::int64 totalLength, juce::int64 latency)
+    {
+        juce::AudioBuffer<float> buffer (numChannels, blockSize);
+        juce::AudioBuffer<SampleType> converted;
+        juce::MidiBuffer midi;
+
+        for (juce::int64 pos = 0; pos < totalLength; pos += blockSize)
+        {
+            const int n = (int) juce::jmin ((juce::int64) blockSize, totalLength - pos);
+            buffer.setSize (numChannels, n, false, false, true);
+
+            // Past the end of the file the reader fills with silence, which renders the tail
+            reader.read (&buffer, 0, n, pos, true, numChannels > 1);
+
+            if constexpr (std::is_same_v<SampleType, float>)
+            {
+                processor.processBlock (buffer, midi);
+            }
+            else
+            {
+                converted.makeCopyOf (buffer, true);
+                processor.processBlock (converted, midi);
+                buffer.makeCopyOf (converted, true);
+            }
+
+            // Drop the first `latency` output samples so the render lines up with the source
+            const int skip = (int) juce::jlimit ((juce::int64) 0, (juce::int64) n, latency - pos);
+            if (skip < n)
+                writer.writeFromAudioSampleBuffer (buffer, skip, n - skip);
+        }
+    }
+
+    RenderResult renderFile (UltimateAdlibsAudioProcessor& processor, juce::AudioFormatManager& formats,
+                             const RenderJob& job, const RenderSettings& settings)
+    {
+        RenderResult result;
+        const double startMs = juce::Time::getMillisecondCounterHiRes();
+
+        std::unique_ptr<juce::AudioFormatReader> reader (formats.createReaderFor (job.input));
+        if (reader == nullptr)
+        {
+            result.error = "unsupported or unreadable file";
+            return result;
+        }
+
+        const int numChannels = (int) reader->numChannels;
+        const double sampleRate = reader->sampleRate;
+
+        if (numChannels < 1 || numChannels > UltimateAdlibsAudioProcessor::maxBusChannels)
+        {
+            result.error = "files with more than " + juce::String (UltimateAdlibsAudioProcessor::maxBusChannels) + " channels are not supported";
+            return result;
+        }
+
+        // Multichannel files keep their speaker layout (5.1, 7.1.4...) when the file has one
+        const auto fileLayout = reader->getChannelLayout();
+        const auto channelSet = numChannels == 1 ? juce::AudioChannelSet::mono()
+                              : numChannels == 2 ? juce::AudioChannelSet::stereo()
+                              : fileLayout.size() == numChannels ? fileLayout
+                                                                 : juce::AudioChannelSet::discreteChannels (numChannels);
+        juce::AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add (channelSet);
+        layout.outputBuses.add (channelSet);
+
+        processor.releaseResources();
+
+        if (! processor.setBusesLayout (layout))
+        {
+            result.error = "channel layout rejected by the processor";
+            return result;
+        }
+
+        processor.setNonRealtime (true);
+
+        if (settings.state.getSize() > 0)
+            processor.setStateInformation (settings.state.getData(), (int) settings.state.getSize());
+
+        processor.setProcessingPrecision (settings.doublePrecision ? juce::AudioProcessor::doublePrecision
+                                                                   : juce::AudioProcessor::singlePrecision);
+        processor.setRateAndBufferSizeDetails (sampleRate, settings.blockSize);
+        processor.prepareToPlay (sampleRate, settings.blockSize);
+
+        const auto outFile = settings.outputDir.getChildFile (job.outputName + (settings.flac ? ".flac" : ".wav"));
+        outFile.deleteFile();
+
+        if (! outFile.getParentDirectory().createDirectory())
+        {
+            result.error = "cannot create " + outFile.getParentDirectory().getFullPathName();
+            return result;
+        }
+
+        std::unique_ptr<juce::AudioFormat> format;
+        if (settings.flac) format = std::make_unique<juce::FlacAudioFormat>();
+        else               format = std::make_unique<juce::WavAudioFormat>();
+
+        std::unique_ptr<juce::OutputStream> stream (outFile.createOutputStream());
+        if (stream == nullptr)
+        {
+            result.error = "cannot create " + outFile.getFullPathName();
+            return result;
+        }
+
+        std::unique_ptr<juce::AudioFormatWriter> writer (format->createWriterFor (stream.get(), sampleRate,
+                                                                                 (unsigned int) numChannels, 24, {}, 0));
+        if (writer == nullptr)
+        {
+            result.error = "cannot create a writer for " + outFile.getFullPathName();
+            return result;
+        }
+
+        stream.release(); // owned by the writer now
+
+        const auto inputLength = reader->lengthInSamples;
+        const auto tailLength  = settings.renderTail ? (juce::int64) std::ceil (processor.getTailLengthSeconds() * sampleRate) : 0;
+        const auto latency     = (juce::int64) processor.getLatencySamples();
+        const auto totalLength = inputLength + tailLength + latency;
+
+        if (settings.doublePrecision)
+            renderBlocks<double> (processor, *reader, *writer, numChannels, settings.blockSize, totalLength, latency);
+        else
+            renderBlocks<float> (processor, *reader, *writer, numChannels, settings.blockSize, totalLength, latency);
+
+        writer.reset();
+        result.load = processor.getDspLoad();
+        processor.releaseResources();
+
+        result.ok = true;
+        result.audioSeconds = (double) inputLength / sampleRate;
+        result.wallSeconds = (juce::Time::getMillisecondCounterHiRes() - startMs) / 1000.0;
+        return result;
+    }
+
+    // ===== Workers =====
+    // Each worker owns one processor and pulls the next file index until the list runs out.
+    class RenderWorker : public juce::Thread
+    {
+    public:
+        RenderWorker (int index, const std::vector<RenderJob>& jobsToRender, std::atomic<int>& nextFileIndex,
+                      const RenderSettings& renderSettings, std::vector<RenderResult>& resultSlots, juce::CriticalSection& outputLock)
+            : juce::Thread ("Render worker " + juce::String (index)),
+              jobs (jobsToRender), next (nextFileIndex), settings (renderSettings),
+              results (resultSlots), printLock (outputLock)
+        {
+        }
+
+        double getBusySeconds() const noexcept { return busySeconds; }
+
+        void setMaxGroupWorkers (int numWorkers) { processor.setMaxGroupWorkers (numWorkers); }
+
+        void run() override
+        {
+            juce::AudioFormatManager formats;
+            formats.registerBasicFormats();
+
+            for (;;)
+            {
+                const int i = next.fetch_add (1);
+                if (i >= (int) jobs.size() || threadShouldExit())
+                    break;
+
+                const auto& job = jobs[(size_t) i];
+                const auto result = renderFile (processor, formats, job, settings);
+                results[(size_t) i] = result;
+                busySeconds += result.wallSeconds;
+
+                const juce::ScopedLock sl (printLock);
+
+                if (result.ok)
+                    std::cout << job.outputName << ": " << juce::String (result.audioSeconds, 2) << " s in "
+                              << juce::String (result.wallSeconds, 2) << " s ("
+                              << juce::String (result.audioSeconds / juce::jmax (1.0e-9, result.wallSeconds), 1) << "x realtime)\n";
+                else
+                    std::cerr << job.outputName << ": " << result.error << "\n";
+
+                if (result.ok && settings.profile)
+                    printLoad (result.load);
+            }
+        }
+
+    private:
+        static void printLoad (const DspLoadSnapshot& load)
+        {
+            std::cout << "  block   " << juce::String (load.nsPerSample (load.block), 2) << " ns/sample\n";
+
+            for (int s = 0; s < numStages; ++s)
+                if (load.stages[(size_t) s].totalTicks > 0)
+                    std::cout << "  " << juce::String (stageName ((StageId) s)).paddedRight (' ', 8)
+                              << juce::String (load.nsPerSample (load.stages[(size_t) s]), 2) << " ns/sample\n";
+        }
+
+        UltimateAdlibsAudioProcessor processor;
+        const std::vector<RenderJob>& jobs;
+        std::atomic<int>& next;
+        const RenderSettings& settings;
+        std::vector<RenderResult>& results;
+        juce::CriticalSection& printLock;
+        double busySeconds = 0.0;
+    };
+
+    // A file named on the command line renders to its own name; one found in a folder to
+    // its path below that folder. Two inputs that would write the same output are an error.
+    bool collectJobs (const juce::ArgumentList& args, std::vector<RenderJob>& jobs)
+    {
+        auto addJob = [&jobs] (const juce::File& input, const juce::String& relativePath)
+        {
+            jobs.push_back ({ input, relativePath.upToLastOccurrenceOf (".", false, false) });
+        };
+
+        for (const auto& arg : args.arguments)
+        {
+            if (arg.isOption())
+                continue;
+
+            const auto f = arg.resolveAsFile();
+
+            if (f.isDirectory())
+                for (const auto& child : f.findChildFiles (juce::File::findFiles, true, "*.wav;*.flac"))
+                    addJob (child, child.getRelativePathFrom (f));
+            else if (f.existsAsFile())
+                addJob (f, f.getFileName());
+            else
+                std::cerr << "skipping " << arg.text << ": not found\n";
+        }
+
+        std::map<juce::String, juce::File> byOutput;
+
+        for (const auto& job : jobs)
+        {
+            const auto [it, added] = byOutput.emplace (job.outputName.toLowerCase(), job.input);
+
+            if (! added)
+            {
+                std::cerr << job.input.getFullPathName() << " and " << it->second.getFullPathName()
+                          << " would both render to " << job.outputName << "\n";
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool loadState (const juce::File& file, juce::MemoryBlock& dest)
+    {
+        if (file.hasFileExtension ("xml"))
+        {
+            const auto xml = juce::parseXML (file);
+            if (xml == nullptr)
+                return false;
+
+            juce::AudioProcessor::copyXmlToBinary (*xml, dest);
+            return true;
+        }
+
+        return file.loadFileAsData (dest);
+    }
+
+    int printUsage()
+    {
+        std::cerr << "usage: UltimateAdlibsRender --out=<dir> [--state=<file>] [--threads=<n>] [--block=<samples>]\n"
+                     "                            [--format=wav|flac] [--no-tail] [--double] [--profile] <files or folders...>\n";
+        return 1;
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args (argc, argv);
+
+    if (! args.containsOption ("--out"))
+        return printUsage();
+
+    juce::ScopedJuceInitialiser_GUI juceInit;
+
+    RenderSettings settings;
+    settings.outputDir       = juce::File::getCurrentWorkingDirectory().getChildFile (args.getValueForOption ("--out"));
+    settings.blockSize       = args.containsOption ("--block") ? args.getValueForOption ("--block").getIntValue() : settings.blockSize;
+    settings.renderTail      = ! args.containsOption ("--no-tail");
+    settings.flac            = args.getValueForOption ("--format").equalsIgnoreCase ("flac");
+    settings.doublePrecision = args.containsOption ("--double");
+    settings.profile         = args.containsOption ("--profile");
+
+    const int numThreads = args.containsOption ("--threads") ? args.getValueForOption ("--threads").getIntValue()
+                                                             : juce::SystemStats::getNumCpus();
+
+    if (settings.blockSize <= 0 || numThreads <= 0)
+        return printUsage();
+
+    if (args.containsOption ("--state") && ! loadState (args.getFileForOption ("--state"), settings.state))
+    {
+        std::cerr << "cannot read state from " << args.getValueForOption ("--state") << "\n";
+        return 1;
+    }
+
+    if (! settings.outputDir.createDirectory())
+    {
+        std::cerr << "cannot create " << settings.outputDir.getFullPathName() << "\n";
+        return 1;
+    }
+
+    std::vector<RenderJob> jobs;
+    if (! collectJobs (args, jobs))
+        return 1;
+
+    if (jobs.empty())
+        return printUsage();
+
+    std::vector<RenderResult> results (jobs.size());
+    std::atomic<int> nextFileIndex { 0 };
+    juce::CriticalSection printLock;
+
+    // Processors are built here, on the message thread, before any worker starts
+    std::vector<std::unique_ptr<RenderWorker>> workers;
+    for (int i = 0; i < juce::jmin (numThreads, (int) jobs.size()); ++i)
+        workers.push_back (std::make_unique<RenderWorker> (i, jobs, nextFileIndex, settings, results, printLock));
+
+    // Files rendered side by side share the threads: each processor gets what's left over
+    // for its channel group workers, so a full batch runs its groups serially.
+    const int groupWorkers = juce::jmax (0, numThreads / (int) workers.size() - 1);
+
+    for (auto& w : workers)
+        w->setMaxGroupWorkers (groupWorkers);
+
+    const double startMs = juce::Time::getMillisecondCounterHiRes();
+
+    for (auto& w : workers) w->startThread();
+    for (auto& w : workers) w->waitForThreadToExit (-1);
+
+    const double elapsed = (juce::Time::getMillisecondCounterHiRes() - startMs) / 1000.0;
+
+    double audioSeconds = 0.0, busySeconds = 0.0;
+    int failures = 0;
+
+    for (const auto& r : results)
+    {
+        audioSeconds += r.audioSeconds;
+        failures += r.ok ? 0 : 1;
+    }
+
+    for (const auto& w : workers)
+        busySeconds += w->getBusySeconds();
+
+    std::cout << "\n" << ((int) jobs.size() - failures) << "/" << (int) jobs.size() << " files, "
+              << juce::String (audioSeconds, 1) << " s of audio in " << juce::String (elapsed, 2) << " s on "
+              << (int) workers.size() << " workers\n"
+              << "throughput: " << juce::String (audioSeconds / juce::jmax (1.0e-9, elapsed), 1) << "x realtime, "
+              << juce::String (audioSeconds / juce::jmax (1.0e-9, busySeconds), 1) << "x realtime per core\n";
+
+    return failures == 0 ? 0 : 2;
+}